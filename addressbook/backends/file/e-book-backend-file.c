@@ -63,6 +63,9 @@
 #define SQLITEDB_FOLDER_ID   "folder_id"
 #define SQLITE_REVISION_KEY  "revision"
 
+/* How many contacts a book view reads from the database at a time */
+#define BOOK_VIEW_CHUNK_SIZE 100
+
 /* Forward Declarations */
 static void	e_book_backend_file_initable_init
 						(GInitableIface *iface);
@@ -951,6 +954,98 @@ uid_rev_fields (GHashTable *fields_of_interest)
 	return TRUE;
 }
 
+static gboolean
+book_view_collect_search_data_cb (EbSqlSearchData *data,
+                                  gpointer user_data)
+{
+	GPtrArray *chunk = user_data;
+
+	/* Take over the strings, the search data is freed on return */
+	g_ptr_array_add (chunk, data->uid);
+	g_ptr_array_add (chunk, data->vcard);
+	data->uid = NULL;
+	data->vcard = NULL;
+
+	return TRUE;
+}
+
+/* Reads the contacts of one chunk of @uids, which matched @query when
+ * they were listed, and which still do so; the locks are held only
+ * while reading, the view is notified after they are released */
+static gboolean
+book_view_notify_chunk (EBookBackendFile *bf,
+                        EDataBookView *book_view,
+                        const gchar *query,
+                        GSList **uids,
+                        gboolean meta_contact,
+                        gchar **attributes,
+                        GError **error)
+{
+	EBookQuery *uid_queries[BOOK_VIEW_CHUNK_SIZE], *uid_query;
+	GPtrArray *chunk;
+	gchar *uid_sexp, *chunk_sexp;
+	gboolean success;
+	guint ii, n_uids = 0;
+
+	while (*uids != NULL && n_uids < BOOK_VIEW_CHUNK_SIZE) {
+		gchar *uid = (*uids)->data;
+
+		uid_queries[n_uids++] = e_book_query_field_test (
+			E_CONTACT_UID, E_BOOK_QUERY_IS, uid);
+
+		*uids = g_slist_delete_link (*uids, *uids);
+		g_free (uid);
+	}
+
+	uid_query = e_book_query_or (n_uids, uid_queries, TRUE);
+	uid_sexp = e_book_query_to_string (uid_query);
+	e_book_query_unref (uid_query);
+
+	/* The contact may have changed since its UID was read */
+	if (query != NULL && *query != '\0') {
+		chunk_sexp = g_strdup_printf ("(and %s %s)", query, uid_sexp);
+		g_free (uid_sexp);
+	} else {
+		chunk_sexp = uid_sexp;
+	}
+
+	chunk = g_ptr_array_new_with_free_func (g_free);
+
+	g_rw_lock_reader_lock (&(bf->priv->lock));
+	/* UID and REV come straight from the summary, other fields
+	 * of interest from the stored pre-parsed contacts */
+	if (meta_contact || attributes == NULL)
+		success = e_book_sqlite_search_foreach (
+			bf->priv->sqlitedb,
+			chunk_sexp,
+			meta_contact,
+			book_view_collect_search_data_cb,
+			chunk,
+			NULL, /* GCancellable */
+			error);
+	else
+		success = e_book_sqlite_search_foreach_projected (
+			bf->priv->sqlitedb,
+			chunk_sexp,
+			(const gchar * const *) attributes,
+			book_view_collect_search_data_cb,
+			chunk,
+			NULL, /* GCancellable */
+			error);
+	g_rw_lock_reader_unlock (&(bf->priv->lock));
+
+	g_free (chunk_sexp);
+
+	for (ii = 0; success && ii + 1 < chunk->len; ii += 2)
+		notify_update_vcard (
+			book_view, TRUE,
+			chunk->pdata[ii], chunk->pdata[ii + 1]);
+
+	g_ptr_array_unref (chunk);
+
+	return success;
+}
+
 static gpointer
 book_view_thread (gpointer data)
 {
@@ -959,8 +1054,9 @@ book_view_thread (gpointer data)
 	EBookBackendFile *bf;
 	EBookBackendSExp *sexp;
 	const gchar *query;
-	GSList *summary_list = NULL, *l;
 	GHashTable *fields_of_interest;
+	GSList *uids = NULL;
+	gchar **attributes;
 	GError *local_error = NULL;
 	gboolean meta_contact, success;
 
@@ -985,6 +1081,7 @@ book_view_thread (gpointer data)
 
 	fields_of_interest = e_data_book_view_get_fields_of_interest (book_view);
 	meta_contact = uid_rev_fields (fields_of_interest);
+	attributes = e_data_book_view_dup_attributes_of_interest (book_view);
 
 	if (query && !strcmp (query, "(contains \"x-evolution-any-field\" \"\")")) {
 		e_data_book_view_notify_progress (book_view, -1, _("Loading..."));
@@ -995,16 +1092,27 @@ book_view_thread (gpointer data)
 	d (printf ("signalling parent thread\n"));
 	e_flag_set (closure->running);
 
+	/* Only the UIDs are listed at once, the contacts are read in
+	 * chunks so that writers and other views do not wait for the
+	 * whole view to be populated; contacts added or changed in the
+	 * meantime reach the view through the usual notifications. */
 	g_rw_lock_reader_lock (&(bf->priv->lock));
-	success = e_book_sqlite_search (
+	success = e_book_sqlite_search_uids (
 		bf->priv->sqlitedb,
 		query,
-		meta_contact,
-		&summary_list,
+		&uids,
 		NULL, /* GCancellable */
 		&local_error);
 	g_rw_lock_reader_unlock (&(bf->priv->lock));
 
+	while (success && uids != NULL && e_flag_is_set (closure->running))
+		success = book_view_notify_chunk (
+			bf, book_view, query, &uids,
+			meta_contact, attributes, &local_error);
+
+	g_slist_free_full (uids, g_free);
+	g_strfreev (attributes);
+
 	if (!success) {
 		g_warning (G_STRLOC ": Failed to query initial contacts: %s", local_error->message);
 		g_error_free (local_error);
@@ -1019,20 +1127,6 @@ book_view_thread (gpointer data)
 		return NULL;
 	}
 
-	for (l = summary_list; l; l = l->next) {
-		EbSqlSearchData *data = l->data;
-		gchar *vcard = NULL;
-
-		vcard = data->vcard;
-		data->vcard = NULL;
-
-		notify_update_vcard (book_view, TRUE, data->uid, vcard);
-		g_free (vcard);
-	}
-
-	g_slist_foreach (summary_list, (GFunc) e_book_sqlite_search_data_free, NULL);
-	g_slist_free (summary_list);
-
 	if (e_flag_is_set (closure->running))
 		e_data_book_view_notify_complete (book_view, NULL /* Success */);
 
@@ -1566,6 +1660,17 @@ book_backend_file_get_contact_sync (EBookBackend *backend,
 	return contact;
 }
 
+static gboolean
+collect_contacts_cb (EbSqlSearchData *data,
+                     gpointer user_data)
+{
+	GQueue *contacts = user_data;
+
+	g_queue_push_tail (contacts, e_contact_new_from_vcard (data->vcard));
+
+	return TRUE;
+}
+
 static gboolean
 book_backend_file_get_contact_list_sync (EBookBackend *backend,
                                          const gchar *query,
@@ -1574,8 +1679,7 @@ book_backend_file_get_contact_list_sync (EBookBackend *backend,
                                          GError **error)
 {
 	EBookBackendFile *bf = E_BOOK_BACKEND_FILE (backend);
-	GSList *summary_list = NULL;
-	GSList *link;
+	GQueue contacts = G_QUEUE_INIT;
 	gboolean success = TRUE;
 	GError *local_error = NULL;
 
@@ -1592,11 +1696,17 @@ book_backend_file_get_contact_list_sync (EBookBackend *backend,
 		return FALSE;
 	}
 
-	success = e_book_sqlite_search (
+	/* Parse each vCard as it arrives rather than holding
+	 * all the vCard strings and all the contacts at once.
+	 * The result is still a complete list of contacts, as
+	 * the method returns it; use a book view or a cursor
+	 * to go through large books with bounded memory. */
+	success = e_book_sqlite_search_foreach (
 		bf->priv->sqlitedb,
 		query,
 		FALSE,
-		&summary_list,
+		collect_contacts_cb,
+		&contacts,
 		cancellable,
 		&local_error);
 
@@ -1608,8 +1718,8 @@ book_backend_file_get_contact_list_sync (EBookBackend *backend,
 	g_rw_lock_reader_unlock (&(bf->priv->lock));
 
 	if (!success) {
-
-		g_warn_if_fail (summary_list == NULL);
+		g_queue_free_full (&contacts, g_object_unref);
+		g_queue_init (&contacts);
 
 		if (g_error_matches (local_error,
 				     E_BOOK_SQLITE_ERROR,
@@ -1635,17 +1745,7 @@ book_backend_file_get_contact_list_sync (EBookBackend *backend,
 		}
 	}
 
-	for (link = summary_list; link != NULL; link = g_slist_next (link)) {
-		EbSqlSearchData *data = link->data;
-		EContact *contact;
-
-		contact = e_contact_new_from_vcard (data->vcard);
-		g_queue_push_tail (out_contacts, contact);
-	}
-
-	g_slist_free_full (
-		summary_list, (GDestroyNotify)
-		e_book_sqlite_search_data_free);
+	e_queue_transfer (&contacts, out_contacts);
 
 	return success;
 }
@@ -2102,6 +2202,11 @@ book_backend_file_initable_init (GInitable *initable,
 		}
 	}
 
+	/* Pre-parsed contacts are opt-in, they double the size of the book */
+	e_book_sqlite_set_store_bvcards (
+		priv->sqlitedb,
+		e_source_backend_summary_setup_get_store_binary_vcards (setup_extension));
+
 	/* Load the locale */
 	e_book_backend_file_load_locale (E_BOOK_BACKEND_FILE (initable));
 
@@ -47,6 +47,10 @@ G_BEGIN_DECLS
  *   If this flag is set then all contacts matching the view's query will
  *   be sent as notifications when starting the view, otherwise only future
  *   changes will be reported.  The default for a #EBookClientView is %TRUE.
+ * @E_BOOK_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT:
+ *   If this flag is set then change notifications are held back for up to
+ *   a few seconds and sent in large batches.  Otherwise they are sent soon
+ *   after they stop coming, which suits interactive clients.  Since: 3.20
  *
  * Flags that control the behaviour of an #EBookClientView.
  *
@@ -55,6 +59,7 @@ G_BEGIN_DECLS
 typedef enum {
 	E_BOOK_CLIENT_VIEW_FLAGS_NONE = 0,
 	E_BOOK_CLIENT_VIEW_FLAGS_NOTIFY_INITIAL = (1 << 0),
+	E_BOOK_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT = (1 << 1)
 } EBookClientViewFlags;
 
 /**
@@ -149,6 +154,8 @@ typedef enum {
  * stored in this index. The number "+9999999" for instance won't be stored because
  * the country calling code "+999" currently is not assigned.</para></note>
  * @E_BOOK_INDEX_SORT_KEY: Indicates that a given #EContactField should be usable as a sort key.
+ * @E_BOOK_INDEX_TRIGRAM: An index of three character substrings, suitable for searching
+ * contacts with a substring pattern. Since: 3.20
  *
  * The type of index defined by e_source_backend_summary_setup_set_indexed_fields()
  */
@@ -156,7 +163,8 @@ typedef enum {
 	E_BOOK_INDEX_PREFIX = 0,
 	E_BOOK_INDEX_SUFFIX,
 	E_BOOK_INDEX_PHONE,
-	E_BOOK_INDEX_SORT_KEY
+	E_BOOK_INDEX_SORT_KEY,
+	E_BOOK_INDEX_TRIGRAM
 } EBookIndexType;
 
 /**
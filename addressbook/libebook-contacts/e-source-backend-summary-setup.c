@@ -56,12 +56,14 @@ struct _ESourceBackendSummarySetupPrivate {
 	GMutex  property_lock;
 	gchar  *summary_fields;
 	gchar  *indexed_fields;
+	gboolean store_binary_vcards;
 };
 
 enum {
 	PROP_0,
 	PROP_SUMMARY_FIELDS,
-	PROP_INDEXED_FIELDS
+	PROP_INDEXED_FIELDS,
+	PROP_STORE_BINARY_VCARDS
 };
 
 G_DEFINE_TYPE (
@@ -144,6 +146,12 @@ source_backend_summary_setup_set_property (GObject *object,
 				E_SOURCE_BACKEND_SUMMARY_SETUP (object),
 				g_value_get_string (value), property_id);
 			return;
+
+		case PROP_STORE_BINARY_VCARDS:
+			e_source_backend_summary_setup_set_store_binary_vcards (
+				E_SOURCE_BACKEND_SUMMARY_SETUP (object),
+				g_value_get_boolean (value));
+			return;
 	}
 
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -164,6 +172,13 @@ source_backend_summary_setup_get_property (GObject *object,
 				E_SOURCE_BACKEND_SUMMARY_SETUP (object),
 				property_id));
 			return;
+
+		case PROP_STORE_BINARY_VCARDS:
+			g_value_set_boolean (
+				value,
+				e_source_backend_summary_setup_get_store_binary_vcards (
+				E_SOURCE_BACKEND_SUMMARY_SETUP (object)));
+			return;
 	}
 
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -228,6 +243,20 @@ e_source_backend_summary_setup_class_init (ESourceBackendSummarySetupClass *clas
 			G_PARAM_CONSTRUCT |
 			G_PARAM_STATIC_STRINGS |
 			E_SOURCE_PARAM_SETTING));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_STORE_BINARY_VCARDS,
+		g_param_spec_boolean (
+			"store-binary-vcards",
+			"Store Binary vCards",
+			"Whether contacts are also stored in a "
+			"pre-parsed form in the underlying database",
+			FALSE,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS |
+			E_SOURCE_PARAM_SETTING));
 }
 
 static void
@@ -538,7 +567,9 @@ e_source_backend_summary_setup_get_indexed_fields (ESourceBackendSummarySetup *e
  * be used for #E_BOOK_QUERY_BEGINS_WITH queries. A #E_BOOK_INDEX_SUFFIX index
  * will be constructed efficiently for suffix matching and will be used for
  * #E_BOOK_QUERY_ENDS_WITH queries. Similar a #E_BOOK_INDEX_PHONE index will optimize
- * #E_BOOK_QUERY_EQUALS_PHONE_NUMBER searches.
+ * #E_BOOK_QUERY_EQUALS_PHONE_NUMBER searches, and a #E_BOOK_INDEX_TRIGRAM index
+ * narrows down #E_BOOK_QUERY_CONTAINS and #E_BOOK_QUERY_ENDS_WITH searches before
+ * any string comparison is made.
  *
  * <note><para>The specified indexed fields must also be a part of the summary, any indexed fields
  * specified that are not already a part of the summary will be ignored.</para></note>
@@ -672,3 +703,53 @@ e_source_backend_summary_setup_set_indexed_fields (ESourceBackendSummarySetup *e
 
 	g_string_free (string, TRUE);
 }
+
+/**
+ * e_source_backend_summary_setup_get_store_binary_vcards:
+ * @extension: An #ESourceBackendSummarySetup
+ *
+ * Returns whether the addressbook also stores its contacts in a
+ * pre-parsed binary form, see
+ * e_source_backend_summary_setup_set_store_binary_vcards().
+ *
+ * Returns: Whether binary vCards are stored
+ *
+ * Since: 3.20
+ */
+gboolean
+e_source_backend_summary_setup_get_store_binary_vcards (ESourceBackendSummarySetup *extension)
+{
+	g_return_val_if_fail (E_IS_SOURCE_BACKEND_SUMMARY_SETUP (extension), FALSE);
+
+	return extension->priv->store_binary_vcards;
+}
+
+/**
+ * e_source_backend_summary_setup_set_store_binary_vcards:
+ * @extension: An #ESourceBackendSummarySetup
+ * @store_binary_vcards: Whether to also store contacts in binary form
+ *
+ * Sets whether the addressbook stores its contacts in a pre-parsed binary
+ * form next to their vCards.  Reading contacts then skips parsing the
+ * vCards, and book views which ask for only a few fields decode only those;
+ * in exchange every contact takes about twice the space.  This pays off
+ * for large books which are read much more often than they are written.
+ *
+ * Unlike the summary fields, this can be changed at any time; it applies
+ * to the contacts written after the addressbook is next opened.
+ *
+ * Since: 3.20
+ */
+void
+e_source_backend_summary_setup_set_store_binary_vcards (ESourceBackendSummarySetup *extension,
+                                                        gboolean store_binary_vcards)
+{
+	g_return_if_fail (E_IS_SOURCE_BACKEND_SUMMARY_SETUP (extension));
+
+	if (extension->priv->store_binary_vcards == store_binary_vcards)
+		return;
+
+	extension->priv->store_binary_vcards = store_binary_vcards;
+
+	g_object_notify (G_OBJECT (extension), "store-binary-vcards");
+}
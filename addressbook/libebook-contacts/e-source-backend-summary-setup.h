@@ -102,6 +102,12 @@ void            e_source_backend_summary_setup_set_indexed_fieldsv (ESourceBacke
 void            e_source_backend_summary_setup_set_indexed_fields  (ESourceBackendSummarySetup *extension,
 								    ...);
 
+gboolean        e_source_backend_summary_setup_get_store_binary_vcards
+								   (ESourceBackendSummarySetup *extension);
+void            e_source_backend_summary_setup_set_store_binary_vcards
+								   (ESourceBackendSummarySetup *extension,
+								    gboolean                    store_binary_vcards);
+
 G_END_DECLS
 
 #endif /* E_SOURCE_BACKEND_SUMMARY_SETUP_H */
@@ -326,6 +326,17 @@ read_attribute_value (EVCardAttribute *attr,
 {
 	gchar *lp = *p;
 	GString *str;
+	const gchar *stop_chars;
+	gboolean is_categories;
+
+	is_categories = !g_ascii_strcasecmp (attr->name, "CATEGORIES");
+
+	/* Only these characters need a closer look, runs of
+	 * anything else are copied over in one go */
+	if (quoted_printable)
+		stop_chars = is_categories ? "\r\n\\;,=" : "\r\n\\;=";
+	else
+		stop_chars = is_categories ? "\r\n\\;," : "\r\n\\;";
 
 	/* read in the value */
 	str = g_string_new ("");
@@ -396,8 +407,7 @@ read_attribute_value (EVCardAttribute *attr,
 			}
 			lp = g_utf8_next_char (lp);
 		}
-		else if ((*lp == ';') ||
-			 (*lp == ',' && !g_ascii_strcasecmp (attr->name, "CATEGORIES"))) {
+		else if ((*lp == ';') || (*lp == ',' && is_categories)) {
 			if (charset) {
 				gchar *tmp;
 
@@ -409,12 +419,17 @@ read_attribute_value (EVCardAttribute *attr,
 			}
 
 			e_vcard_attribute_add_value (attr, str->str);
-			g_string_assign (str, "");
+			g_string_truncate (str, 0);
 			lp = g_utf8_next_char (lp);
 		}
 		else {
-			g_string_append_unichar (str, g_utf8_get_char (lp));
-			lp = g_utf8_next_char (lp);
+			/* The input is valid UTF-8 and all of the stop
+			 * characters are ASCII, so this never splits
+			 * a multibyte character */
+			gsize run = strcspn (lp, stop_chars);
+
+			g_string_append_len (str, lp, run);
+			lp += run;
 		}
 	}
 	if (str) {
@@ -752,18 +767,23 @@ parse (EVCard *evc,
        const gchar *str,
        gboolean ignore_uid)
 {
-	gchar *buf;
+	gchar *buf = NULL;
 	gchar *p;
 	EVCardAttribute *attr;
 
-	buf = make_valid_utf8 (str);
+	/* The parser only reads from the buffer, so
+	 * valid input doesn't need to be copied */
+	if (g_utf8_validate (str, -1, NULL)) {
+		p = (gchar *) str;
+	} else {
+		buf = make_valid_utf8 (str);
+		p = buf;
+	}
 
 	d (printf ("BEFORE FOLDING:\n"));
 	d (printf (str));
 	d (printf ("\n\nAFTER FOLDING:\n"));
-	d (printf (buf));
-
-	p = buf;
+	d (printf (p));
 
 	attr = read_attribute (&p);
 	if (!attr || attr->group || g_ascii_strcasecmp (attr->name, "begin")) {
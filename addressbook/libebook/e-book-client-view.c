@@ -1235,6 +1235,43 @@ e_book_client_view_set_flags (EBookClientView *client_view,
 	}
 }
 
+/**
+ * e_book_client_view_set_query:
+ * @client_view: an #EBookClientView
+ * @sexp: the new S-expression for @client_view
+ * @error: return location for a #GError, or %NULL
+ *
+ * Changes the query of a running @client_view without recreating it.
+ * Instead of sending the whole result again, the server emits
+ * #EBookClientView::objects-removed for the contacts which no longer
+ * match @sexp and #EBookClientView::objects-added for the contacts
+ * which were not in @client_view before, followed by
+ * #EBookClientView::complete.
+ *
+ * An invalid @sexp is reported through @error and leaves the current
+ * query in place.
+ *
+ * Since: 3.20
+ **/
+void
+e_book_client_view_set_query (EBookClientView *client_view,
+                              const gchar *sexp,
+                              GError **error)
+{
+	GError *local_error = NULL;
+
+	g_return_if_fail (E_IS_BOOK_CLIENT_VIEW (client_view));
+	g_return_if_fail (sexp != NULL);
+
+	e_gdbus_book_view_call_set_query_sync (
+		client_view->priv->dbus_proxy, sexp, NULL, &local_error);
+
+	if (local_error != NULL) {
+		g_dbus_error_strip_remote_error (local_error);
+		g_propagate_error (error, local_error);
+	}
+}
+
 /**
  * e_book_client_view_set_fields_of_interest:
  * @client_view: an #EBookClientView
@@ -118,6 +118,9 @@ void		e_book_client_view_stop		(EBookClientView *client_view,
 void		e_book_client_view_set_flags	(EBookClientView *client_view,
 						 EBookClientViewFlags flags,
 						 GError **error);
+void		e_book_client_view_set_query	(EBookClientView *client_view,
+						 const gchar *sexp,
+						 GError **error);
 
 #ifndef EDS_DISABLE_DEPRECATED
 struct _EBookClient *
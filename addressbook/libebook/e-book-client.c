@@ -35,6 +35,15 @@
 #include <glib/gi18n-lib.h>
 #include <gio/gio.h>
 
+#ifdef G_OS_UNIX
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib-unix.h>
+#include <gio/gunixfdlist.h>
+#include <gio/gunixoutputstream.h>
+#endif
+
 /* Private D-Bus classes. */
 #include <e-dbus-address-book.h>
 #include <e-dbus-address-book-factory.h>
@@ -70,6 +79,9 @@ struct _EBookClientPrivate {
 	gulong dbus_proxy_notify_handler_id;
 
 	gchar *locale;
+
+	/* the factory does not know GetContactListFd */
+	volatile gint no_contact_list_fd;
 };
 
 struct _AsyncContext {
@@ -83,6 +95,7 @@ struct _AsyncContext {
 	guint n_sort_fields;
 	gchar *sexp;
 	gchar *uid;
+	GInputStream *stream;
 	GMainContext *context;
 };
 
@@ -158,6 +171,8 @@ async_context_free (AsyncContext *async_context)
 	g_free (async_context->sexp);
 	g_free (async_context->uid);
 
+	g_clear_object (&async_context->stream);
+
 	g_slice_free (AsyncContext, async_context);
 }
 
@@ -2493,6 +2508,273 @@ e_book_client_add_contacts_sync (EBookClient *client,
 	return TRUE;
 }
 
+/* Helper for e_book_client_import_contacts() */
+static void
+book_client_import_contacts_thread (GSimpleAsyncResult *simple,
+                                    GObject *source_object,
+                                    GCancellable *cancellable)
+{
+	AsyncContext *async_context;
+	GError *local_error = NULL;
+
+	async_context = g_simple_async_result_get_op_res_gpointer (simple);
+
+	if (!e_book_client_import_contacts_sync (
+		E_BOOK_CLIENT (source_object),
+		async_context->stream,
+		&async_context->string_list,
+		cancellable, &local_error)) {
+
+		if (!local_error)
+			local_error = g_error_new_literal (
+				E_CLIENT_ERROR,
+				E_CLIENT_ERROR_OTHER_ERROR,
+				_("Unknown error"));
+	}
+
+	if (local_error != NULL)
+		g_simple_async_result_take_error (simple, local_error);
+}
+
+/**
+ * e_book_client_import_contacts:
+ * @client: an #EBookClient
+ * @stream: a #GInputStream with vCards
+ * @cancellable: (allow-none): a #GCancellable; can be %NULL
+ * @callback: callback to call when a result is ready
+ * @user_data: user data for the @callback
+ *
+ * Adds a contact to @client for each vCard read from @stream.
+ * See e_book_client_import_contacts_sync() for details.
+ * The call is finished by e_book_client_import_contacts_finish()
+ * from the @callback.
+ *
+ * Since: 3.20
+ **/
+void
+e_book_client_import_contacts (EBookClient *client,
+                               GInputStream *stream,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+	GSimpleAsyncResult *simple;
+	AsyncContext *async_context;
+
+	g_return_if_fail (E_IS_BOOK_CLIENT (client));
+	g_return_if_fail (G_IS_INPUT_STREAM (stream));
+
+	async_context = g_slice_new0 (AsyncContext);
+	async_context->stream = g_object_ref (stream);
+
+	simple = g_simple_async_result_new (
+		G_OBJECT (client), callback, user_data,
+		e_book_client_import_contacts);
+
+	g_simple_async_result_set_check_cancellable (simple, cancellable);
+
+	g_simple_async_result_set_op_res_gpointer (
+		simple, async_context, (GDestroyNotify) async_context_free);
+
+	g_simple_async_result_run_in_thread (
+		simple, book_client_import_contacts_thread,
+		G_PRIORITY_DEFAULT, cancellable);
+
+	g_object_unref (simple);
+}
+
+/**
+ * e_book_client_import_contacts_finish:
+ * @client: an #EBookClient
+ * @result: a #GAsyncResult
+ * @out_added_uids: (out) (element-type utf8) (allow-none): UIDs of
+ *                  newly added contacts; can be %NULL
+ * @error: (out): a #GError to set an error, if any
+ *
+ * Finishes previous call of e_book_client_import_contacts() and
+ * sets @out_added_uids to the UIDs of newly added contacts if successful.
+ * This #GSList should be freed with e_client_util_free_string_slist().
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 3.20
+ **/
+gboolean
+e_book_client_import_contacts_finish (EBookClient *client,
+                                      GAsyncResult *result,
+                                      GSList **out_added_uids,
+                                      GError **error)
+{
+	GSimpleAsyncResult *simple;
+	AsyncContext *async_context;
+
+	g_return_val_if_fail (
+		g_simple_async_result_is_valid (
+		result, G_OBJECT (client),
+		e_book_client_import_contacts), FALSE);
+
+	simple = G_SIMPLE_ASYNC_RESULT (result);
+	async_context = g_simple_async_result_get_op_res_gpointer (simple);
+
+	if (g_simple_async_result_propagate_error (simple, error))
+		return FALSE;
+
+	if (out_added_uids != NULL) {
+		*out_added_uids = async_context->string_list;
+		async_context->string_list = NULL;
+	}
+
+	return TRUE;
+}
+
+#ifdef G_OS_UNIX
+typedef struct _ImportWriter {
+	GInputStream *input;
+	GOutputStream *output;
+	GCancellable *cancellable;
+	GError *error;
+} ImportWriter;
+
+/* Helper for e_book_client_import_contacts_sync(), feeds
+ * the pipe which the backend reads the vCards from */
+static gpointer
+book_client_import_writer_thread (gpointer user_data)
+{
+	ImportWriter *writer = user_data;
+
+	g_output_stream_splice (
+		writer->output, writer->input,
+		G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+		writer->cancellable, &writer->error);
+
+	return NULL;
+}
+#endif
+
+/**
+ * e_book_client_import_contacts_sync:
+ * @client: an #EBookClient
+ * @stream: a #GInputStream with vCards
+ * @out_added_uids: (out) (element-type utf8) (allow-none): UIDs of newly
+ *                  added contacts; can be %NULL
+ * @cancellable: a #GCancellable; can be %NULL
+ * @error: (out): a #GError to set an error, if any
+ *
+ * Adds a contact to @client for each vCard read from @stream and
+ * sets @out_added_uids to the UIDs of newly added contacts if successful.
+ * This #GSList should be freed with e_client_util_free_string_slist().
+ *
+ * Unlike e_book_client_add_contacts_sync(), the vCards are streamed
+ * to the backend through a file descriptor, which stores them in large
+ * batches and notifies views once per batch.  This is the preferred way
+ * to add many contacts at once, like when importing a vCard file.
+ *
+ * The contacts are not added as a unit: when an error occurs, some of
+ * them may already have been added to @client.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 3.20
+ **/
+gboolean
+e_book_client_import_contacts_sync (EBookClient *client,
+                                    GInputStream *stream,
+                                    GSList **out_added_uids,
+                                    GCancellable *cancellable,
+                                    GError **error)
+{
+#ifdef G_OS_UNIX
+	ImportWriter writer = { NULL, };
+	GUnixFDList *fd_list;
+	GThread *thread;
+	GVariant *result;
+	gchar **uids = NULL;
+	gint fds[2];
+	GError *local_error = NULL;
+
+	g_return_val_if_fail (E_IS_BOOK_CLIENT (client), FALSE);
+	g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+
+	if (!g_unix_open_pipe (fds, FD_CLOEXEC, error))
+		return FALSE;
+
+	/* Takes ownership of the read end */
+	fd_list = g_unix_fd_list_new_from_array (fds, 1);
+
+	writer.input = stream;
+	writer.output = g_unix_output_stream_new (fds[1], TRUE);
+	writer.cancellable = cancellable;
+
+	thread = g_thread_new (
+		"book-client-import",
+		book_client_import_writer_thread, &writer);
+
+	/* Large imports can take a while, so no timeout here */
+	result = g_dbus_proxy_call_with_unix_fd_list_sync (
+		G_DBUS_PROXY (client->priv->dbus_proxy),
+		"ImportContacts", g_variant_new ("(h)", 0),
+		G_DBUS_CALL_FLAGS_NONE, G_MAXINT, fd_list, NULL,
+		cancellable, &local_error);
+
+	/* Close our copy of the read end, in case the backend
+	 * stopped reading early and the writer is blocked; it
+	 * gets an error then, SIGPIPE is ignored by GDBus. */
+	g_object_unref (fd_list);
+
+	g_thread_join (thread);
+	g_object_unref (writer.output);
+
+	if (result != NULL) {
+		g_variant_get (result, "(^as)", &uids);
+		g_variant_unref (result);
+	}
+
+	/* A failure to read the input means that only
+	 * a part of the vCards could have been added */
+	if (local_error == NULL && writer.error != NULL) {
+		local_error = writer.error;
+		writer.error = NULL;
+	}
+
+	g_clear_error (&writer.error);
+
+	if (local_error != NULL) {
+		g_dbus_error_strip_remote_error (local_error);
+		g_propagate_error (error, local_error);
+		g_strfreev (uids);
+		return FALSE;
+	}
+
+	if (out_added_uids != NULL) {
+		GSList *tmp = NULL;
+		gint ii;
+
+		/* Take ownership of the string array elements. */
+		for (ii = 0; uids != NULL && uids[ii] != NULL; ii++) {
+			tmp = g_slist_prepend (tmp, uids[ii]);
+			uids[ii] = NULL;
+		}
+
+		*out_added_uids = g_slist_reverse (tmp);
+	}
+
+	g_strfreev (uids);
+
+	return TRUE;
+#else
+	g_return_val_if_fail (E_IS_BOOK_CLIENT (client), FALSE);
+	g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+
+	g_set_error_literal (
+		error, E_CLIENT_ERROR,
+		E_CLIENT_ERROR_NOT_SUPPORTED,
+		e_client_error_to_string (
+		E_CLIENT_ERROR_NOT_SUPPORTED));
+
+	return FALSE;
+#endif
+}
+
 /* Helper for e_book_client_modify_contact() */
 static void
 book_client_modify_contact_thread (GSimpleAsyncResult *simple,
@@ -3521,6 +3803,143 @@ e_book_client_get_contacts_finish (EBookClient *client,
 	return TRUE;
 }
 
+#ifdef G_OS_UNIX
+/* Helper for book_client_get_contact_list_fd_sync(), builds
+ * contacts from the NUL-separated vCards of a result snapshot */
+static gboolean
+book_client_read_snapshot (gint fd,
+                           GSList **out_contacts,
+                           GError **error)
+{
+	GMappedFile *mapped_file;
+	const gchar *data, *end;
+	GSList *tmp = NULL;
+	gboolean success = TRUE;
+
+	mapped_file = g_mapped_file_new_from_fd (fd, FALSE, error);
+	if (mapped_file == NULL)
+		return FALSE;
+
+	data = g_mapped_file_get_contents (mapped_file);
+	end = data + g_mapped_file_get_length (mapped_file);
+
+	while (data < end) {
+		const gchar *next = memchr (data, '\0', end - data);
+
+		/* Each vCard is terminated, a missing terminator
+		 * means the snapshot was not written completely */
+		if (next == NULL) {
+			g_set_error_literal (
+				error, E_CLIENT_ERROR,
+				E_CLIENT_ERROR_OTHER_ERROR,
+				_("The list of contacts is incomplete"));
+			success = FALSE;
+			break;
+		}
+
+		tmp = g_slist_prepend (tmp, e_contact_new_from_vcard (data));
+		data = next + 1;
+	}
+
+	g_mapped_file_unref (mapped_file);
+
+	if (success)
+		*out_contacts = g_slist_reverse (tmp);
+	else
+		g_slist_free_full (tmp, (GDestroyNotify) g_object_unref);
+
+	return success;
+}
+
+/* Helper for e_book_client_get_contacts_sync(), large results
+ * are passed in a memory-backed file instead of in the message,
+ * which saves marshalling and copying them around in D-Bus */
+static void
+book_client_get_contact_list_fd_sync (EBookClient *client,
+                                      const gchar *utf8_sexp,
+                                      GSList **out_contacts,
+                                      GCancellable *cancellable,
+                                      GError **error)
+{
+	GUnixFDList *fd_list = NULL;
+	GVariant *result;
+	gchar **vcards = NULL;
+	gint handle = -1;
+
+	result = g_dbus_proxy_call_with_unix_fd_list_sync (
+		G_DBUS_PROXY (client->priv->dbus_proxy),
+		"GetContactListFd", g_variant_new ("(s)", utf8_sexp),
+		G_DBUS_CALL_FLAGS_NONE, -1, NULL, &fd_list,
+		cancellable, error);
+
+	if (result == NULL)
+		return;
+
+	g_variant_get (result, "(^ash)", &vcards, &handle);
+	g_variant_unref (result);
+
+	if (handle != -1) {
+		gint fd = -1;
+
+		if (fd_list != NULL)
+			fd = g_unix_fd_list_get (fd_list, handle, error);
+		else
+			g_set_error_literal (
+				error, E_CLIENT_ERROR,
+				E_CLIENT_ERROR_DBUS_ERROR,
+				e_client_error_to_string (
+				E_CLIENT_ERROR_DBUS_ERROR));
+
+		if (fd != -1) {
+			book_client_read_snapshot (fd, out_contacts, error);
+			close (fd);
+		}
+	} else {
+		GSList *tmp = NULL;
+		gint ii;
+
+		for (ii = 0; vcards[ii] != NULL; ii++)
+			tmp = g_slist_prepend (tmp, e_contact_new_from_vcard (vcards[ii]));
+
+		*out_contacts = g_slist_reverse (tmp);
+	}
+
+	g_clear_object (&fd_list);
+	g_strfreev (vcards);
+}
+#endif
+
+/* Helper for e_book_client_get_contacts_sync(), gets the
+ * contacts as vCard strings in the message itself */
+static void
+book_client_get_contact_list_vcards_sync (EBookClient *client,
+                                          const gchar *utf8_sexp,
+                                          GSList **out_contacts,
+                                          GCancellable *cancellable,
+                                          GError **error)
+{
+	gchar **vcards = NULL;
+
+	e_dbus_address_book_call_get_contact_list_sync (
+		client->priv->dbus_proxy, utf8_sexp,
+		&vcards, cancellable, error);
+
+	if (vcards != NULL) {
+		EContact *contact;
+		GSList *tmp = NULL;
+		gint ii;
+
+		for (ii = 0; vcards[ii] != NULL; ii++) {
+			contact = e_contact_new_from_vcard (vcards[ii]);
+			tmp = g_slist_prepend (tmp, contact);
+		}
+
+		*out_contacts = g_slist_reverse (tmp);
+
+		g_strfreev (vcards);
+	}
+}
+
 /**
  * e_book_client_get_contacts_sync:
  * @client: an #EBookClient
@@ -3549,7 +3968,7 @@ e_book_client_get_contacts_sync (EBookClient *client,
                                  GError **error)
 {
 	gchar *utf8_sexp;
-	gchar **vcards = NULL;
+	gboolean use_fd = FALSE;
 	GError *local_error = NULL;
 
 	g_return_val_if_fail (E_IS_BOOK_CLIENT (client), FALSE);
@@ -3583,31 +4002,30 @@ e_book_client_get_contacts_sync (EBookClient *client,
 
 	utf8_sexp = e_util_utf8_make_valid (sexp);
 
-	e_dbus_address_book_call_get_contact_list_sync (
-		client->priv->dbus_proxy, utf8_sexp,
-		&vcards, cancellable, &local_error);
+#ifdef G_OS_UNIX
+	use_fd = !g_atomic_int_get (&client->priv->no_contact_list_fd);
 
-	g_free (utf8_sexp);
+	if (use_fd) {
+		book_client_get_contact_list_fd_sync (
+			client, utf8_sexp, out_contacts,
+			cancellable, &local_error);
 
-	/* Sanity check. */
-	g_return_val_if_fail (
-		((vcards != NULL) && (local_error == NULL)) ||
-		((vcards == NULL) && (local_error != NULL)), FALSE);
-
-	if (vcards != NULL) {
-		EContact *contact;
-		GSList *tmp = NULL;
-		gint ii;
-
-		for (ii = 0; vcards[ii] != NULL; ii++) {
-			contact = e_contact_new_from_vcard (vcards[ii]);
-			tmp = g_slist_prepend (tmp, contact);
+		/* A factory older than this client, do not
+		 * ask it again and use GetContactList instead */
+		if (g_error_matches (local_error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+			g_atomic_int_set (&client->priv->no_contact_list_fd, 1);
+			g_clear_error (&local_error);
+			use_fd = FALSE;
 		}
+	}
+#endif
 
-		*out_contacts = g_slist_reverse (tmp);
+	if (!use_fd)
+		book_client_get_contact_list_vcards_sync (
+			client, utf8_sexp, out_contacts,
+			cancellable, &local_error);
 
-		g_strfreev (vcards);
-	}
+	g_free (utf8_sexp);
 
 	if (local_error != NULL) {
 		g_dbus_error_strip_remote_error (local_error);
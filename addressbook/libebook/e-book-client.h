@@ -164,6 +164,22 @@ gboolean	e_book_client_add_contacts_sync	(EBookClient *client,
 						 GSList **out_added_uids,
 						 GCancellable *cancellable,
 						 GError **error);
+void		e_book_client_import_contacts	(EBookClient *client,
+						 GInputStream *stream,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	e_book_client_import_contacts_finish
+						(EBookClient *client,
+						 GAsyncResult *result,
+						 GSList **out_added_uids,
+						 GError **error);
+gboolean	e_book_client_import_contacts_sync
+						(EBookClient *client,
+						 GInputStream *stream,
+						 GSList **out_added_uids,
+						 GCancellable *cancellable,
+						 GError **error);
 void		e_book_client_modify_contact	(EBookClient *client,
 						 EContact *contact,
 						 GCancellable *cancellable,
@@ -37,6 +37,11 @@
 #include "e-data-book.h"
 #include "e-book-backend.h"
 
+/* How many contacts e_book_backend_import_contacts_sync()
+ * hands to the backend at once, each batch being stored
+ * in a single transaction by the file backend */
+#define IMPORT_BATCH_SIZE 500
+
 #define E_BOOK_BACKEND_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), E_TYPE_BOOK_BACKEND, EBookBackendPrivate))
@@ -79,6 +84,7 @@ struct _AsyncContext {
 	gchar *uid;
 	gchar *query;
 	gchar **strv;
+	GInputStream *stream;
 
 	/* Outputs */
 	EContact *contact;
@@ -127,6 +133,7 @@ async_context_free (AsyncContext *async_context)
 	g_free (async_context->query);
 	g_strfreev (async_context->strv);
 
+	g_clear_object (&async_context->stream);
 	g_clear_object (&async_context->contact);
 
 	queue = async_context->object_queue;
@@ -1734,6 +1741,275 @@ e_book_backend_create_contacts_finish (EBookBackend *backend,
 	return TRUE;
 }
 
+/* Helper for e_book_backend_import_contacts_sync() */
+static gboolean
+book_backend_import_batch (EBookBackend *backend,
+                           GPtrArray *batch,
+                           GQueue *out_uids,
+                           GCancellable *cancellable,
+                           GError **error)
+{
+	GQueue queue = G_QUEUE_INIT;
+	gboolean success;
+
+	if (batch->len == 0)
+		return TRUE;
+
+	g_ptr_array_add (batch, NULL);
+
+	success = e_book_backend_create_contacts_sync (
+		backend, (const gchar * const *) batch->pdata,
+		&queue, cancellable, error);
+
+	while (!g_queue_is_empty (&queue)) {
+		EContact *contact = g_queue_pop_head (&queue);
+
+		g_queue_push_tail (out_uids, e_contact_get (contact, E_CONTACT_UID));
+		g_object_unref (contact);
+	}
+
+	/* Also frees the terminating NULL */
+	g_ptr_array_set_size (batch, 0);
+
+	return success;
+}
+
+/**
+ * e_book_backend_import_contacts_sync:
+ * @backend: an #EBookBackend
+ * @stream: a #GInputStream with vCards
+ * @out_uids: a #GQueue in which to deposit results
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Reads vCards from @stream until its end and creates a new contact
+ * from each of them, depositing the UIDs of the newly-created contacts
+ * in @out_uids.  The UIDs must be freed with g_free() when finished
+ * with them.
+ *
+ * The vCards are read incrementally and handed to the backend in large
+ * batches, thus this is much faster than adding contacts one by one
+ * when importing many of them, while never holding the whole input
+ * in memory.  Each batch is stored as a unit, so when an error occurs
+ * the contacts of earlier batches stay in the address book.
+ *
+ * If @stream ends in the middle of a vCard, the input is considered
+ * truncated and the function fails with %E_CLIENT_ERROR_INVALID_ARG,
+ * without creating the contacts read since the last stored batch.
+ *
+ * If an error occurs, the function will set @error and return %FALSE.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ *
+ * Since: 3.20
+ **/
+gboolean
+e_book_backend_import_contacts_sync (EBookBackend *backend,
+                                     GInputStream *stream,
+                                     GQueue *out_uids,
+                                     GCancellable *cancellable,
+                                     GError **error)
+{
+	GDataInputStream *data_stream;
+	GPtrArray *batch;
+	GString *vcard = NULL;
+	gboolean success = TRUE;
+
+	g_return_val_if_fail (E_IS_BOOK_BACKEND (backend), FALSE);
+	g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+	g_return_val_if_fail (out_uids != NULL, FALSE);
+
+	data_stream = g_data_input_stream_new (stream);
+	g_data_input_stream_set_newline_type (
+		data_stream, G_DATA_STREAM_NEWLINE_TYPE_ANY);
+	g_filter_input_stream_set_close_base_stream (
+		G_FILTER_INPUT_STREAM (data_stream), FALSE);
+
+	batch = g_ptr_array_new_with_free_func (g_free);
+
+	while (success) {
+		GError *local_error = NULL;
+		gchar *line;
+
+		line = g_data_input_stream_read_line (
+			data_stream, NULL, cancellable, &local_error);
+
+		if (line == NULL) {
+			if (local_error != NULL) {
+				g_propagate_error (error, local_error);
+				success = FALSE;
+			}
+			break;
+		}
+
+		/* Skip anything between the vCards */
+		if (vcard == NULL) {
+			if (g_ascii_strncasecmp (line, "BEGIN:VCARD", 11) == 0)
+				vcard = g_string_new ("");
+			else {
+				g_free (line);
+				continue;
+			}
+		}
+
+		g_string_append (vcard, line);
+		g_string_append (vcard, "\r\n");
+
+		/* Folded lines start with white space,
+		 * thus they cannot end the vCard */
+		if (g_ascii_strncasecmp (line, "END:VCARD", 9) == 0) {
+			g_ptr_array_add (batch, g_string_free (vcard, FALSE));
+			vcard = NULL;
+
+			if (batch->len >= IMPORT_BATCH_SIZE)
+				success = book_backend_import_batch (
+					backend, batch, out_uids,
+					cancellable, error);
+		}
+
+		g_free (line);
+	}
+
+	/* The stream ended in the middle of a vCard, most likely its
+	 * writer failed, thus the input is incomplete; drop the partial
+	 * vCard together with the pending batch, as on a read error */
+	if (vcard != NULL) {
+		g_string_free (vcard, TRUE);
+
+		if (success) {
+			g_set_error_literal (
+				error, E_CLIENT_ERROR,
+				E_CLIENT_ERROR_INVALID_ARG,
+				_("The last vCard is incomplete"));
+			success = FALSE;
+		}
+	}
+
+	if (success)
+		success = book_backend_import_batch (
+			backend, batch, out_uids, cancellable, error);
+
+	g_ptr_array_unref (batch);
+	g_object_unref (data_stream);
+
+	return success;
+}
+
+/* Helper for e_book_backend_import_contacts() */
+static void
+book_backend_import_contacts_thread (GSimpleAsyncResult *simple,
+                                     GObject *source_object,
+                                     GCancellable *cancellable)
+{
+	AsyncContext *async_context;
+	GError *local_error = NULL;
+
+	async_context = g_simple_async_result_get_op_res_gpointer (simple);
+
+	e_book_backend_import_contacts_sync (
+		E_BOOK_BACKEND (source_object),
+		async_context->stream,
+		async_context->string_queue,
+		cancellable, &local_error);
+
+	if (local_error != NULL)
+		g_simple_async_result_take_error (simple, local_error);
+}
+
+/**
+ * e_book_backend_import_contacts:
+ * @backend: an #EBookBackend
+ * @stream: a #GInputStream with vCards
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is satisfied
+ * @user_data: data to pass to the callback function
+ *
+ * Asynchronously creates new contacts from the vCards read from @stream.
+ * See e_book_backend_import_contacts_sync() for details.
+ *
+ * When the operation is finished, @callback will be called.  You can then
+ * call e_book_backend_import_contacts_finish() to get the result of the
+ * operation.
+ *
+ * Since: 3.20
+ **/
+void
+e_book_backend_import_contacts (EBookBackend *backend,
+                                GInputStream *stream,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
+{
+	GSimpleAsyncResult *simple;
+	AsyncContext *async_context;
+
+	g_return_if_fail (E_IS_BOOK_BACKEND (backend));
+	g_return_if_fail (G_IS_INPUT_STREAM (stream));
+
+	async_context = g_slice_new0 (AsyncContext);
+	async_context->stream = g_object_ref (stream);
+	async_context->string_queue = &async_context->result_queue;
+
+	simple = g_simple_async_result_new (
+		G_OBJECT (backend), callback, user_data,
+		e_book_backend_import_contacts);
+
+	g_simple_async_result_set_check_cancellable (simple, cancellable);
+
+	g_simple_async_result_set_op_res_gpointer (
+		simple, async_context, (GDestroyNotify) async_context_free);
+
+	/* Not an operation of its own, each
+	 * batch is dispatched as one instead */
+	g_simple_async_result_run_in_thread (
+		simple, book_backend_import_contacts_thread,
+		G_PRIORITY_DEFAULT, cancellable);
+
+	g_object_unref (simple);
+}
+
+/**
+ * e_book_backend_import_contacts_finish:
+ * @backend: an #EBookBackend
+ * @result: a #GAsyncResult
+ * @out_uids: a #GQueue in which to deposit results
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes the operation started with e_book_backend_import_contacts().
+ *
+ * The UIDs of the newly-created contacts are deposited in @out_uids.
+ * They must be freed with g_free() when finished with them.  Contacts
+ * of batches stored before an error occurred are deposited as well.
+ *
+ * If an error occurred, the function will set @error and return %FALSE.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ *
+ * Since: 3.20
+ **/
+gboolean
+e_book_backend_import_contacts_finish (EBookBackend *backend,
+                                       GAsyncResult *result,
+                                       GQueue *out_uids,
+                                       GError **error)
+{
+	GSimpleAsyncResult *simple;
+	AsyncContext *async_context;
+
+	g_return_val_if_fail (
+		g_simple_async_result_is_valid (
+		result, G_OBJECT (backend),
+		e_book_backend_import_contacts), FALSE);
+	g_return_val_if_fail (out_uids != NULL, FALSE);
+
+	simple = G_SIMPLE_ASYNC_RESULT (result);
+	async_context = g_simple_async_result_get_op_res_gpointer (simple);
+
+	e_queue_transfer (async_context->string_queue, out_uids);
+
+	return !g_simple_async_result_propagate_error (simple, error);
+}
+
 /**
  * e_book_backend_modify_contacts_sync:
  * @backend: an #EBookBackend
@@ -349,6 +349,22 @@ gboolean	e_book_backend_create_contacts_finish
 						 GAsyncResult *result,
 						 GQueue *out_contacts,
 						 GError **error);
+gboolean	e_book_backend_import_contacts_sync
+						(EBookBackend *backend,
+						 GInputStream *stream,
+						 GQueue *out_uids,
+						 GCancellable *cancellable,
+						 GError **error);
+void		e_book_backend_import_contacts	(EBookBackend *backend,
+						 GInputStream *stream,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	e_book_backend_import_contacts_finish
+						(EBookBackend *backend,
+						 GAsyncResult *result,
+						 GQueue *out_uids,
+						 GError **error);
 gboolean	e_book_backend_modify_contacts_sync
 						(EBookBackend *backend,
 						 const gchar * const *vcards,
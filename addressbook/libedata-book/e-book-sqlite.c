@@ -245,7 +245,7 @@ ebsql_init_debug (void)
 		} \
 	} G_STMT_END
 
-#define FOLDER_VERSION                11
+#define FOLDER_VERSION                12
 #define INSERT_MULTI_STMT_BYTES       128
 #define COLUMN_DEFINITION_BYTES       32
 #define GENERATED_QUERY_BYTES         1024
@@ -270,11 +270,18 @@ ebsql_init_debug (void)
  */
 #define EBSQL_UPGRADE_BATCH_SIZE      20
 
+/* Number of contact changes tracked in a cursor's cached
+ * counts in one transaction, counting again is cheaper
+ * after larger batches.
+ */
+#define EBSQL_CURSOR_MAX_PENDING      100
+
 #define EBSQL_ESCAPE_SEQUENCE        "ESCAPE '^'"
 
 /* Names for custom functions */
 #define EBSQL_FUNC_COMPARE_VCARD     "compare_vcard"
 #define EBSQL_FUNC_FETCH_VCARD       "fetch_vcard"
+#define EBSQL_FUNC_PROJECT_VCARD     "project_vcard"
 #define EBSQL_FUNC_EQPHONE_EXACT     "eqphone_exact"
 #define EBSQL_FUNC_EQPHONE_NATIONAL  "eqphone_national"
 #define EBSQL_FUNC_EQPHONE_SHORT     "eqphone_short"
@@ -291,6 +298,15 @@ ebsql_init_debug (void)
 #define EBSQL_SUFFIX_PHONE           "phone"
 #define EBSQL_SUFFIX_COUNTRY         "country"
 
+/* Suffix for the per field tables holding E_BOOK_INDEX_TRIGRAM data */
+#define EBSQL_SUFFIX_TRIGRAMS        "trigrams"
+
+/* The most trigrams of a search term looked up in a trigram table,
+ * each one costs an index range scan and the LIKE comparison which
+ * follows ensures the result is exact anyway.
+ */
+#define EBSQL_MAX_TRIGRAMS_PER_TEST  4
+
 /* Track EBookIndexType's in a bit mask  */
 #define INDEX_FLAG(type)  (1 << E_BOOK_INDEX_##type)
 
@@ -325,6 +341,15 @@ static gboolean		ebsql_exec		(EBookSqlite *ebsql,
 						 gpointer data,
 						 GCancellable *cancellable,
 						 GError **error);
+static void		ebsql_cursors_invalidate
+						(EBookSqlite *ebsql);
+static gboolean		ebsql_cursors_track_uid	(EBookSqlite *ebsql,
+						 const gchar *uid,
+						 gint delta,
+						 GError **error);
+static void		ebsql_cursors_end_transaction
+						(EBookSqlite *ebsql,
+						 gboolean committed);
 
 typedef struct {
 	EContactField field_id;           /* The EContact field */
@@ -333,6 +358,7 @@ typedef struct {
 	gint          index;              /* Types of searches this field should support (see EBookIndexType) */
 	gchar        *aux_table;          /* Name of auxiliary table for this field, for multivalued fields only */
 	gchar        *aux_table_symbolic; /* Symolic name of auxiliary table used in queries */
+	gchar        *trigram_table;      /* Name of the trigram table for this field, used with E_BOOK_INDEX_TRIGRAM */
 } SummaryField;
 
 struct _EBookSqlitePrivate {
@@ -349,6 +375,8 @@ struct _EBookSqlitePrivate {
 	gpointer            user_data;          /* Data & Destroy notifier for the above callbacks */
 	GDestroyNotify      user_data_destroy;
 
+	gboolean            store_bvcards;      /* Whether binary vcards are written, see e_book_sqlite_set_store_bvcards () */
+
 	/* Summary configuration */
 	SummaryField   *summary_fields;
 	gint            n_summary_fields;
@@ -365,8 +393,13 @@ struct _EBookSqlitePrivate {
 	sqlite3        *db;
 	sqlite3_stmt   *insert_stmt;     /* Insert statement for main summary table */
 	sqlite3_stmt   *replace_stmt;    /* Replace statement for main summary table */
+	sqlite3_stmt   *bvcard_stmt;     /* Fetches the binary vcard of a contact */
 	GHashTable     *multi_deletes;   /* Delete statement for each auxiliary table */
 	GHashTable     *multi_inserts;   /* Insert statement for each auxiliary table */
+	GHashTable     *trigram_deletes; /* Delete statement for each trigram table */
+	GHashTable     *trigram_inserts; /* Insert statement for each trigram table */
+
+	GSList         *cursors;         /* The open EbSqlCursors, their cached counts follow our changes */
 
 	ESource        *source;
 };
@@ -587,6 +620,8 @@ summary_field_append (GArray *array,
 		new_field.aux_table_symbolic = g_strconcat (dbname, "_list", NULL);
 	}
 
+	new_field.trigram_table = g_strconcat (folderid, "_", dbname, "_" EBSQL_SUFFIX_TRIGRAMS, NULL);
+
 	new_field.field_id = field_id;
 	new_field.dbname = dbname;
 	new_field.type = type;
@@ -716,6 +751,7 @@ summary_fields_array_free (SummaryField *fields,
 	for (i = 0; i < n_fields; i++) {
 		g_free (fields[i].aux_table);
 		g_free (fields[i].aux_table_symbolic);
+		g_free (fields[i].trigram_table);
 	}
 
 	g_free (fields);
@@ -815,6 +851,7 @@ get_columns_cb (gpointer ref,
 
 			/* Keep comparing for the legacy 'bdata' column */
 			if (strcmp (cols[i], "vcard") != 0 &&
+			    strcmp (cols[i], "bvcard") != 0 &&
 			    strcmp (cols[i], "bdata") != 0) {
 				gchar *column = g_strdup (cols[i]);
 
@@ -956,13 +993,11 @@ collect_uid_results_cb (gpointer ref,
 	return 0;
 }
 
-static gint
-collect_lean_results_cb (gpointer ref,
-                         gint ncol,
-                         gchar **cols,
-                         gchar **names)
+static EbSqlSearchData *
+search_data_from_lean_results (gint ncol,
+                               gchar **cols,
+                               gchar **names)
 {
-	GSList **vcard_data = ref;
 	EbSqlSearchData *search_data = g_slice_new0 (EbSqlSearchData);
 	EContact *contact = e_contact_new ();
 	gchar *vcard;
@@ -986,9 +1021,62 @@ collect_lean_results_cb (gpointer ref,
 
 	vcard = e_vcard_to_string (E_VCARD (contact), EVC_FORMAT_VCARD_30);
 	search_data->vcard = vcard;
-	*vcard_data = g_slist_prepend (*vcard_data, search_data);
 
 	g_object_unref (contact);
+
+	return search_data;
+}
+
+static gint
+collect_lean_results_cb (gpointer ref,
+                         gint ncol,
+                         gchar **cols,
+                         gchar **names)
+{
+	GSList **vcard_data = ref;
+	EbSqlSearchData *search_data;
+
+	search_data = search_data_from_lean_results (ncol, cols, names);
+
+	*vcard_data = g_slist_prepend (*vcard_data, search_data);
+
+	return 0;
+}
+
+typedef struct {
+	EbSqlSearchFunc func;
+	gpointer user_data;
+	gboolean meta_contacts;
+	gboolean stopped;
+} SearchForeachData;
+
+/* Hands each row to the e_book_sqlite_search_foreach() caller as it
+ * comes out of the statement, nothing is accumulated */
+static gint
+foreach_results_cb (gpointer ref,
+                    gint ncol,
+                    gchar **cols,
+                    gchar **names)
+{
+	SearchForeachData *foreach_data = ref;
+	EbSqlSearchData *search_data;
+	gboolean proceed;
+
+	if (foreach_data->meta_contacts)
+		search_data = search_data_from_lean_results (ncol, cols, names);
+	else
+		search_data = search_data_from_results (ncol, cols, names);
+
+	proceed = foreach_data->func (search_data, foreach_data->user_data);
+
+	e_book_sqlite_search_data_free (search_data);
+
+	if (!proceed) {
+		/* Makes sqlite3_exec() return SQLITE_ABORT */
+		foreach_data->stopped = TRUE;
+		return 1;
+	}
+
 	return 0;
 }
 
@@ -1252,6 +1340,8 @@ ebsql_commit_transaction (EBookSqlite *ebsql,
 	if (ebsql->priv->in_transaction == 0) {
 		success = ebsql_exec (ebsql, "COMMIT", NULL, NULL, NULL, error);
 
+		ebsql_cursors_end_transaction (ebsql, success);
+
 		/* The outermost transaction is finished, let's release
 		 * our reference to the user's cancel object here */
 		g_clear_object (&ebsql->priv->cancel);
@@ -1277,6 +1367,8 @@ ebsql_rollback_transaction (EBookSqlite *ebsql,
 	if (ebsql->priv->in_transaction == 0) {
 		success = ebsql_exec (ebsql, "ROLLBACK", NULL, NULL, NULL, error);
 
+		ebsql_cursors_end_transaction (ebsql, FALSE);
+
 		/* The outermost transaction is finished, let's release
 		 * our reference to the user's cancel object here */
 		g_clear_object (&ebsql->priv->cancel);
@@ -1338,6 +1430,326 @@ ebsql_complete_statement (EBookSqlite *ebsql,
 	return (ret == SQLITE_OK || ret == SQLITE_DONE);
 }
 
+/******************************************************
+ *                Binary vCard format                 *
+ ******************************************************
+ *
+ * Alongside the vCard text, contacts are stored in a
+ * pre-parsed binary form which can be turned back into
+ * an EContact without any vCard parsing, unescaping or
+ * unfolding. All integers are 32 bit little endian:
+ *
+ *   "EBV1" <n_attributes> <offset of each attribute>
+ *
+ * Each attribute is stored with its parameters and values:
+ *
+ *   <group> <name> <n_params> [<name> <n_values> <value>...]...
+ *   <n_values> <value>...
+ *
+ * Strings are stored as their byte length followed by the
+ * bytes and a NUL terminator, NULL strings have a length
+ * of G_MAXUINT32 and no bytes.
+ */
+#define EBSQL_BVCARD_MAGIC           "EBV1"
+#define EBSQL_BVCARD_MAGIC_LEN       4
+#define EBSQL_BVCARD_NULL_STRING     G_MAXUINT32
+
+typedef struct {
+	const guint8 *data;
+	gsize         len;
+	gsize         pos;
+} EbSqlBVCardReader;
+
+static void
+ebsql_bvcard_append_uint (GByteArray *array,
+                          guint32 value)
+{
+	value = GUINT32_TO_LE (value);
+	g_byte_array_append (array, (const guint8 *) &value, sizeof (guint32));
+}
+
+static void
+ebsql_bvcard_append_string (GByteArray *array,
+                            const gchar *str)
+{
+	gsize len;
+
+	if (!str) {
+		ebsql_bvcard_append_uint (array, EBSQL_BVCARD_NULL_STRING);
+		return;
+	}
+
+	len = strlen (str);
+	ebsql_bvcard_append_uint (array, len);
+	g_byte_array_append (array, (const guint8 *) str, len + 1);
+}
+
+static guint8 *
+ebsql_bvcard_encode (EVCard *vcard,
+                     gsize *out_len)
+{
+	GByteArray *array;
+	GList *attributes, *l, *p, *v;
+	guint32 n_attributes, offset, ii;
+
+	attributes = e_vcard_get_attributes (vcard);
+	n_attributes = g_list_length (attributes);
+
+	array = g_byte_array_sized_new (1024);
+	g_byte_array_append (array, (const guint8 *) EBSQL_BVCARD_MAGIC, EBSQL_BVCARD_MAGIC_LEN);
+	ebsql_bvcard_append_uint (array, n_attributes);
+
+	/* Reserve the offset table, it's filled in as we go */
+	g_byte_array_set_size (array, array->len + n_attributes * sizeof (guint32));
+
+	for (l = attributes, ii = 0; l; l = l->next, ii++) {
+		EVCardAttribute *attr = l->data;
+		GList *params, *values;
+
+		offset = GUINT32_TO_LE (array->len);
+		memcpy (
+			array->data + EBSQL_BVCARD_MAGIC_LEN + (ii + 1) * sizeof (guint32),
+			&offset, sizeof (guint32));
+
+		ebsql_bvcard_append_string (array, e_vcard_attribute_get_group (attr));
+		ebsql_bvcard_append_string (array, e_vcard_attribute_get_name (attr));
+
+		/* Parameters are prepended when added to an attribute,
+		 * store them backwards so they come back in order */
+		params = e_vcard_attribute_get_params (attr);
+		ebsql_bvcard_append_uint (array, g_list_length (params));
+
+		for (p = g_list_last (params); p; p = p->prev) {
+			EVCardAttributeParam *param = p->data;
+
+			values = e_vcard_attribute_param_get_values (param);
+
+			ebsql_bvcard_append_string (array, e_vcard_attribute_param_get_name (param));
+			ebsql_bvcard_append_uint (array, g_list_length (values));
+
+			for (v = values; v; v = v->next)
+				ebsql_bvcard_append_string (array, v->data);
+		}
+
+		values = e_vcard_attribute_get_values (attr);
+		ebsql_bvcard_append_uint (array, g_list_length (values));
+
+		for (v = values; v; v = v->next)
+			ebsql_bvcard_append_string (array, v->data);
+	}
+
+	*out_len = array->len;
+
+	return g_byte_array_free (array, FALSE);
+}
+
+static gboolean
+ebsql_bvcard_read_uint (EbSqlBVCardReader *reader,
+                        guint32 *value)
+{
+	guint32 le;
+
+	if (reader->len - reader->pos < sizeof (guint32))
+		return FALSE;
+
+	memcpy (&le, reader->data + reader->pos, sizeof (guint32));
+	reader->pos += sizeof (guint32);
+	*value = GUINT32_FROM_LE (le);
+
+	return TRUE;
+}
+
+/* The returned string points into the reader's data */
+static gboolean
+ebsql_bvcard_read_string (EbSqlBVCardReader *reader,
+                          const gchar **str)
+{
+	guint32 len;
+
+	if (!ebsql_bvcard_read_uint (reader, &len))
+		return FALSE;
+
+	if (len == EBSQL_BVCARD_NULL_STRING) {
+		*str = NULL;
+		return TRUE;
+	}
+
+	if (reader->len - reader->pos <= len ||
+	    reader->data[reader->pos + len] != '\0')
+		return FALSE;
+
+	*str = (const gchar *) reader->data + reader->pos;
+	reader->pos += len + 1;
+
+	return TRUE;
+}
+
+static EVCardAttribute *
+ebsql_bvcard_read_attribute (EbSqlBVCardReader *reader)
+{
+	EVCardAttribute *attr;
+	const gchar *group, *name, *value;
+	guint32 n_params, n_values, ii, jj;
+
+	if (!ebsql_bvcard_read_string (reader, &group) ||
+	    !ebsql_bvcard_read_string (reader, &name) || !name ||
+	    !ebsql_bvcard_read_uint (reader, &n_params))
+		return NULL;
+
+	attr = e_vcard_attribute_new (group, name);
+
+	for (ii = 0; ii < n_params; ii++) {
+		EVCardAttributeParam *param;
+
+		if (!ebsql_bvcard_read_string (reader, &name) || !name ||
+		    !ebsql_bvcard_read_uint (reader, &n_values))
+			goto malformed;
+
+		param = e_vcard_attribute_param_new (name);
+
+		for (jj = 0; jj < n_values; jj++) {
+			if (!ebsql_bvcard_read_string (reader, &value) || !value) {
+				e_vcard_attribute_param_free (param);
+				goto malformed;
+			}
+
+			e_vcard_attribute_param_add_value (param, value);
+		}
+
+		e_vcard_attribute_add_param (attr, param);
+	}
+
+	if (!ebsql_bvcard_read_uint (reader, &n_values))
+		goto malformed;
+
+	for (jj = 0; jj < n_values; jj++) {
+		if (!ebsql_bvcard_read_string (reader, &value) || !value)
+			goto malformed;
+
+		e_vcard_attribute_add_value (attr, value);
+	}
+
+	return attr;
+
+ malformed:
+	e_vcard_attribute_free (attr);
+
+	return NULL;
+}
+
+/* Whether the attribute at the position of 'reader' is named in 'attributes',
+ * malformed attributes are left to ebsql_bvcard_read_attribute() to reject */
+static gboolean
+ebsql_bvcard_peek_wanted (EbSqlBVCardReader reader,
+                          const gchar * const *attributes)
+{
+	const gchar *group, *name;
+	gint ii;
+
+	if (!ebsql_bvcard_read_string (&reader, &group) ||
+	    !ebsql_bvcard_read_string (&reader, &name) || !name)
+		return TRUE;
+
+	for (ii = 0; attributes[ii]; ii++) {
+		if (g_ascii_strcasecmp (attributes[ii], name) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Returns the number of attributes in 'data', or -1
+ * if it is not a valid binary vCard */
+static gint
+ebsql_bvcard_count_attributes (gconstpointer data,
+                               gsize len)
+{
+	EbSqlBVCardReader reader = { data, len, 0 };
+	guint32 n_attributes;
+
+	if (!data || len < EBSQL_BVCARD_MAGIC_LEN ||
+	    memcmp (data, EBSQL_BVCARD_MAGIC, EBSQL_BVCARD_MAGIC_LEN) != 0)
+		return -1;
+
+	reader.pos = EBSQL_BVCARD_MAGIC_LEN;
+	if (!ebsql_bvcard_read_uint (&reader, &n_attributes) ||
+	    n_attributes > (len - reader.pos) / sizeof (guint32) ||
+	    n_attributes > G_MAXINT)
+		return -1;
+
+	return n_attributes;
+}
+
+/* Decodes only the attribute at 'index', found through the offset table,
+ * 'data' must have been checked with ebsql_bvcard_count_attributes().
+ * If 'attributes' is not NULL and does not name the attribute, 'attr' is
+ * set to NULL.  Returns FALSE if the attribute is malformed */
+static gboolean
+ebsql_bvcard_decode_attribute (gconstpointer data,
+                               gsize len,
+                               guint32 index,
+                               const gchar * const *attributes,
+                               EVCardAttribute **attr)
+{
+	EbSqlBVCardReader reader = { data, len, 0 };
+	guint32 offset;
+
+	memcpy (
+		&offset,
+		(const guint8 *) data + EBSQL_BVCARD_MAGIC_LEN + (index + 1) * sizeof (guint32),
+		sizeof (guint32));
+	reader.pos = GUINT32_FROM_LE (offset);
+
+	*attr = NULL;
+
+	if (reader.pos >= len)
+		return FALSE;
+
+	if (attributes && !ebsql_bvcard_peek_wanted (reader, attributes))
+		return TRUE;
+
+	*attr = ebsql_bvcard_read_attribute (&reader);
+
+	return *attr != NULL;
+}
+
+/* Returns NULL if 'data' is not a valid binary vCard.  If 'attributes'
+ * is not NULL, only the attributes it names are decoded */
+static EContact *
+ebsql_bvcard_decode (gconstpointer data,
+                     gsize len,
+                     const gchar * const *attributes)
+{
+	EContact *contact;
+	gint n_attributes, ii;
+
+	n_attributes = ebsql_bvcard_count_attributes (data, len);
+	if (n_attributes < 0)
+		return NULL;
+
+	contact = e_contact_new ();
+
+	/* Have the (empty) vCard text parsed now, the parser
+	 * would otherwise reorder the attributes added below */
+	e_vcard_get_attributes (E_VCARD (contact));
+
+	/* Walk the offset table backwards, prepending
+	 * each attribute is cheaper than appending it */
+	for (ii = n_attributes - 1; ii >= 0; ii--) {
+		EVCardAttribute *attr;
+
+		if (!ebsql_bvcard_decode_attribute (data, len, ii, attributes, &attr)) {
+			g_object_unref (contact);
+			return NULL;
+		}
+
+		if (attr)
+			e_vcard_add_attribute (E_VCARD (contact), attr);
+	}
+
+	return contact;
+}
+
 /******************************************************
  *       Functions installed into the SQLite          *
  ******************************************************/
@@ -1392,6 +1804,7 @@ ebsql_compare_vcard (sqlite3_context *context,
                      sqlite3_value **argv)
 {
 	EBookBackendSExp *sexp = NULL;
+	EContact *contact;
 	const gchar *text;
 	const gchar *vcard;
 
@@ -1417,6 +1830,24 @@ ebsql_compare_vcard (sqlite3_context *context,
 
 	}
 
+	/* Prefer the binary form of the contact, it needs no parsing */
+	if (sqlite3_value_type (argv[1]) == SQLITE_BLOB) {
+		contact = ebsql_bvcard_decode (
+			sqlite3_value_blob (argv[1]),
+			sqlite3_value_bytes (argv[1]),
+			NULL);
+
+		if (contact) {
+			if (e_book_backend_sexp_match_contact (sexp, contact))
+				sqlite3_result_int (context, 1);
+			else
+				sqlite3_result_int (context, 0);
+
+			g_object_unref (contact);
+			return;
+		}
+	}
+
 	/* Reuse the same vcard as much as possible (it can be referred to more than
 	 * once in the query, so it can be reused for multiple comparisons on the same row)
 	 *
@@ -1425,12 +1856,12 @@ ebsql_compare_vcard (sqlite3_context *context,
 	 *
 	 * See ebsql_fetch_vcard() for details.
 	 */
-	vcard = sqlite3_get_auxdata (context, 1);
+	vcard = sqlite3_get_auxdata (context, 2);
 	if (!vcard) {
-		vcard = (const gchar *) sqlite3_value_text (argv[1]);
+		vcard = (const gchar *) sqlite3_value_text (argv[2]);
 
 		if (vcard)
-			sqlite3_set_auxdata (context, 1, g_strdup (vcard), g_free);
+			sqlite3_set_auxdata (context, 2, g_strdup (vcard), g_free);
 	}
 
 	/* A NULL vcard can never match */
@@ -1560,6 +1991,48 @@ ebsql_fetch_vcard (sqlite3_context *context,
 	sqlite3_result_text (context, vcard, -1, g_free);
 }
 
+/* Implementation of EBSQL_FUNC_PROJECT_VCARD, builds a vCard of only the
+ * comma separated attributes from the binary form of the contact, when
+ * there is none the vCard text is returned as is */
+static void
+ebsql_project_vcard (sqlite3_context *context,
+                     gint argc,
+                     sqlite3_value **argv)
+{
+	gchar **attributes;
+	gboolean new_attributes = FALSE;
+	EContact *contact = NULL;
+
+	/* The first argument is the same for all rows */
+	attributes = sqlite3_get_auxdata (context, 0);
+	if (!attributes) {
+		const gchar *text = (const gchar *) sqlite3_value_text (argv[0]);
+
+		attributes = g_strsplit (text ? text : "", ",", -1);
+		new_attributes = TRUE;
+	}
+
+	if (sqlite3_value_type (argv[1]) == SQLITE_BLOB)
+		contact = ebsql_bvcard_decode (
+			sqlite3_value_blob (argv[1]),
+			sqlite3_value_bytes (argv[1]),
+			(const gchar * const *) attributes);
+
+	if (contact) {
+		sqlite3_result_text (
+			context,
+			e_vcard_to_string (E_VCARD (contact), EVC_FORMAT_VCARD_30),
+			-1, g_free);
+		g_object_unref (contact);
+	} else {
+		sqlite3_result_value (context, argv[2]);
+	}
+
+	/* SQLite may free it right away, so this comes last */
+	if (new_attributes)
+		sqlite3_set_auxdata (context, 0, attributes, (GDestroyNotify) g_strfreev);
+}
+
 typedef struct {
 	const gchar     *name;
 	EbSqlCustomFunc  func;
@@ -1568,8 +2041,9 @@ typedef struct {
 
 static EbSqlCustomFuncTab ebsql_custom_functions[] = {
 	{ "regexp",                    ebsql_regexp,           2 }, /* regexp (expression, column_data) */
-	{ EBSQL_FUNC_COMPARE_VCARD,    ebsql_compare_vcard,    2 }, /* compare_vcard (sexp, vcard) */
+	{ EBSQL_FUNC_COMPARE_VCARD,    ebsql_compare_vcard,    3 }, /* compare_vcard (sexp, bvcard, vcard) */
 	{ EBSQL_FUNC_FETCH_VCARD,      ebsql_fetch_vcard,      2 }, /* fetch_vcard (uid, extra) */
+	{ EBSQL_FUNC_PROJECT_VCARD,    ebsql_project_vcard,    3 }, /* project_vcard (attributes, bvcard, vcard) */
 	{ EBSQL_FUNC_EQPHONE_EXACT,    ebsql_eqphone_exact,    2 }, /* eqphone_exact (search_input, column_data) */
 	{ EBSQL_FUNC_EQPHONE_NATIONAL, ebsql_eqphone_national, 2 }, /* eqphone_national (search_input, column_data) */
 	{ EBSQL_FUNC_EQPHONE_SHORT,    ebsql_eqphone_short,    2 }, /* eqphone_national (search_input, column_data) */
@@ -2317,6 +2791,31 @@ ebsql_introspect_summary (EBookSqlite *ebsql,
 		g_strfreev (fields);
 	}
 
+	/* Trigram indexes live in tables of their own, the
+	 * existence of such a table is what marks the index
+	 */
+	for (i = 0; success && i < summary_fields->len; i++) {
+		SummaryField *iter = &g_array_index (summary_fields, SummaryField, i);
+		gint n_tables = 0;
+
+		if (iter->type != G_TYPE_STRING &&
+		    iter->type != E_TYPE_CONTACT_ATTR_LIST)
+			continue;
+
+		success = ebsql_exec_printf (
+			ebsql,
+			"SELECT count(*) FROM sqlite_master "
+			"WHERE type='table' AND name=%Q",
+			get_count_cb, &n_tables, NULL, error,
+			iter->trigram_table);
+
+		if (success && n_tables == 1)
+			iter->index |= INDEX_FLAG (TRIGRAM);
+	}
+
+	if (!success)
+		goto introspect_summary_finish;
+
 	/* HARD CODE UP AHEAD
 	 *
 	 * Now we're finished introspecting, if the summary is from a previous version,
@@ -2438,6 +2937,7 @@ ebsql_introspect_summary (EBookSqlite *ebsql,
 /* Called with the lock held and inside a transaction */
 static gboolean
 ebsql_init_contacts (EBookSqlite *ebsql,
+                     gint previous_schema,
                      GSList *introspected_columns,
                      GError **error)
 {
@@ -2470,7 +2970,7 @@ ebsql_init_contacts (EBookSqlite *ebsql,
 
 		format_column_declaration (string, info);
 	}
-	g_string_append (string, ", vcard TEXT, bdata TEXT)");
+	g_string_append (string, ", vcard TEXT, bvcard BLOB, bdata TEXT)");
 
 	success = ebsql_exec_printf (
 		ebsql, string->str,
@@ -2503,6 +3003,16 @@ ebsql_init_contacts (EBookSqlite *ebsql,
 		}
 	}
 
+	/* The binary vCard column was added in version 12 of the schema,
+	 * older rows are left without it and fall back to the vCard text
+	 * until they are next written.
+	 */
+	if (success && previous_schema >= 1 && previous_schema < 12)
+		success = ebsql_exec_printf (
+			ebsql, "ALTER TABLE %Q ADD COLUMN bvcard BLOB",
+			NULL, NULL, NULL, error,
+			ebsql->priv->folderid);
+
 	/* Add indexes to columns in the main contacts table
 	 */
 	for (l = summary_columns; success && l; l = l->next) {
@@ -2612,25 +3122,82 @@ ebsql_init_aux_tables (EBookSqlite *ebsql,
 				field->aux_table));
 	}
 
-	if (success) {
-		gchar *multivalues;
+	for (i = 0; success && i < ebsql->priv->n_summary_fields; i++) {
+		SummaryField *field = &(ebsql->priv->summary_fields[i]);
 
-		multivalues = format_multivalues (ebsql);
+		if ((field->index & INDEX_FLAG (TRIGRAM)) == 0)
+			continue;
+
+		if (field->type != G_TYPE_STRING &&
+		    field->type != E_TYPE_CONTACT_ATTR_LIST)
+			continue;
 
 		success = ebsql_exec_printf (
 			ebsql,
-			"UPDATE folders SET multivalues=%Q WHERE folder_id=%Q",
+			"CREATE TABLE IF NOT EXISTS %Q ("
+			"uid TEXT NOT NULL REFERENCES %Q (uid), "
+			"trigram TEXT NOT NULL)",
 			NULL, NULL, NULL, error,
-			multivalues, ebsql->priv->folderid);
+			field->trigram_table, ebsql->priv->folderid);
 
-		g_free (multivalues);
-	}
+		/* The (trigram, uid) index lets a lookup of a trigram be answered
+		 * from the index alone, the uid index serves the deletes done
+		 * whenever a contact is replaced or removed
+		 */
+		if (success) {
+			tmp = g_strconcat (
+				"TINDEX",
+				"_", field->dbname,
+				"_", ebsql->priv->folderid,
+				NULL);
+			success = ebsql_exec_printf (
+				ebsql,
+				"CREATE INDEX IF NOT EXISTS %Q ON %Q (trigram, uid)",
+				NULL, NULL, NULL, error,
+				tmp, field->trigram_table);
+			g_free (tmp);
+		}
 
-	EBSQL_NOTE (
-		SCHEMA,
-		g_printerr (
-			"SCHEMA: Initialized auxiliary tables (%s)\n",
-			success ? "success" : "failed"));
+		if (success) {
+			tmp = g_strconcat (
+				"TUID_INDEX",
+				"_", field->dbname,
+				"_", ebsql->priv->folderid,
+				NULL);
+			success = ebsql_exec_printf (
+				ebsql,
+				"CREATE INDEX IF NOT EXISTS %Q ON %Q (uid)",
+				NULL, NULL, NULL, error,
+				tmp, field->trigram_table);
+			g_free (tmp);
+		}
+
+		EBSQL_NOTE (
+			SCHEMA,
+			g_printerr (
+				"SCHEMA: Initialized trigram table '%s'\n",
+				field->trigram_table));
+	}
+
+	if (success) {
+		gchar *multivalues;
+
+		multivalues = format_multivalues (ebsql);
+
+		success = ebsql_exec_printf (
+			ebsql,
+			"UPDATE folders SET multivalues=%Q WHERE folder_id=%Q",
+			NULL, NULL, NULL, error,
+			multivalues, ebsql->priv->folderid);
+
+		g_free (multivalues);
+	}
+
+	EBSQL_NOTE (
+		SCHEMA,
+		g_printerr (
+			"SCHEMA: Initialized auxiliary tables (%s)\n",
+			success ? "success" : "failed"));
 
 	return success;
 }
@@ -2771,6 +3338,9 @@ ebsql_set_locale_internal (EBookSqlite *ebsql,
 		if (ebsql->priv->collator)
 			e_collator_unref (ebsql->priv->collator);
 		ebsql->priv->collator = collator;
+
+		/* The alphabetic indexes changed with the collator */
+		ebsql_cursors_invalidate (ebsql);
 	}
 
 	return TRUE;
@@ -3025,6 +3595,7 @@ ebsql_new_internal (const gchar *path,
 	if (success)
 		success = ebsql_init_contacts (
 			ebsql,
+			previous_schema,
 			introspected_columns,
 			error);
 
@@ -3511,6 +4082,146 @@ ebsql_run_multi_insert (EBookSqlite *ebsql,
 	return success;
 }
 
+/* Collects the distinct three character substrings of a
+ * normalized value, characters are counted, not bytes.
+ */
+static void
+ebsql_collect_trigrams (const gchar *normal,
+                        GHashTable *trigrams)
+{
+	const gchar *start, *end;
+	gint n_chars;
+
+	if (!normal)
+		return;
+
+	for (start = normal; *start; start = g_utf8_next_char (start)) {
+		end = start;
+
+		for (n_chars = 0; n_chars < 3 && *end; n_chars++)
+			end = g_utf8_next_char (end);
+
+		if (n_chars < 3)
+			break;
+
+		g_hash_table_add (trigrams, g_strndup (start, end - start));
+	}
+}
+
+static sqlite3_stmt *
+ebsql_prepare_trigram_delete (EBookSqlite *ebsql,
+                              SummaryField *field,
+                              GError **error)
+{
+	sqlite3_stmt *stmt = NULL;
+	gchar *stmt_str;
+
+	stmt_str = sqlite3_mprintf ("DELETE FROM %Q WHERE uid = :uid", field->trigram_table);
+	stmt = ebsql_prepare_statement (ebsql, stmt_str, error);
+	sqlite3_free (stmt_str);
+
+	return stmt;
+}
+
+static sqlite3_stmt *
+ebsql_prepare_trigram_insert (EBookSqlite *ebsql,
+                              SummaryField *field,
+                              GError **error)
+{
+	sqlite3_stmt *stmt = NULL;
+	gchar *stmt_str;
+
+	stmt_str = sqlite3_mprintf (
+		"INSERT INTO %Q (uid, trigram) VALUES (:uid, :trigram)",
+		field->trigram_table);
+	stmt = ebsql_prepare_statement (ebsql, stmt_str, error);
+	sqlite3_free (stmt_str);
+
+	return stmt;
+}
+
+/* Replaces the trigrams stored for 'uid' with the ones of 'contact' */
+static gboolean
+ebsql_run_trigram_update (EBookSqlite *ebsql,
+                          SummaryField *field,
+                          const gchar *uid,
+                          EContact *contact,
+                          GError **error)
+{
+	sqlite3_stmt *stmt;
+	GHashTable *trigrams;
+	GHashTableIter iter;
+	gpointer key;
+	gboolean success;
+	gint ret;
+
+	stmt = g_hash_table_lookup (ebsql->priv->trigram_deletes, GUINT_TO_POINTER (field->field_id));
+
+	sqlite3_reset (stmt);
+	ret = sqlite3_clear_bindings (stmt);
+
+	if (ret == SQLITE_OK)
+		ret = sqlite3_bind_text (stmt, 1, uid, -1, SQLITE_STATIC);
+
+	success = ebsql_complete_statement (ebsql, stmt, ret, error);
+	if (!success)
+		return FALSE;
+
+	trigrams = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	/* Normalize exactly like the summary columns do, so that
+	 * the trigrams of a normalized search term can be found
+	 */
+	if (field->type == E_TYPE_CONTACT_ATTR_LIST) {
+		GList *values, *l;
+
+		values = e_contact_get (contact, field->field_id);
+
+		for (l = values; l != NULL; l = l->next) {
+			gchar *normal = e_util_utf8_normalize (l->data);
+
+			ebsql_collect_trigrams (normal, trigrams);
+			g_free (normal);
+		}
+
+		e_contact_attr_list_free (values);
+	} else {
+		gchar *val, *normal;
+
+		val = e_contact_get (contact, field->field_id);
+
+		if (field->field_id != E_CONTACT_UID &&
+		    field->field_id != E_CONTACT_REV)
+			normal = e_util_utf8_normalize (val);
+		else
+			normal = g_strdup (val);
+
+		ebsql_collect_trigrams (normal, trigrams);
+
+		g_free (normal);
+		g_free (val);
+	}
+
+	stmt = g_hash_table_lookup (ebsql->priv->trigram_inserts, GUINT_TO_POINTER (field->field_id));
+
+	g_hash_table_iter_init (&iter, trigrams);
+	while (success && g_hash_table_iter_next (&iter, &key, NULL)) {
+
+		/* :uid */
+		ret = sqlite3_bind_text (stmt, 1, uid, -1, SQLITE_STATIC);
+
+		/* :trigram */
+		if (ret == SQLITE_OK)
+			ret = sqlite3_bind_text (stmt, 2, key, -1, SQLITE_STATIC);
+
+		success = ebsql_complete_statement (ebsql, stmt, ret, error);
+	}
+
+	g_hash_table_destroy (trigrams);
+
+	return success;
+}
+
 static sqlite3_stmt *
 ebsql_prepare_insert (EBookSqlite *ebsql,
                       gboolean replace_existing,
@@ -3577,7 +4288,7 @@ ebsql_prepare_insert (EBookSqlite *ebsql,
 			}
 		}
 	}
-	g_string_append (string, ", vcard, bdata)");
+	g_string_append (string, ", vcard, bvcard, bdata)");
 
 	/*
 	 * Now specify values for all of the column names we specified.
@@ -3616,7 +4327,7 @@ ebsql_prepare_insert (EBookSqlite *ebsql,
 			g_warn_if_reached ();
 	}
 
-	g_string_append (string, ", :vcard, :bdata)");
+	g_string_append (string, ", :vcard, :bvcard, :bdata)");
 
 	stmt = ebsql_prepare_statement (ebsql, string->str, error);
 	g_string_free (string, TRUE);
@@ -3624,6 +4335,20 @@ ebsql_prepare_insert (EBookSqlite *ebsql,
 	return stmt;
 }
 
+static sqlite3_stmt *
+ebsql_prepare_fetch_bvcard (EBookSqlite *ebsql,
+                            GError **error)
+{
+	sqlite3_stmt *stmt = NULL;
+	gchar *stmt_str;
+
+	stmt_str = sqlite3_mprintf ("SELECT bvcard FROM %Q WHERE uid = :uid", ebsql->priv->folderid);
+	stmt = ebsql_prepare_statement (ebsql, stmt_str, error);
+	sqlite3_free (stmt_str);
+
+	return stmt;
+}
+
 static gboolean
 ebsql_init_statements (EBookSqlite *ebsql,
                        GError **error)
@@ -3639,6 +4364,10 @@ ebsql_init_statements (EBookSqlite *ebsql,
 	if (!ebsql->priv->replace_stmt)
 		goto preparation_failed;
 
+	ebsql->priv->bvcard_stmt = ebsql_prepare_fetch_bvcard (ebsql, error);
+	if (!ebsql->priv->bvcard_stmt)
+		goto preparation_failed;
+
 	ebsql->priv->multi_deletes =
 		g_hash_table_new_full (
 			g_direct_hash, g_direct_equal,
@@ -3649,10 +4378,43 @@ ebsql_init_statements (EBookSqlite *ebsql,
 			g_direct_hash, g_direct_equal,
 			NULL,
 			(GDestroyNotify) sqlite3_finalize);
+	ebsql->priv->trigram_deletes =
+		g_hash_table_new_full (
+			g_direct_hash, g_direct_equal,
+			NULL,
+			(GDestroyNotify) sqlite3_finalize);
+	ebsql->priv->trigram_inserts =
+		g_hash_table_new_full (
+			g_direct_hash, g_direct_equal,
+			NULL,
+			(GDestroyNotify) sqlite3_finalize);
 
 	for (i = 0; i < ebsql->priv->n_summary_fields; i++) {
 		SummaryField *field = &(ebsql->priv->summary_fields[i]);
 
+		if ((field->index & INDEX_FLAG (TRIGRAM)) != 0 &&
+		    (field->type == G_TYPE_STRING ||
+		     field->type == E_TYPE_CONTACT_ATTR_LIST)) {
+
+			stmt = ebsql_prepare_trigram_insert (ebsql, field, error);
+			if (!stmt)
+				goto preparation_failed;
+
+			g_hash_table_insert (
+				ebsql->priv->trigram_inserts,
+				GUINT_TO_POINTER (field->field_id),
+				stmt);
+
+			stmt = ebsql_prepare_trigram_delete (ebsql, field, error);
+			if (!stmt)
+				goto preparation_failed;
+
+			g_hash_table_insert (
+				ebsql->priv->trigram_deletes,
+				GUINT_TO_POINTER (field->field_id),
+				stmt);
+		}
+
 		if (field->type != E_TYPE_CONTACT_ATTR_LIST)
 			continue;
 
@@ -3806,6 +4568,17 @@ ebsql_run_insert (EBookSqlite *ebsql,
 		ret = sqlite3_bind_text (stmt, param_idx++, vcard, -1, g_free);
 	}
 
+	/* The binary vcard, only stored along with the vcard text */
+	if (ret == SQLITE_OK) {
+		guint8 *bvcard = NULL;
+		gsize bvcard_len = 0;
+
+		if (priv->vcard_callback == NULL && priv->store_bvcards)
+			bvcard = ebsql_bvcard_encode (E_VCARD (contact), &bvcard_len);
+
+		ret = sqlite3_bind_blob (stmt, param_idx++, bvcard, bvcard_len, g_free);
+	}
+
 	/* The extra data */
 	if (ret == SQLITE_OK)
 		ret = sqlite3_bind_text (stmt, param_idx++, g_strdup (extra), -1, g_free);
@@ -3865,8 +4638,17 @@ ebsql_insert_contact (EBookSqlite *ebsql,
 		vcard = g_strdup (original_vcard);
 	}
 
+	/* Take the replaced contact out of the cursor counts first */
+	if (replace)
+		success = ebsql_cursors_track_uid (ebsql, uid, -1, error);
+	else
+		success = TRUE;
+
 	/* This actually consumes 'vcard' */
-	success = ebsql_run_insert (ebsql, replace, contact, vcard, extra, error);
+	if (success)
+		success = ebsql_run_insert (ebsql, replace, contact, vcard, extra, error);
+	else
+		g_free (vcard);
 
 	/* Update attribute list table */
 	if (success) {
@@ -3885,8 +4667,23 @@ ebsql_insert_contact (EBookSqlite *ebsql,
 				success = ebsql_run_multi_insert (
 					ebsql, field, uid, contact, error);
 		}
+
+		/* Update the trigram tables */
+		for (i = 0; success && i < priv->n_summary_fields; i++) {
+			SummaryField *field = &(ebsql->priv->summary_fields[i]);
+
+			if (!g_hash_table_contains (priv->trigram_inserts,
+						    GUINT_TO_POINTER (field->field_id)))
+				continue;
+
+			success = ebsql_run_trigram_update (
+				ebsql, field, uid, contact, error);
+		}
 	}
 
+	if (success)
+		success = ebsql_cursors_track_uid (ebsql, uid, 1, error);
+
 	g_free (uid);
 
 	return success;
@@ -3996,13 +4793,14 @@ typedef struct {
 } QueryPhoneTest;
 
 /* Stack initializer for the PreflightContext struct below */
-#define PREFLIGHT_CONTEXT_INIT { PREFLIGHT_OK, NULL, 0, FALSE }
+#define PREFLIGHT_CONTEXT_INIT { PREFLIGHT_OK, NULL, 0, FALSE, NULL }
 
 typedef struct {
 	PreflightStatus  status;         /* result status */
 	GPtrArray       *constraints;    /* main query; may be NULL */
 	guint64          aux_mask;       /* Bitmask of which auxiliary tables are needed in the query */
 	guint64          left_join_mask; /* Do we need to use a LEFT JOIN */
+	const gchar     *projection;     /* Comma separated vCard attributes, for SEARCH_PROJECTED */
 } PreflightContext;
 
 static QueryElement *
@@ -5112,6 +5910,77 @@ ebsql_normalize_for_like (QueryFieldTest *test,
 	return g_string_free (str, FALSE);
 }
 
+/* For fields with a trigram index, this narrows a contains or ends-with
+ * test down to the contacts which hold some trigrams of the value, spread
+ * over its length. The LIKE comparison appended after it keeps the
+ * result exact, so the test is skipped for values shorter than a trigram.
+ */
+static void
+ebsql_string_append_trigram_filter (GString *string,
+                                    QueryFieldTest *test)
+{
+	SummaryField *field = test->field;
+	GPtrArray *starts;
+	GHashTable *trigrams;
+	const gchar *ptr;
+	gchar *normal;
+	gint n_trigrams, n_picks, ii;
+	gboolean first = TRUE;
+
+	if ((field->index & INDEX_FLAG (TRIGRAM)) == 0 || !test->value)
+		return;
+
+	if (test->field_id == E_CONTACT_UID ||
+	    test->field_id == E_CONTACT_REV)
+		normal = g_strdup (test->value);
+	else
+		normal = e_util_utf8_normalize (test->value);
+
+	starts = g_ptr_array_new ();
+	for (ptr = normal; ptr && *ptr; ptr = g_utf8_next_char (ptr))
+		g_ptr_array_add (starts, (gpointer) ptr);
+
+	/* Terminate with the position past the last character */
+	g_ptr_array_add (starts, (gpointer) ptr);
+
+	n_trigrams = (gint) starts->len - 3;
+	if (n_trigrams <= 0) {
+		g_ptr_array_free (starts, TRUE);
+		g_free (normal);
+		return;
+	}
+
+	n_picks = MIN (n_trigrams, EBSQL_MAX_TRIGRAMS_PER_TEST);
+	trigrams = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	g_string_append (string, "summary.uid IN (");
+
+	for (ii = 0; ii < n_picks; ii++) {
+		gint pos = n_picks > 1 ? ii * (n_trigrams - 1) / (n_picks - 1) : 0;
+		const gchar *start = starts->pdata[pos];
+		const gchar *end = starts->pdata[pos + 3];
+		gchar *trigram;
+
+		trigram = g_strndup (start, end - start);
+		if (!g_hash_table_add (trigrams, trigram))
+			continue;
+
+		if (!first)
+			g_string_append (string, " INTERSECT ");
+		first = FALSE;
+
+		ebsql_string_append_printf (
+			string, "SELECT uid FROM %Q WHERE trigram = %Q",
+			field->trigram_table, trigram);
+	}
+
+	g_string_append (string, ") AND ");
+
+	g_hash_table_destroy (trigrams);
+	g_ptr_array_free (starts, TRUE);
+	g_free (normal);
+}
+
 static void
 field_test_query_is (EBookSqlite *ebsql,
                      GString *string,
@@ -5146,6 +6015,8 @@ field_test_query_contains (EBookSqlite *ebsql,
 
 	g_string_append_c (string, '(');
 
+	ebsql_string_append_trigram_filter (string, test);
+
 	ebsql_string_append_column (string, field, NULL);
 	g_string_append (string, " IS NOT NULL AND ");
 	ebsql_string_append_column (string, field, NULL);
@@ -5215,6 +6086,8 @@ field_test_query_ends_with (EBookSqlite *ebsql,
 		escaped = ebsql_normalize_for_like (test, FALSE, &need_escape);
 		g_string_append_c (string, '(');
 
+		ebsql_string_append_trigram_filter (string, test);
+
 		ebsql_string_append_column (string, field, NULL);
 		g_string_append (string, " IS NOT NULL AND ");
 
@@ -5384,6 +6257,7 @@ static const GenerateFieldTest field_test_func_table[] = {
 typedef enum {
 	SEARCH_FULL,          /* Get a list of EbSqlSearchData */
 	SEARCH_UID_AND_REV,   /* Get a list of EbSqlSearchData, with shallow vcards only containing UID & REV */
+	SEARCH_PROJECTED,     /* Get a list of EbSqlSearchData, with vcards only containing the context's projection */
 	SEARCH_UID,           /* Get a list of UID strings */
 	SEARCH_COUNT,         /* Get the number of matching rows */
 } SearchType;
@@ -5404,7 +6278,7 @@ ebsql_generate_constraints (EBookSqlite *ebsql,
 	if (constraints == NULL) {
 		ebsql_string_append_printf (
 			string,
-			EBSQL_FUNC_COMPARE_VCARD " (%Q, %s)",
+			EBSQL_FUNC_COMPARE_VCARD " (%Q, summary.bvcard, %s)",
 			sexp, EBSQL_VCARD_FRAGMENT (ebsql));
 		return;
 	}
@@ -5536,6 +6410,16 @@ ebsql_generate_select (EBookSqlite *ebsql,
 		callback = collect_lean_results_cb;
 		g_string_append (string, "summary.uid, summary.Rev, summary.bdata ");
 		break;
+	case SEARCH_PROJECTED:
+		/* The vcard text is only read for rows without a binary form */
+		callback = collect_full_results_cb;
+		ebsql_string_append_printf (
+			string,
+			"summary.uid, " EBSQL_FUNC_PROJECT_VCARD " (%Q, summary.bvcard, "
+			"CASE WHEN summary.bvcard IS NULL THEN %s END) AS vcard, summary.bdata ",
+			context->projection ? context->projection : "",
+			EBSQL_VCARD_FRAGMENT (ebsql));
+		break;
 	case SEARCH_UID:
 		callback = collect_uid_results_cb;
 		g_string_append (string, "summary.uid ");
@@ -5712,7 +6596,8 @@ ebsql_do_search_query (EBookSqlite *ebsql,
                        PreflightContext *context,
                        const gchar *sexp,
                        SearchType search_type,
-                       GSList **return_data,
+                       EbSqlRowFunc row_func,
+                       gpointer return_data,
                        GCancellable *cancellable,
                        GError **error)
 {
@@ -5748,7 +6633,7 @@ ebsql_do_search_query (EBookSqlite *ebsql,
 	if (callback)
 		success = ebsql_exec (
 			ebsql, string->str,
-			callback, return_data,
+			row_func ? row_func : callback, return_data,
 			cancellable, error);
 
 	g_string_free (string, TRUE);
@@ -5760,7 +6645,10 @@ ebsql_do_search_query (EBookSqlite *ebsql,
  * @ebsql: An EBookSqlite
  * @sexp: The search expression, or NULL for all contacts
  * @search_type: Indicates what kind of data should be returned
- * @return_data: A list of data fetched from the DB, as specified by 'search_type'
+ * @projection: The comma separated vCard attributes for SEARCH_PROJECTED
+ * @row_func: A function to receive each row, or NULL to collect the rows
+ * @return_data: The data for @row_func, or the location of a GSList to
+ *               collect the rows to, as specified by 'search_type'
  * @error: Location to store any error which may have occurred
  *
  * This is the main common entry point for querying contacts.
@@ -5772,7 +6660,9 @@ static gboolean
 ebsql_search_query (EBookSqlite *ebsql,
                     const gchar *sexp,
                     SearchType search_type,
-                    GSList **return_data,
+                    const gchar *projection,
+                    EbSqlRowFunc row_func,
+                    gpointer return_data,
                     GCancellable *cancellable,
                     GError **error)
 {
@@ -5781,6 +6671,7 @@ ebsql_search_query (EBookSqlite *ebsql,
 
 	/* Now start with the query preflighting */
 	query_preflight (&context, ebsql, sexp);
+	context.projection = projection;
 
 	switch (context.status) {
 	case PREFLIGHT_OK:
@@ -5789,7 +6680,7 @@ ebsql_search_query (EBookSqlite *ebsql,
 		/* No errors, let's really search */
 		success = ebsql_do_search_query (
 			ebsql, &context, sexp,
-			search_type, return_data,
+			search_type, row_func, return_data,
 			cancellable, error);
 		break;
 
@@ -5832,6 +6723,7 @@ struct _EbSqlCursor {
 	EBookBackendSExp *sexp;       /* An EBookBackendSExp based on the query, used by e_book_sqlite_cursor_compare () */
 	gchar         *select_vcards; /* The first fragment when querying results */
 	gchar         *select_count;  /* The first fragment when querying contact counts */
+	gchar         *select_uids;   /* The first fragment when querying the uids of matching contacts */
 	gchar         *query;         /* The SQL query expression derived from the passed search expression */
 	gchar         *order;         /* The normal order SQL query fragment to append at the end, containing ORDER BY etc */
 	gchar         *reverse_order; /* The reverse order SQL query fragment to append at the end, containing ORDER BY etc */
@@ -5841,6 +6733,14 @@ struct _EbSqlCursor {
 	gint                 n_sort_fields; /* The amound of sort fields */
 
 	CursorState          state;
+
+	/* Cached counts of the matching contacts per alphabetic index,
+	 * only used when the first sort field has a sort key column */
+	gint                *counts;       /* The counts, or NULL until calculated */
+	gint                *pending;      /* Changes to the counts by the current transaction */
+	gint                 n_counts;     /* The amount of alphabetic indexes */
+	gint                 n_pending;    /* The amount of contacts changed by the current transaction */
+	gint                 data_version; /* SQLite's data_version when the counts were calculated */
 };
 
 static CursorState *cursor_state_copy             (EbSqlCursor          *cursor,
@@ -5955,6 +6855,18 @@ cursor_state_set_from_vcard (EBookSqlite *ebsql,
 	g_object_unref (contact);
 }
 
+static void
+cursor_counts_clear (EbSqlCursor *cursor)
+{
+	g_free (cursor->counts);
+	g_free (cursor->pending);
+
+	cursor->counts = NULL;
+	cursor->pending = NULL;
+	cursor->n_counts = 0;
+	cursor->n_pending = 0;
+}
+
 static gboolean
 ebsql_cursor_setup_query (EBookSqlite *ebsql,
                           EbSqlCursor *cursor,
@@ -5983,9 +6895,13 @@ ebsql_cursor_setup_query (EBookSqlite *ebsql,
 	/* Now we caught the errors, let's generate our queries and get out of here ... */
 	g_free (cursor->select_vcards);
 	g_free (cursor->select_count);
+	g_free (cursor->select_uids);
 	g_free (cursor->query);
 	g_clear_object (&(cursor->sexp));
 
+	/* The counts belong to the previous query */
+	cursor_counts_clear (cursor);
+
 	/* Generate the leading SELECT portions that we need */
 	string = g_string_new ("");
 	ebsql_generate_select (ebsql, string, SEARCH_FULL, &context, NULL);
@@ -5995,6 +6911,10 @@ ebsql_cursor_setup_query (EBookSqlite *ebsql,
 	ebsql_generate_select (ebsql, string, SEARCH_COUNT, &context, NULL);
 	cursor->select_count = g_string_free (string, FALSE);
 
+	string = g_string_new ("");
+	ebsql_generate_select (ebsql, string, SEARCH_UID, &context, NULL);
+	cursor->select_uids = g_string_free (string, FALSE);
+
 	if (sexp == NULL || context.status == PREFLIGHT_LIST_ALL) {
 		cursor->query = NULL;
 		cursor->sexp = NULL;
@@ -6094,9 +7014,12 @@ ebsql_cursor_free (EbSqlCursor *cursor)
 		cursor_state_clear (cursor, &(cursor->state), EBSQL_CURSOR_ORIGIN_BEGIN);
 		g_free (cursor->state.values);
 
+		cursor_counts_clear (cursor);
+
 		g_clear_object (&(cursor->sexp));
 		g_free (cursor->select_vcards);
 		g_free (cursor->select_count);
+		g_free (cursor->select_uids);
 		g_free (cursor->query);
 		g_free (cursor->order);
 		g_free (cursor->reverse_order);
@@ -6256,44 +7179,411 @@ ebsql_cursor_constraints (EBookSqlite *ebsql,
 	return g_string_free (string, FALSE);
 }
 
-static gboolean
-cursor_count_total_locked (EBookSqlite *ebsql,
-                           EbSqlCursor *cursor,
-                           gint *total,
-                           GError **error)
+/* The first sort field, if the alphabetic index
+ * of the contacts can be read from its sort key column
+ */
+static SummaryField *
+cursor_counts_field (EBookSqlite *ebsql,
+                     EbSqlCursor *cursor)
 {
-	GString *query;
-	gboolean success;
-
-	query = g_string_new (cursor->select_count);
-
-	/* Add the filter constraints (if any) */
-	if (cursor->query) {
-		g_string_append (query, " WHERE ");
+	SummaryField *field = summary_field_get (ebsql, cursor->sort_fields[0]);
 
-		g_string_append_c (query, '(');
-		g_string_append (query, cursor->query);
-		g_string_append_c (query, ')');
-	}
+	if (field && (field->index & INDEX_FLAG (SORT_KEY)) != 0)
+		return field;
 
-	/* Execute the query */
-	success = ebsql_exec (ebsql, query->str, get_count_cb, total, NULL, error);
+	return NULL;
+}
 
-	g_string_free (query, TRUE);
+/* ECollator sort keys start with the alphabetic index formatted as
+ * "%03d", which is also the key e_collator_generate_key_for_index()
+ * returns. Missing values are stored as empty keys, in the first index.
+ */
+static gint
+cursor_counts_index_for_key (const gchar *key)
+{
+	if (key &&
+	    g_ascii_isdigit (key[0]) &&
+	    g_ascii_isdigit (key[1]) &&
+	    g_ascii_isdigit (key[2]))
+		return (key[0] - '0') * 100 + (key[1] - '0') * 10 + (key[2] - '0');
 
-	return success;
+	return 0;
 }
 
-static gboolean
-cursor_count_position_locked (EBookSqlite *ebsql,
-                              EbSqlCursor *cursor,
-                              gint *position,
-                              GError **error)
+static void
+cursor_counts_append_index (GString *string,
+                            SummaryField *field)
 {
-	GString *query;
-	gboolean success;
+	g_string_append (string, "CAST (substr (summary.");
+	g_string_append (string, field->dbname);
+	g_string_append (string, "_" EBSQL_SUFFIX_SORT_KEY ", 1, 3) AS INTEGER)");
+}
 
-	query = g_string_new (cursor->select_count);
+typedef struct {
+	gint *counts;
+	gint n_counts;
+	gboolean out_of_range;
+} CursorCountsData;
+
+static gint
+collect_cursor_counts_cb (gpointer ref,
+                          gint n_cols,
+                          gchar **cols,
+                          gchar **names)
+{
+	CursorCountsData *data = ref;
+	gint idx;
+
+	idx = cols[0] ? g_ascii_strtoll (cols[0], NULL, 10) : 0;
+
+	if (idx < 0 || idx >= data->n_counts)
+		data->out_of_range = TRUE;
+	else
+		data->counts[idx] = cols[1] ? g_ascii_strtoll (cols[1], NULL, 10) : 0;
+
+	return 0;
+}
+
+/* Counts the matching contacts per alphabetic index with a
+ * single query, leaves cursor->counts unset if they cannot
+ * be used */
+static gboolean
+cursor_counts_load_locked (EBookSqlite *ebsql,
+                           EbSqlCursor *cursor,
+                           SummaryField *field,
+                           gint data_version,
+                           GError **error)
+{
+	CursorCountsData data = { NULL, 0, FALSE };
+	GString *query;
+	gboolean success;
+
+	e_collator_get_index_labels (
+		ebsql->priv->collator, &data.n_counts,
+		NULL, NULL, NULL);
+	data.counts = g_new0 (gint, MAX (data.n_counts, 1));
+
+	query = g_string_new ("SELECT ");
+	cursor_counts_append_index (query, field);
+	ebsql_string_append_printf (
+		query, " AS idx, count (*) FROM %Q AS summary",
+		ebsql->priv->folderid);
+
+	if (cursor->query) {
+		g_string_append (query, " WHERE summary.uid IN (");
+		g_string_append (query, cursor->select_uids);
+		g_string_append (query, " WHERE (");
+		g_string_append (query, cursor->query);
+		g_string_append (query, "))");
+	}
+
+	g_string_append (query, " GROUP BY idx");
+
+	success = ebsql_exec (
+		ebsql, query->str,
+		collect_cursor_counts_cb, &data,
+		NULL, error);
+
+	g_string_free (query, TRUE);
+
+	cursor_counts_clear (cursor);
+
+	if (success && !data.out_of_range) {
+		cursor->counts = data.counts;
+		cursor->n_counts = data.n_counts;
+		cursor->data_version = data_version;
+	} else {
+		g_free (data.counts);
+	}
+
+	EBSQL_NOTE (
+		CURSOR,
+		g_printerr (
+			"Counted cursor contacts per alphabetic index (%s)\n",
+			cursor->counts ? "success" : "failed"));
+
+	return success;
+}
+
+/* The position is the count of contacts in the indexes before
+ * the one of the cursor value, plus the ones before the cursor
+ * value in its own index */
+static gboolean
+cursor_counts_position_locked (EBookSqlite *ebsql,
+                               EbSqlCursor *cursor,
+                               SummaryField *field,
+                               gint total,
+                               gint *position,
+                               gboolean *calculated,
+                               GError **error)
+{
+	const gchar *value = cursor->state.values[0];
+	gboolean ascending;
+	gint idx, i, before = 0, within = 0;
+	gboolean success = TRUE;
+
+	if (value == NULL) {
+		*position = total;
+		*calculated = TRUE;
+		return TRUE;
+	}
+
+	idx = cursor_counts_index_for_key (value);
+	if (idx >= cursor->n_counts)
+		return TRUE;
+
+	ascending = cursor->sort_types[0] == E_BOOK_CURSOR_SORT_ASCENDING;
+
+	for (i = 0; i < cursor->n_counts; i++) {
+		if (ascending ? i < idx : i > idx)
+			before += cursor->counts[i];
+	}
+
+	if (cursor->counts[idx] == 0) {
+		within = 0;
+	} else if (idx > 0 && strlen (value) == 3) {
+		/* The cursor targets an alphabetic index, which
+		 * sorts before all the keys in that index */
+		within = ascending ? 0 : cursor->counts[idx];
+	} else {
+		GString *query;
+		gchar *constraints;
+
+		query = g_string_new (cursor->select_count);
+		g_string_append (query, " WHERE ");
+
+		if (cursor->query) {
+			g_string_append_c (query, '(');
+			g_string_append (query, cursor->query);
+			g_string_append (query, ") AND ");
+		}
+
+		/* Only look into the alphabetic index of the cursor value */
+		if (idx > 0)
+			ebsql_string_append_printf (
+				query, "summary.%s_" EBSQL_SUFFIX_SORT_KEY " >= '%03d' AND ",
+				field->dbname, idx);
+
+		ebsql_string_append_printf (
+			query, "summary.%s_" EBSQL_SUFFIX_SORT_KEY " < '%03d'",
+			field->dbname, idx + 1);
+
+		constraints = ebsql_cursor_constraints (
+			ebsql, cursor, &(cursor->state), TRUE, TRUE);
+
+		g_string_append (query, " AND (");
+		g_string_append (query, constraints);
+		g_string_append_c (query, ')');
+
+		g_free (constraints);
+
+		success = ebsql_exec (ebsql, query->str, get_count_cb, &within, NULL, error);
+
+		g_string_free (query, TRUE);
+	}
+
+	if (success) {
+		*position = before + within;
+		*calculated = TRUE;
+	}
+
+	return success;
+}
+
+/* Calculates the total and position from the cached counts, loading
+ * them first if needed. Sets @calculated to FALSE if the counts cannot
+ * be used for @cursor, the COUNT queries are needed then.
+ */
+static gboolean
+cursor_counts_calculate_locked (EBookSqlite *ebsql,
+                                EbSqlCursor *cursor,
+                                gint *total,
+                                gint *position,
+                                gboolean *calculated,
+                                GError **error)
+{
+	SummaryField *field;
+	gint data_version = -1;
+	gint n_total = 0;
+	gint i;
+
+	*calculated = FALSE;
+
+	field = cursor_counts_field (ebsql, cursor);
+	if (field == NULL)
+		return TRUE;
+
+	/* Only keep counts of committed contacts */
+	if (ebsql->priv->in_transaction > 1)
+		return TRUE;
+
+	/* Notices changes made through other connections, like the ones
+	 * of the addressbook factory while reading in Direct Read Access
+	 * mode. Older SQLite versions return nothing, the counts cannot
+	 * be kept then. */
+	if (!ebsql_exec (ebsql, "PRAGMA data_version", get_int_cb, &data_version, NULL, error))
+		return FALSE;
+
+	if (data_version < 0)
+		return TRUE;
+
+	if (cursor->counts && cursor->data_version != data_version)
+		cursor_counts_clear (cursor);
+
+	if (!cursor->counts) {
+		if (!cursor_counts_load_locked (ebsql, cursor, field, data_version, error))
+			return FALSE;
+
+		if (!cursor->counts)
+			return TRUE;
+	}
+
+	for (i = 0; i < cursor->n_counts; i++)
+		n_total += cursor->counts[i];
+
+	if (total)
+		*total = n_total;
+
+	if (position)
+		return cursor_counts_position_locked (
+			ebsql, cursor, field, n_total,
+			position, calculated, error);
+
+	*calculated = TRUE;
+
+	return TRUE;
+}
+
+static void
+ebsql_cursors_invalidate (EBookSqlite *ebsql)
+{
+	GSList *l;
+
+	for (l = ebsql->priv->cursors; l; l = l->next)
+		cursor_counts_clear (l->data);
+}
+
+/* Records the change of a contact in the cached counts of the
+ * cursors it matches, they are applied once the transaction
+ * is committed */
+static gboolean
+ebsql_cursors_track_uid (EBookSqlite *ebsql,
+                         const gchar *uid,
+                         gint delta,
+                         GError **error)
+{
+	GSList *l;
+	gboolean success = TRUE;
+
+	for (l = ebsql->priv->cursors; success && l; l = l->next) {
+		EbSqlCursor *cursor = l->data;
+		GString *query;
+		gint idx = -1;
+
+		if (cursor->counts == NULL)
+			continue;
+
+		if (cursor->n_pending >= EBSQL_CURSOR_MAX_PENDING) {
+			cursor_counts_clear (cursor);
+			continue;
+		}
+
+		query = g_string_new ("SELECT ");
+		cursor_counts_append_index (query, cursor_counts_field (ebsql, cursor));
+		ebsql_string_append_printf (
+			query, " FROM %Q AS summary WHERE summary.uid = %Q",
+			ebsql->priv->folderid, uid);
+
+		if (cursor->query) {
+			g_string_append (query, " AND summary.uid IN (");
+			g_string_append (query, cursor->select_uids);
+			g_string_append (query, " WHERE (");
+			g_string_append (query, cursor->query);
+			ebsql_string_append_printf (query, ") AND summary.uid = %Q)", uid);
+		}
+
+		success = ebsql_exec (ebsql, query->str, get_int_cb, &idx, NULL, error);
+
+		g_string_free (query, TRUE);
+
+		/* Not stored or not matching the query */
+		if (!success || idx < 0)
+			continue;
+
+		if (idx >= cursor->n_counts) {
+			cursor_counts_clear (cursor);
+			continue;
+		}
+
+		if (cursor->pending == NULL)
+			cursor->pending = g_new0 (gint, cursor->n_counts);
+
+		cursor->pending[idx] += delta;
+		cursor->n_pending++;
+	}
+
+	return success;
+}
+
+static void
+ebsql_cursors_end_transaction (EBookSqlite *ebsql,
+                               gboolean committed)
+{
+	GSList *l;
+
+	for (l = ebsql->priv->cursors; l; l = l->next) {
+		EbSqlCursor *cursor = l->data;
+		gint i;
+
+		if (committed && cursor->counts && cursor->pending) {
+			for (i = 0; i < cursor->n_counts; i++)
+				cursor->counts[i] += cursor->pending[i];
+		}
+
+		g_free (cursor->pending);
+		cursor->pending = NULL;
+		cursor->n_pending = 0;
+	}
+}
+
+static gboolean
+cursor_count_total_locked (EBookSqlite *ebsql,
+                           EbSqlCursor *cursor,
+                           gint *total,
+                           GError **error)
+{
+	GString *query;
+	gboolean success;
+
+	query = g_string_new (cursor->select_count);
+
+	/* Add the filter constraints (if any) */
+	if (cursor->query) {
+		g_string_append (query, " WHERE ");
+
+		g_string_append_c (query, '(');
+		g_string_append (query, cursor->query);
+		g_string_append_c (query, ')');
+	}
+
+	/* Execute the query */
+	success = ebsql_exec (ebsql, query->str, get_count_cb, total, NULL, error);
+
+	g_string_free (query, TRUE);
+
+	return success;
+}
+
+static gboolean
+cursor_count_position_locked (EBookSqlite *ebsql,
+                              EbSqlCursor *cursor,
+                              gint *position,
+                              GError **error)
+{
+	GString *query;
+	gboolean success;
+
+	query = g_string_new (cursor->select_count);
 
 	/* Add the filter constraints (if any) */
 	if (cursor->query) {
@@ -6363,6 +7653,7 @@ e_book_sqlite_finalize (GObject *object)
 	g_free (priv->path);
 	g_free (priv->locale);
 	g_free (priv->region_code);
+	g_slist_free (priv->cursors);
 
 	if (priv->collator)
 		e_collator_unref (priv->collator);
@@ -6378,11 +7669,18 @@ e_book_sqlite_finalize (GObject *object)
 	if (priv->multi_inserts)
 		g_hash_table_destroy (priv->multi_inserts);
 
+	if (priv->trigram_deletes)
+		g_hash_table_destroy (priv->trigram_deletes);
+
+	if (priv->trigram_inserts)
+		g_hash_table_destroy (priv->trigram_inserts);
+
 	if (priv->user_data && priv->user_data_destroy)
 		priv->user_data_destroy (priv->user_data);
 
 	sqlite3_finalize (priv->insert_stmt);
 	sqlite3_finalize (priv->replace_stmt);
+	sqlite3_finalize (priv->bvcard_stmt);
 	sqlite3_close (priv->db);
 
 	EBSQL_NOTE (REF_COUNTS, g_printerr ("EBookSqlite finalized\n"));
@@ -6884,6 +8182,52 @@ e_book_sqlite_ref_source (EBookSqlite *ebsql)
 	return g_object_ref (ebsql->priv->source);
 }
 
+/**
+ * e_book_sqlite_set_store_bvcards:
+ * @ebsql: An #EBookSqlite
+ * @store_bvcards: Whether to store contacts in binary form as well
+ *
+ * Sets whether contacts written from now on are also stored in a
+ * pre-parsed binary form, next to their vCard text.  Contacts are then
+ * built from the binary form without parsing the vCard, and queries on
+ * fields which are not in the summary decode it instead of the text.
+ * This costs the space of a second copy of every contact, photos
+ * included, so it only pays off for books which are read much more
+ * often than they are written.
+ *
+ * It is off by default, and has no effect on books which do not store
+ * vCards (see e_book_sqlite_new_full()).
+ *
+ * Since: 3.20
+ **/
+void
+e_book_sqlite_set_store_bvcards (EBookSqlite *ebsql,
+                                 gboolean store_bvcards)
+{
+	g_return_if_fail (E_IS_BOOK_SQLITE (ebsql));
+
+	EBSQL_LOCK_MUTEX (&ebsql->priv->lock);
+	ebsql->priv->store_bvcards = store_bvcards;
+	EBSQL_UNLOCK_MUTEX (&ebsql->priv->lock);
+}
+
+/**
+ * e_book_sqlite_get_store_bvcards:
+ * @ebsql: An #EBookSqlite
+ *
+ * Returns: Whether contacts are also stored in binary form,
+ * see e_book_sqlite_set_store_bvcards().
+ *
+ * Since: 3.20
+ **/
+gboolean
+e_book_sqlite_get_store_bvcards (EBookSqlite *ebsql)
+{
+	g_return_val_if_fail (E_IS_BOOK_SQLITE (ebsql), FALSE);
+
+	return ebsql->priv->store_bvcards;
+}
+
 /**
  * e_book_sqlitedb_add_contact:
  * @ebsql: An #EBookSqlite
@@ -7106,6 +8450,10 @@ e_book_sqlite_remove_contacts (EBookSqlite *ebsql,
 			       &success);
 	}
 
+	/* Update the cursor counts while the contacts can still be matched */
+	for (l = uids; success && l; l = l->next)
+		success = ebsql_cursors_track_uid (ebsql, l->data, -1, error);
+
 	/* Delete data from the auxiliary tables first */
 	for (i = 0; success && i < ebsql->priv->n_summary_fields; i++) {
 		SummaryField *field = &(ebsql->priv->summary_fields[i]);
@@ -7118,6 +8466,19 @@ e_book_sqlite_remove_contacts (EBookSqlite *ebsql,
 		g_free (stmt);
 	}
 
+	/* And from the trigram tables */
+	for (i = 0; success && i < ebsql->priv->n_summary_fields; i++) {
+		SummaryField *field = &(ebsql->priv->summary_fields[i]);
+
+		if (!g_hash_table_contains (ebsql->priv->trigram_deletes,
+					    GUINT_TO_POINTER (field->field_id)))
+			continue;
+
+		stmt = generate_delete_stmt (field->trigram_table, uids);
+		success = ebsql_exec (ebsql, stmt, NULL, NULL, NULL, error);
+		g_free (stmt);
+	}
+
 	/* Now delete the entry from the main contacts */
 	if (success) {
 		stmt = generate_delete_stmt (ebsql->priv->folderid, uids);
@@ -7175,6 +8536,49 @@ e_book_sqlite_has_contact (EBookSqlite *ebsql,
 	return success;
 }
 
+/* Builds the contact for 'uid' from its binary vcard, 'ret_contact' is
+ * left NULL if there is no such contact or it was stored without one.
+ */
+static gboolean
+ebsql_get_contact_from_bvcard (EBookSqlite *ebsql,
+                               const gchar *uid,
+                               EContact **ret_contact,
+                               GError **error)
+{
+	sqlite3_stmt *stmt = ebsql->priv->bvcard_stmt;
+	gint ret;
+
+	if (ebsql->priv->vcard_callback != NULL || !ebsql->priv->store_bvcards)
+		return TRUE;
+
+	sqlite3_reset (stmt);
+	ret = sqlite3_clear_bindings (stmt);
+
+	if (ret == SQLITE_OK)
+		ret = sqlite3_bind_text (stmt, 1, uid, -1, SQLITE_STATIC);
+
+	if (ret == SQLITE_OK)
+		ret = sqlite3_step (stmt);
+
+	if (ret == SQLITE_ROW) {
+		*ret_contact = ebsql_bvcard_decode (
+			sqlite3_column_blob (stmt, 0),
+			sqlite3_column_bytes (stmt, 0),
+			NULL);
+		ret = SQLITE_DONE;
+	}
+
+	if (ret != SQLITE_DONE) {
+		const gchar *errmsg = sqlite3_errmsg (ebsql->priv->db);
+		EBSQL_SET_ERROR_FROM_SQLITE (error, ret, errmsg);
+	}
+
+	sqlite3_reset (stmt);
+	sqlite3_clear_bindings (stmt);
+
+	return ret == SQLITE_DONE;
+}
+
 /**
  * e_book_sqlite_get_contact:
  * @ebsql: An #EBookSqlite
@@ -7206,6 +8610,15 @@ e_book_sqlite_get_contact (EBookSqlite *ebsql,
 	g_return_val_if_fail (uid != NULL, FALSE);
 	g_return_val_if_fail (ret_contact != NULL && *ret_contact == NULL, FALSE);
 
+	if (!meta_contact) {
+		EBSQL_LOCK_MUTEX (&ebsql->priv->lock);
+		success = ebsql_get_contact_from_bvcard (ebsql, uid, ret_contact, error);
+		EBSQL_UNLOCK_MUTEX (&ebsql->priv->lock);
+
+		if (!success || *ret_contact)
+			return success;
+	}
+
 	success = e_book_sqlite_get_vcard (
 		ebsql, uid, meta_contact, &vcard, error);
 
@@ -7248,6 +8661,13 @@ ebsql_get_contact_unlocked (EBookSqlite *ebsql,
 	g_return_val_if_fail (uid != NULL, FALSE);
 	g_return_val_if_fail (contact != NULL && *contact == NULL, FALSE);
 
+	if (!meta_contact) {
+		success = ebsql_get_contact_from_bvcard (ebsql, uid, contact, error);
+
+		if (!success || *contact)
+			return success;
+	}
+
 	success = ebsql_get_vcard_unlocked (ebsql,
 					    uid,
 					    meta_contact,
@@ -7510,6 +8930,47 @@ ebsql_get_contact_extra_unlocked (EBookSqlite *ebsql,
 	return success;
 }
 
+/* Common implementation of e_book_sqlite_search_foreach()
+ * and e_book_sqlite_search_foreach_projected() */
+static gboolean
+ebsql_search_foreach (EBookSqlite *ebsql,
+                      const gchar *sexp,
+                      SearchType search_type,
+                      const gchar *projection,
+                      EbSqlSearchFunc func,
+                      gpointer user_data,
+                      GCancellable *cancellable,
+                      GError **error)
+{
+	SearchForeachData foreach_data;
+	GError *local_error = NULL;
+	gboolean success;
+
+	foreach_data.func = func;
+	foreach_data.user_data = user_data;
+	foreach_data.meta_contacts = search_type == SEARCH_UID_AND_REV;
+	foreach_data.stopped = FALSE;
+
+	EBSQL_LOCK_OR_RETURN (ebsql, cancellable, FALSE);
+	success = ebsql_search_query (
+		ebsql, sexp, search_type, projection,
+		foreach_results_cb, &foreach_data,
+		cancellable,
+		&local_error);
+	EBSQL_UNLOCK_MUTEX (&ebsql->priv->lock);
+
+	/* The abort caused by the caller is not a failure */
+	if (!success && foreach_data.stopped) {
+		g_clear_error (&local_error);
+		success = TRUE;
+	}
+
+	if (local_error != NULL)
+		g_propagate_error (error, local_error);
+
+	return success;
+}
+
 /**
  * e_book_sqlite_search:
  * @ebsql: An #EBookSqlite
@@ -7555,7 +9016,7 @@ e_book_sqlite_search (EBookSqlite *ebsql,
 		ebsql, sexp,
 		meta_contacts ?
 		SEARCH_UID_AND_REV : SEARCH_FULL,
-		ret_list,
+		NULL, NULL, ret_list,
 		cancellable,
 		error);
 	EBSQL_UNLOCK_MUTEX (&ebsql->priv->lock);
@@ -7593,12 +9054,109 @@ e_book_sqlite_search_uids (EBookSqlite *ebsql,
 	g_return_val_if_fail (ret_list != NULL && *ret_list == NULL, FALSE);
 
 	EBSQL_LOCK_OR_RETURN (ebsql, cancellable, FALSE);
-	success = ebsql_search_query (ebsql, sexp, SEARCH_UID, ret_list, cancellable, error);
+	success = ebsql_search_query (ebsql, sexp, SEARCH_UID, NULL, NULL, ret_list, cancellable, error);
 	EBSQL_UNLOCK_MUTEX (&ebsql->priv->lock);
 
 	return success;
 }
 
+/**
+ * e_book_sqlite_search_foreach:
+ * @ebsql: An #EBookSqlite
+ * @sexp: (allow-none): search expression; use %NULL or an empty string to list all stored contacts.
+ * @meta_contacts: Whether entire contacts are desired, or only the metadata
+ * @func: (scope call): The function to call for each matching contact
+ * @user_data: (closure func): User data for @func
+ * @cancellable: (allow-none): A #GCancellable
+ * @error: (allow-none): A location to store any error that may have occurred.
+ *
+ * Like e_book_sqlite_search(), but instead of collecting all the results
+ * in a list, every matching contact is passed to @func as soon as it is
+ * read from the database, so that the memory needed does not grow with
+ * the number of results.
+ *
+ * The #EbSqlSearchData passed to @func is freed once @func returns.
+ * Returning %FALSE from @func stops the search, which is not an error.
+ *
+ * <note><para>@func is called inside a lock, you must not call the
+ * #EBookSqlite API from it.</para></note>
+ *
+ * Returns: %TRUE on success, otherwise %FALSE is returned and @error is set appropriately.
+ *
+ * Since: 3.20
+ **/
+gboolean
+e_book_sqlite_search_foreach (EBookSqlite *ebsql,
+                              const gchar *sexp,
+                              gboolean meta_contacts,
+                              EbSqlSearchFunc func,
+                              gpointer user_data,
+                              GCancellable *cancellable,
+                              GError **error)
+{
+	g_return_val_if_fail (E_IS_BOOK_SQLITE (ebsql), FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+
+	return ebsql_search_foreach (
+		ebsql, sexp,
+		meta_contacts ?
+		SEARCH_UID_AND_REV : SEARCH_FULL,
+		NULL, func, user_data,
+		cancellable, error);
+}
+
+/**
+ * e_book_sqlite_search_foreach_projected:
+ * @ebsql: An #EBookSqlite
+ * @sexp: (allow-none): search expression; use %NULL or an empty string to list all stored contacts.
+ * @attributes: (array zero-terminated=1): The names of the vCard attributes to return
+ * @func: (scope call): The function to call for each matching contact
+ * @user_data: (closure func): User data for @func
+ * @cancellable: (allow-none): A #GCancellable
+ * @error: (allow-none): A location to store any error that may have occurred.
+ *
+ * Like e_book_sqlite_search_foreach(), but the vCards passed to @func hold
+ * only the @attributes, such as those of e_data_book_view_dup_attributes_of_interest().
+ * They are built from the pre-parsed form of the contacts stored along with
+ * the vCards, without reading, parsing or copying the other attributes.
+ *
+ * Contacts stored before the pre-parsed form was introduced, and those of
+ * shallow addressbooks, are passed with their whole vCards.
+ *
+ * <note><para>@func is called inside a lock, you must not call the
+ * #EBookSqlite API from it.</para></note>
+ *
+ * Returns: %TRUE on success, otherwise %FALSE is returned and @error is set appropriately.
+ *
+ * Since: 3.20
+ **/
+gboolean
+e_book_sqlite_search_foreach_projected (EBookSqlite *ebsql,
+                                        const gchar *sexp,
+                                        const gchar * const *attributes,
+                                        EbSqlSearchFunc func,
+                                        gpointer user_data,
+                                        GCancellable *cancellable,
+                                        GError **error)
+{
+	gchar *projection;
+	gboolean success;
+
+	g_return_val_if_fail (E_IS_BOOK_SQLITE (ebsql), FALSE);
+	g_return_val_if_fail (attributes != NULL, FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+
+	projection = g_strjoinv (",", (gchar **) attributes);
+
+	success = ebsql_search_foreach (
+		ebsql, sexp, SEARCH_PROJECTED, projection,
+		func, user_data, cancellable, error);
+
+	g_free (projection);
+
+	return success;
+}
+
 /**
  * e_book_sqlite_get_key_value:
  * @ebsql: An #EBookSqlite
@@ -7958,6 +9516,8 @@ e_book_sqlite_cursor_new (EBookSqlite *ebsql,
 	if (!ebsql_cursor_setup_query (ebsql, cursor, sexp, error)) {
 		ebsql_cursor_free (cursor);
 		cursor = NULL;
+	} else {
+		ebsql->priv->cursors = g_slist_prepend (ebsql->priv->cursors, cursor);
 	}
 
 	EBSQL_UNLOCK_MUTEX (&ebsql->priv->lock);
@@ -7987,6 +9547,10 @@ e_book_sqlite_cursor_free (EBookSqlite *ebsql,
 {
 	g_return_if_fail (E_IS_BOOK_SQLITE (ebsql));
 
+	EBSQL_LOCK_MUTEX (&ebsql->priv->lock);
+	ebsql->priv->cursors = g_slist_remove (ebsql->priv->cursors, cursor);
+	EBSQL_UNLOCK_MUTEX (&ebsql->priv->lock);
+
 	ebsql_cursor_free (cursor);
 }
 
@@ -8371,6 +9935,13 @@ e_book_sqlite_cursor_set_sexp (EBookSqlite *ebsql,
  * of @cursor, if @cursor currently points to an exact contact, the position
  * also includes the cursor contact.
  *
+ * When the first sort field of @cursor has a sort key in the summary,
+ * @cursor caches the amount of results per alphabetic index and keeps it
+ * up to date with the changes made through @ebsql. Further calculations
+ * then only need to count the results in the alphabetic index of the
+ * cursor value, or nothing at all after setting an alphabetic index
+ * target with e_book_sqlite_cursor_set_target_alphabetic_index().
+ *
  * Returns: Whether @total and @position were successfully calculated.
  *
  * Since: 3.12
@@ -8384,6 +9955,7 @@ e_book_sqlite_cursor_calculate (EBookSqlite *ebsql,
                                 GError **error)
 {
 	gboolean success = TRUE;
+	gboolean calculated = FALSE;
 	gint local_total = 0;
 
 	g_return_val_if_fail (E_IS_BOOK_SQLITE (ebsql), FALSE);
@@ -8418,10 +9990,13 @@ e_book_sqlite_cursor_calculate (EBookSqlite *ebsql,
 		return FALSE;
 	}
 
-	if (total)
+	success = cursor_counts_calculate_locked (
+		ebsql, cursor, total, position, &calculated, error);
+
+	if (success && !calculated && total)
 		success = cursor_count_total_locked (ebsql, cursor, total, error);
 
-	if (success && position)
+	if (success && !calculated && position)
 		success = cursor_count_position_locked (ebsql, cursor, position, error);
 
 	if (success)
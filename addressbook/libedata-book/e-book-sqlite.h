@@ -153,6 +153,23 @@ typedef gchar *	(*EbSqlVCardCallback)		(const gchar *uid,
 						 const gchar *extra,
 						 gpointer user_data);
 
+/**
+ * EbSqlSearchFunc:
+ * @data: A contact matching the search
+ * @user_data: User data passed to e_book_sqlite_search_foreach()
+ *
+ * Receives the search results of e_book_sqlite_search_foreach(),
+ * one at a time.  The @data is owned by the caller and is freed
+ * once the function returns.
+ *
+ * Returns: %TRUE to continue the search, %FALSE to stop it
+ *
+ * Since: 3.20
+ **/
+typedef struct _EbSqlSearchData EbSqlSearchData;
+typedef gboolean (*EbSqlSearchFunc)		(EbSqlSearchData *data,
+						 gpointer user_data);
+
 /**
  * EBookSqliteError:
  * @E_BOOK_SQLITE_ERROR_ENGINE: An error was reported from the SQLite engine
@@ -226,11 +243,11 @@ typedef enum {
  *
  * Since: 3.12
  **/
-typedef struct {
+struct _EbSqlSearchData {
 	gchar *uid;
 	gchar *vcard;
 	gchar *extra;
-} EbSqlSearchData;
+};
 
 /**
  * EBookSqlite:
@@ -351,6 +368,10 @@ ECollator *	e_book_sqlite_ref_collator	(EBookSqlite *ebsql);
 
 ESource *	e_book_sqlite_ref_source	(EBookSqlite *ebsql);
 
+void		e_book_sqlite_set_store_bvcards	(EBookSqlite *ebsql,
+						 gboolean store_bvcards);
+gboolean	e_book_sqlite_get_store_bvcards	(EBookSqlite *ebsql);
+
 /* Adding / Removing / Searching contacts */
 gboolean	e_book_sqlite_add_contact	(EBookSqlite *ebsql,
 						 EContact *contact,
@@ -420,6 +441,21 @@ gboolean	e_book_sqlite_search_uids	(EBookSqlite *ebsql,
 						 GSList **ret_list,
 						 GCancellable *cancellable,
 						 GError **error);
+gboolean	e_book_sqlite_search_foreach	(EBookSqlite *ebsql,
+						 const gchar *sexp,
+						 gboolean meta_contacts,
+						 EbSqlSearchFunc func,
+						 gpointer user_data,
+						 GCancellable *cancellable,
+						 GError **error);
+gboolean	e_book_sqlite_search_foreach_projected
+						(EBookSqlite *ebsql,
+						 const gchar *sexp,
+						 const gchar * const *attributes,
+						 EbSqlSearchFunc func,
+						 gpointer user_data,
+						 GCancellable *cancellable,
+						 GError **error);
 
 /* Key / Value convenience API */
 gboolean	e_book_sqlite_get_key_value	(EBookSqlite *ebsql,
@@ -48,10 +48,22 @@
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), E_TYPE_DATA_BOOK_VIEW, EDataBookViewPrivate))
 
-/* how many items can be hold in a cache, before propagated to UI */
+/* how many items can be hold in a cache, before propagated to UI;
+ * the limit doubles each time it is reached, up to THRESHOLD_ITEMS_MAX,
+ * and halves again once notifications slow down */
 #define THRESHOLD_ITEMS 32
+#define THRESHOLD_ITEMS_MAX 4096
 
-/* how long to wait until notifications are propagated to UI; in seconds */
+/* a batch is also propagated once its items take this many bytes */
+#define THRESHOLD_BYTES (1024 * 1024)
+
+/* how long to wait for more notifications before propagating the pending
+ * ones to UI, and the longest to keep waiting while they keep coming */
+#define FLUSH_DELAY_MS 10
+#define FLUSH_DELAY_MAX_MS 500
+
+/* how long to wait until notifications are propagated to UI with
+ * E_BOOK_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT; in seconds */
 #define THRESHOLD_SECONDS 2
 
 struct _EDataBookViewPrivate {
@@ -64,6 +76,18 @@ struct _EDataBookViewPrivate {
 	EBookBackendSExp *sexp;
 	EBookClientViewFlags flags;
 
+	/* expressions replaced while the view was populated,
+	 * the backend may still be using them */
+	GSList *old_sexps;
+
+	/* UIDs of the contacts notified while the query
+	 * is being changed, NULL when it is not */
+	GHashTable *requery_ids;
+
+	/* serializes query changes, only the latest is applied */
+	GMutex query_lock;
+	gint query_serial;
+
 	gboolean running;
 	gboolean complete;
 	GMutex pending_mutex;
@@ -76,9 +100,31 @@ struct _EDataBookViewPrivate {
 
 	guint flush_id;
 
+	/* the pending batch, only one of the arrays
+	 * above holds items at any time */
+	guint batch_size;
+	guint pending_items;
+	gsize pending_bytes;
+	gint64 pending_since;
+	gint64 last_queued;
+
+	/* notification statistics */
+	guint n_signals;
+	guint n_objects;
+	gint64 max_latency;
+
 	/* which fields is listener interested in */
 	GHashTable *fields_of_interest;
 	gboolean send_uids_only;
+
+	/* the vCard attributes holding the fields of interest,
+	 * NULL when whole vCards are sent */
+	GHashTable *attributes_of_interest;
+	gchar **attributes_strv;
+
+	/* vCard bytes sent, and left out by the projection */
+	guint64 n_bytes;
+	guint64 n_bytes_saved;
 };
 
 enum {
@@ -91,6 +137,13 @@ enum {
 
 /* Forward Declarations */
 static void	e_data_book_view_initable_init	(GInitableIface *iface);
+static void	notify_remove			(EDataBookView *view,
+						 const gchar *id);
+static void	notify_add			(EDataBookView *view,
+						 const gchar *id,
+						 const gchar *vcard);
+static gboolean	id_is_in_view			(EDataBookView *view,
+						 const gchar *id);
 
 G_DEFINE_TYPE_WITH_CODE (
 	EDataBookView,
@@ -154,6 +207,52 @@ reset_array (GArray *array)
 	g_array_set_size (array, 0);
 }
 
+/* Accounts for an item being added to the pending batch */
+static void
+pending_queued (EDataBookView *view,
+                gsize n_bytes)
+{
+	view->priv->last_queued = g_get_monotonic_time ();
+
+	if (view->priv->pending_items == 0)
+		view->priv->pending_since = view->priv->last_queued;
+
+	view->priv->pending_items++;
+	view->priv->pending_bytes += n_bytes;
+}
+
+/* Accounts for the pending batch being sent */
+static void
+pending_sent (EDataBookView *view)
+{
+	gint64 latency;
+
+	latency = g_get_monotonic_time () - view->priv->pending_since;
+
+	view->priv->n_signals++;
+	view->priv->n_objects += view->priv->pending_items;
+	view->priv->max_latency = MAX (view->priv->max_latency, latency);
+
+	view->priv->pending_items = 0;
+	view->priv->pending_bytes = 0;
+}
+
+/* Whether the pending batch is full and is to be sent before
+ * queueing more items.  Reaching the limit means notifications
+ * come in faster than they are sent, thus it is raised. */
+static gboolean
+pending_batch_full (EDataBookView *view)
+{
+	if (view->priv->pending_items < view->priv->batch_size &&
+	    view->priv->pending_bytes < THRESHOLD_BYTES)
+		return FALSE;
+
+	view->priv->batch_size = MIN (
+		view->priv->batch_size * 2, THRESHOLD_ITEMS_MAX);
+
+	return TRUE;
+}
+
 static void
 send_pending_adds (EDataBookView *view)
 {
@@ -164,6 +263,7 @@ send_pending_adds (EDataBookView *view)
 		view->priv->gdbus_object,
 		(const gchar * const *) view->priv->adds->data);
 	reset_array (view->priv->adds);
+	pending_sent (view);
 }
 
 static void
@@ -176,6 +276,7 @@ send_pending_changes (EDataBookView *view)
 		view->priv->gdbus_object,
 		(const gchar * const *) view->priv->changes->data);
 	reset_array (view->priv->changes);
+	pending_sent (view);
 }
 
 static void
@@ -188,17 +289,36 @@ send_pending_removes (EDataBookView *view)
 		view->priv->gdbus_object,
 		(const gchar * const *) view->priv->removes->data);
 	reset_array (view->priv->removes);
+	pending_sent (view);
 }
 
 static gboolean
 pending_flush_timeout_cb (gpointer data)
 {
 	EDataBookView *view = data;
+	gint64 now;
 
 	g_mutex_lock (&view->priv->pending_mutex);
 
+	now = g_get_monotonic_time ();
+
+	/* Notifications are still coming, wait for
+	 * more of them unless it takes too long */
+	if ((view->priv->flags & E_BOOK_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT) == 0 &&
+	    view->priv->pending_items > 0 &&
+	    now - view->priv->last_queued < FLUSH_DELAY_MS * 1000 &&
+	    now - view->priv->pending_since < FLUSH_DELAY_MAX_MS * 1000) {
+		g_mutex_unlock (&view->priv->pending_mutex);
+		return TRUE;
+	}
+
 	view->priv->flush_id = 0;
 
+	/* Things calmed down, go back to smaller batches */
+	if (view->priv->pending_items < view->priv->batch_size / 2)
+		view->priv->batch_size = MAX (
+			view->priv->batch_size / 2, THRESHOLD_ITEMS);
+
 	send_pending_adds (view);
 	send_pending_changes (view);
 	send_pending_removes (view);
@@ -214,8 +334,12 @@ ensure_pending_flush_timeout (EDataBookView *view)
 	if (view->priv->flush_id > 0)
 		return;
 
-	view->priv->flush_id = e_named_timeout_add_seconds (
-		THRESHOLD_SECONDS, pending_flush_timeout_cb, view);
+	if (view->priv->flags & E_BOOK_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT)
+		view->priv->flush_id = e_named_timeout_add_seconds (
+			THRESHOLD_SECONDS, pending_flush_timeout_cb, view);
+	else
+		view->priv->flush_id = e_named_timeout_add (
+			FLUSH_DELAY_MS, pending_flush_timeout_cb, view);
 }
 
 static gpointer
@@ -237,8 +361,10 @@ impl_DataBookView_start (EGdbusBookView *object,
 {
 	GThread *thread;
 
+	g_mutex_lock (&view->priv->pending_mutex);
 	view->priv->running = TRUE;
 	view->priv->complete = FALSE;
+	g_mutex_unlock (&view->priv->pending_mutex);
 
 	thread = g_thread_new (
 		NULL, bookview_start_thread, g_object_ref (view));
@@ -268,8 +394,10 @@ impl_DataBookView_stop (EGdbusBookView *object,
 {
 	GThread *thread;
 
+	g_mutex_lock (&view->priv->pending_mutex);
 	view->priv->running = FALSE;
 	view->priv->complete = FALSE;
+	g_mutex_unlock (&view->priv->pending_mutex);
 
 	thread = g_thread_new (
 		NULL, bookview_stop_thread, g_object_ref (view));
@@ -301,12 +429,87 @@ impl_DataBookView_dispose (EGdbusBookView *object,
 	e_gdbus_book_view_complete_dispose (object, invocation, NULL);
 
 	e_book_backend_stop_view (view->priv->backend, view);
+	g_mutex_lock (&view->priv->pending_mutex);
 	view->priv->running = FALSE;
+	g_mutex_unlock (&view->priv->pending_mutex);
 	e_book_backend_remove_view (view->priv->backend, view);
 
 	return TRUE;
 }
 
+static void
+add_attribute_of_interest (GHashTable *attributes,
+                           const gchar *name)
+{
+	g_hash_table_add (attributes, (gpointer) name);
+}
+
+/* Collects the vCard attributes which hold the fields of interest,
+ * only these are sent of each contact.  A field which is not stored
+ * in known attributes makes the view send whole vCards. */
+static void
+data_book_view_update_attributes (EDataBookView *view)
+{
+	GHashTable *attributes;
+	GHashTableIter iter;
+	gpointer key;
+
+	if (view->priv->attributes_of_interest != NULL) {
+		g_hash_table_destroy (view->priv->attributes_of_interest);
+		view->priv->attributes_of_interest = NULL;
+	}
+
+	g_free (view->priv->attributes_strv);
+	view->priv->attributes_strv = NULL;
+
+	if (view->priv->fields_of_interest == NULL || view->priv->send_uids_only)
+		return;
+
+	/* The names are static strings of EContact */
+	attributes = g_hash_table_new (
+		(GHashFunc) str_ic_hash,
+		(GEqualFunc) str_ic_equal);
+
+	/* Sent always, see e_book_client_view_set_fields_of_interest() */
+	add_attribute_of_interest (attributes, EVC_UID);
+	add_attribute_of_interest (attributes, EVC_REV);
+
+	g_hash_table_iter_init (&iter, view->priv->fields_of_interest);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		EContactField field_id = e_contact_field_id (key);
+		const gchar *name;
+
+		switch (field_id) {
+		case 0:
+			g_hash_table_destroy (attributes);
+			return;
+		case E_CONTACT_CATEGORIES:
+			add_attribute_of_interest (attributes, EVC_CATEGORIES);
+			break;
+		case E_CONTACT_NAME_OR_ORG:
+			/* See e_contact_get() */
+			add_attribute_of_interest (attributes, EVC_X_FILE_AS);
+			add_attribute_of_interest (attributes, EVC_FN);
+			add_attribute_of_interest (attributes, EVC_ORG);
+			add_attribute_of_interest (attributes, EVC_X_LIST);
+			add_attribute_of_interest (attributes, EVC_EMAIL);
+			break;
+		default:
+			name = e_contact_vcard_attribute (field_id);
+			if (name == NULL || *name == '\0') {
+				g_hash_table_destroy (attributes);
+				return;
+			}
+
+			add_attribute_of_interest (attributes, name);
+			break;
+		}
+	}
+
+	view->priv->attributes_of_interest = attributes;
+	view->priv->attributes_strv = (gchar **) g_hash_table_get_keys_as_array (attributes, NULL);
+}
+
 static gboolean
 impl_DataBookView_set_fields_of_interest (EGdbusBookView *object,
                                           GDBusMethodInvocation *invocation,
@@ -317,6 +520,8 @@ impl_DataBookView_set_fields_of_interest (EGdbusBookView *object,
 
 	g_return_val_if_fail (in_fields_of_interest != NULL, TRUE);
 
+	g_mutex_lock (&view->priv->pending_mutex);
+
 	if (view->priv->fields_of_interest != NULL) {
 		g_hash_table_destroy (view->priv->fields_of_interest);
 		view->priv->fields_of_interest = NULL;
@@ -348,12 +553,244 @@ impl_DataBookView_set_fields_of_interest (EGdbusBookView *object,
 			g_strdup (field), GINT_TO_POINTER (1));
 	}
 
+	data_book_view_update_attributes (view);
+
+	g_mutex_unlock (&view->priv->pending_mutex);
+
 	e_gdbus_book_view_complete_set_fields_of_interest (
 		object, invocation, NULL);
 
 	return TRUE;
 }
 
+typedef struct {
+	EDataBookView *view;
+	EBookBackendSExp *sexp;
+	gint serial;
+} SetQueryData;
+
+/* Replaces the expression of @view by @sexp, sending only the
+ * differences between the contacts matching the old and the new one */
+static void
+data_book_view_requery (EDataBookView *view,
+                        EBookBackendSExp *sexp)
+{
+	EBookBackendSExp *old_sexp;
+	GSList *old_sexps = NULL;
+	GQueue uids = G_QUEUE_INIT;
+	GQueue contacts = G_QUEUE_INIT;
+	GHashTable *new_ids;
+	GList *ids, *link;
+	gchar *query;
+	gboolean was_complete;
+	GError *local_error = NULL;
+
+	g_mutex_lock (&view->priv->pending_mutex);
+	was_complete = view->priv->complete;
+	g_mutex_unlock (&view->priv->pending_mutex);
+
+	/* Stop populating the view with the contacts of the old
+	 * expression, those which were sent are in the delta */
+	if (!was_complete)
+		e_book_backend_stop_view (view->priv->backend, view);
+
+	/* Swap the expression before reading what it matches, thus the
+	 * updates notified meanwhile are matched against the new one;
+	 * the contacts they touch are left as those notifications put
+	 * them, the lists read below can be older than that */
+	g_mutex_lock (&view->priv->pending_mutex);
+
+	old_sexp = view->priv->sexp;
+	view->priv->sexp = g_object_ref (sexp);
+
+	/* Read only the contacts which are new to the view, if it was
+	 * populated completely those are the ones the old expression
+	 * did not match */
+	if (was_complete)
+		query = g_strdup_printf (
+			"(and %s (not %s))",
+			e_book_backend_sexp_text (sexp),
+			e_book_backend_sexp_text (old_sexp));
+	else
+		query = g_strdup (e_book_backend_sexp_text (sexp));
+
+	/* Nothing uses the replaced expressions once the backend
+	 * stopped populating the view with them */
+	if (!was_complete) {
+		old_sexps = view->priv->old_sexps;
+		view->priv->old_sexps = NULL;
+	}
+
+	view->priv->requery_ids = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) NULL);
+
+	g_mutex_unlock (&view->priv->pending_mutex);
+
+	g_object_unref (old_sexp);
+	g_slist_free_full (old_sexps, g_object_unref);
+
+	new_ids = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) NULL);
+
+	if (!e_book_backend_get_contact_list_uids_sync (
+		view->priv->backend, e_book_backend_sexp_text (sexp),
+		&uids, NULL, &local_error))
+		goto exit;
+
+	while (!g_queue_is_empty (&uids)) {
+		gchar *uid = g_queue_pop_head (&uids);
+
+		g_hash_table_add (new_ids, e_util_utf8_make_valid (uid));
+		g_free (uid);
+	}
+
+	g_mutex_lock (&view->priv->pending_mutex);
+
+	ids = g_hash_table_get_keys (view->priv->ids);
+	for (link = ids; link; link = g_list_next (link)) {
+		if (!g_hash_table_contains (new_ids, link->data) &&
+		    !g_hash_table_contains (view->priv->requery_ids, link->data))
+			notify_remove (view, link->data);
+	}
+	g_list_free (ids);
+
+	/* Listeners which only get UIDs need no contacts */
+	if (view->priv->send_uids_only) {
+		GHashTableIter iter;
+		gpointer key;
+
+		g_hash_table_iter_init (&iter, new_ids);
+		while (g_hash_table_iter_next (&iter, &key, NULL)) {
+			if (!id_is_in_view (view, key) &&
+			    !g_hash_table_contains (view->priv->requery_ids, key))
+				notify_add (view, key, NULL);
+		}
+
+		g_mutex_unlock (&view->priv->pending_mutex);
+
+		goto exit;
+	}
+
+	g_mutex_unlock (&view->priv->pending_mutex);
+
+	if (!e_book_backend_get_contact_list_sync (
+		view->priv->backend, query, &contacts, NULL, &local_error))
+		goto exit;
+
+	g_mutex_lock (&view->priv->pending_mutex);
+
+	while (!g_queue_is_empty (&contacts)) {
+		EContact *contact = g_queue_pop_head (&contacts);
+		const gchar *uid;
+
+		uid = e_contact_get_const (contact, E_CONTACT_UID);
+
+		if (uid && !id_is_in_view (view, uid) &&
+		    !g_hash_table_contains (view->priv->requery_ids, uid)) {
+			gchar *vcard;
+
+			vcard = e_vcard_to_string (
+				E_VCARD (contact), EVC_FORMAT_VCARD_30);
+			notify_add (view, uid, vcard);
+			g_free (vcard);
+		}
+
+		g_object_unref (contact);
+	}
+
+	g_mutex_unlock (&view->priv->pending_mutex);
+
+ exit:
+	g_mutex_lock (&view->priv->pending_mutex);
+	g_hash_table_destroy (view->priv->requery_ids);
+	view->priv->requery_ids = NULL;
+	g_mutex_unlock (&view->priv->pending_mutex);
+
+	g_hash_table_destroy (new_ids);
+	g_free (query);
+
+	/* Sends what is pending and tells the view is in sync again */
+	e_data_book_view_notify_complete (view, local_error);
+	g_clear_error (&local_error);
+}
+
+static gpointer
+bookview_set_query_thread (gpointer data)
+{
+	SetQueryData *sqd = data;
+	EDataBookView *view = sqd->view;
+
+	g_mutex_lock (&view->priv->query_lock);
+
+	/* Skip the queries which were replaced meanwhile */
+	if (sqd->serial == g_atomic_int_get (&view->priv->query_serial)) {
+		gboolean running;
+
+		/* start() and stop() change it from the main thread */
+		g_mutex_lock (&view->priv->pending_mutex);
+		running = view->priv->running;
+		if (!running) {
+			/* Not started, just use the expression when it is;
+			 * a concurrent start can still read the old one */
+			view->priv->old_sexps = g_slist_prepend (
+				view->priv->old_sexps, view->priv->sexp);
+			view->priv->sexp = g_object_ref (sqd->sexp);
+		}
+		g_mutex_unlock (&view->priv->pending_mutex);
+
+		if (running)
+			data_book_view_requery (view, sqd->sexp);
+	}
+
+	g_mutex_unlock (&view->priv->query_lock);
+
+	g_object_unref (sqd->sexp);
+	g_object_unref (sqd->view);
+	g_slice_free (SetQueryData, sqd);
+
+	return NULL;
+}
+
+static gboolean
+impl_DataBookView_set_query (EGdbusBookView *object,
+                             GDBusMethodInvocation *invocation,
+                             const gchar *in_query,
+                             EDataBookView *view)
+{
+	EBookBackendSExp *sexp;
+	SetQueryData *sqd;
+	GThread *thread;
+
+	sexp = e_book_backend_sexp_new (in_query);
+	if (sexp == NULL) {
+		GError *error;
+
+		error = e_client_error_create (E_CLIENT_ERROR_INVALID_QUERY, NULL);
+		e_gdbus_book_view_complete_set_query (object, invocation, error);
+		g_error_free (error);
+
+		return TRUE;
+	}
+
+	sqd = g_slice_new0 (SetQueryData);
+	sqd->view = g_object_ref (view);
+	sqd->sexp = sexp;
+	sqd->serial = g_atomic_int_add (&view->priv->query_serial, 1) + 1;
+
+	thread = g_thread_new (NULL, bookview_set_query_thread, sqd);
+	g_thread_unref (thread);
+
+	e_gdbus_book_view_complete_set_query (object, invocation, NULL);
+
+	return TRUE;
+}
+
 static void
 data_book_view_set_backend (EDataBookView *view,
                             EBookBackend *backend)
@@ -512,6 +949,14 @@ data_book_view_finalize (GObject *object)
 	if (priv->fields_of_interest)
 		g_hash_table_destroy (priv->fields_of_interest);
 
+	if (priv->attributes_of_interest)
+		g_hash_table_destroy (priv->attributes_of_interest);
+
+	g_free (priv->attributes_strv);
+
+	g_slist_free_full (priv->old_sexps, g_object_unref);
+
+	g_mutex_clear (&priv->query_lock);
 	g_mutex_clear (&priv->pending_mutex);
 
 	g_hash_table_destroy (priv->ids);
@@ -629,10 +1074,14 @@ e_data_book_view_init (EDataBookView *view)
 	g_signal_connect (
 		view->priv->gdbus_object, "handle-set-fields-of-interest",
 		G_CALLBACK (impl_DataBookView_set_fields_of_interest), view);
+	g_signal_connect (
+		view->priv->gdbus_object, "handle-set-query",
+		G_CALLBACK (impl_DataBookView_set_query), view);
 
 	view->priv->fields_of_interest = NULL;
 	view->priv->running = FALSE;
 	view->priv->complete = FALSE;
+	g_mutex_init (&view->priv->query_lock);
 	g_mutex_init (&view->priv->pending_mutex);
 
 	/* THRESHOLD_ITEMS * 2 because we store UID and vcard */
@@ -650,6 +1099,7 @@ e_data_book_view_init (EDataBookView *view)
 		(GDestroyNotify) NULL);
 
 	view->priv->flush_id = 0;
+	view->priv->batch_size = THRESHOLD_ITEMS;
 }
 
 /**
@@ -707,6 +1157,8 @@ e_data_book_view_get_backend (EDataBookView *view)
  * @view: an #EDataBookView
  *
  * Gets the s-expression used for matching contacts to @view.
+ * The expression can be changed by the client while @view exists,
+ * backends populating @view should read it once and use that.
  *
  * Returns: The #EBookBackendSExp used.
  *
@@ -776,6 +1228,203 @@ e_data_book_view_get_flags (EDataBookView *view)
 	return view->priv->flags;
 }
 
+/**
+ * e_data_book_view_get_notify_stats:
+ * @view: an #EDataBookView
+ * @out_n_signals: (out) (allow-none): return location for the number
+ *                 of signals emitted, or %NULL
+ * @out_n_objects: (out) (allow-none): return location for the number
+ *                 of objects sent in them, or %NULL
+ * @out_max_latency: (out) (allow-none): return location for the longest
+ *                   time an object was held back, in microseconds, or %NULL
+ *
+ * Gets statistics about the change notifications sent by @view, which
+ * are batched more when many of them come in a short time.
+ *
+ * Since: 3.20
+ **/
+void
+e_data_book_view_get_notify_stats (EDataBookView *view,
+                                   guint *out_n_signals,
+                                   guint *out_n_objects,
+                                   gint64 *out_max_latency)
+{
+	g_return_if_fail (E_IS_DATA_BOOK_VIEW (view));
+
+	g_mutex_lock (&view->priv->pending_mutex);
+
+	if (out_n_signals != NULL)
+		*out_n_signals = view->priv->n_signals;
+
+	if (out_n_objects != NULL)
+		*out_n_objects = view->priv->n_objects;
+
+	if (out_max_latency != NULL)
+		*out_max_latency = view->priv->max_latency;
+
+	g_mutex_unlock (&view->priv->pending_mutex);
+}
+
+/**
+ * e_data_book_view_get_projection_stats:
+ * @view: an #EDataBookView
+ * @out_n_bytes: (out) (allow-none): return location for the number
+ *               of vCard bytes sent, or %NULL
+ * @out_n_bytes_saved: (out) (allow-none): return location for the number
+ *                     of vCard bytes left out, or %NULL
+ *
+ * Gets how much vCard text @view has sent, and how much of it was
+ * saved by stripping the attributes which do not hold the fields
+ * of interest.
+ *
+ * Since: 3.20
+ **/
+void
+e_data_book_view_get_projection_stats (EDataBookView *view,
+                                       guint64 *out_n_bytes,
+                                       guint64 *out_n_bytes_saved)
+{
+	g_return_if_fail (E_IS_DATA_BOOK_VIEW (view));
+
+	g_mutex_lock (&view->priv->pending_mutex);
+
+	if (out_n_bytes != NULL)
+		*out_n_bytes = view->priv->n_bytes;
+
+	if (out_n_bytes_saved != NULL)
+		*out_n_bytes_saved = view->priv->n_bytes_saved;
+
+	g_mutex_unlock (&view->priv->pending_mutex);
+}
+
+/* Whether a vCard line with attribute @name, of @name_len
+ * bytes and without its group, is to be sent */
+static gboolean
+data_book_view_wants_attribute (EDataBookView *view,
+                                const gchar *name,
+                                gsize name_len)
+{
+	gchar buf[64];
+
+	if (name_len >= sizeof (buf))
+		return FALSE;
+
+	memcpy (buf, name, name_len);
+	buf[name_len] = '\0';
+
+	return g_ascii_strcasecmp (buf, "BEGIN") == 0 ||
+		g_ascii_strcasecmp (buf, "END") == 0 ||
+		g_ascii_strcasecmp (buf, "VERSION") == 0 ||
+		g_hash_table_contains (view->priv->attributes_of_interest, buf);
+}
+
+/* Strips @vcard down to the attributes of interest by parsing it */
+static gchar *
+data_book_view_project_parsed_vcard (EDataBookView *view,
+                                     const gchar *vcard)
+{
+	EVCard *evcard;
+	GList *attributes, *link;
+	gchar *projected;
+
+	evcard = e_vcard_new_from_string (vcard);
+	attributes = g_list_copy (e_vcard_get_attributes (evcard));
+
+	for (link = attributes; link; link = g_list_next (link)) {
+		EVCardAttribute *attr = link->data;
+		const gchar *name = e_vcard_attribute_get_name (attr);
+
+		if (!g_hash_table_contains (view->priv->attributes_of_interest, name))
+			e_vcard_remove_attribute (evcard, attr);
+	}
+
+	projected = e_vcard_to_string (evcard, EVC_FORMAT_VCARD_30);
+
+	g_list_free (attributes);
+	g_object_unref (evcard);
+
+	return projected;
+}
+
+/* Strips @vcard down to the attributes of interest.  The lines
+ * are copied as they are, along with their folded continuations,
+ * so the big values left out are never unescaped or decoded. */
+static gchar *
+data_book_view_project_vcard (EDataBookView *view,
+                              const gchar *vcard)
+{
+	GString *str;
+	const gchar *line, *next;
+
+	/* Soft line breaks of quoted-printable values
+	 * are not folding, leave those to the parser */
+	if (e_util_strstrcase (vcard, "QUOTED-PRINTABLE") != NULL)
+		return data_book_view_project_parsed_vcard (view, vcard);
+
+	str = g_string_sized_new (256);
+
+	for (line = vcard; *line; line = next) {
+		const gchar *name, *dot;
+		gsize name_len;
+
+		/* Find where the next unfolded line starts */
+		next = line;
+		do {
+			next += strcspn (next, "\r\n");
+			if (*next == '\r')
+				next++;
+			if (*next == '\n')
+				next++;
+		} while (*next == ' ' || *next == '\t');
+
+		name = line;
+		name_len = strcspn (line, ";:\r\n");
+
+		/* Skip the group */
+		dot = memchr (name, '.', name_len);
+		if (dot != NULL) {
+			name_len -= dot + 1 - name;
+			name = dot + 1;
+		}
+
+		if (data_book_view_wants_attribute (view, name, name_len))
+			g_string_append_len (str, line, next - line);
+	}
+
+	return g_string_free (str, FALSE);
+}
+
+/*
+ * Gets the text of @vcard to send, only with the attributes
+ * of interest, if those are known.
+ */
+static gchar *
+data_book_view_prepare_vcard (EDataBookView *view,
+                              const gchar *vcard)
+{
+	gchar *projected = NULL;
+	gchar *utf8_vcard;
+	gsize len, sent;
+
+	len = strlen (vcard);
+
+	if (view->priv->attributes_of_interest != NULL) {
+		projected = data_book_view_project_vcard (view, vcard);
+		vcard = projected;
+	}
+
+	utf8_vcard = e_util_utf8_make_valid (vcard);
+	sent = strlen (utf8_vcard);
+
+	view->priv->n_bytes += sent;
+	if (len > sent)
+		view->priv->n_bytes_saved += len - sent;
+
+	g_free (projected);
+
+	return utf8_vcard;
+}
+
 /*
  * Queue @vcard to be sent as a change notification.
  */
@@ -785,22 +1434,25 @@ notify_change (EDataBookView *view,
                const gchar *vcard)
 {
 	gchar *utf8_vcard, *utf8_id;
+	gsize n_bytes = 0;
 
 	send_pending_adds (view);
 	send_pending_removes (view);
 
-	if (view->priv->changes->len == THRESHOLD_ITEMS * 2) {
+	if (pending_batch_full (view)) {
 		send_pending_changes (view);
 	}
 
 	if (view->priv->send_uids_only == FALSE) {
-		utf8_vcard = e_util_utf8_make_valid (vcard);
+		utf8_vcard = data_book_view_prepare_vcard (view, vcard);
 		g_array_append_val (view->priv->changes, utf8_vcard);
+		n_bytes = strlen (utf8_vcard);
 	}
 
 	utf8_id = e_util_utf8_make_valid (id);
 	g_array_append_val (view->priv->changes, utf8_id);
 
+	pending_queued (view, n_bytes);
 	ensure_pending_flush_timeout (view);
 }
 
@@ -816,7 +1468,7 @@ notify_remove (EDataBookView *view,
 	send_pending_adds (view);
 	send_pending_changes (view);
 
-	if (view->priv->removes->len == THRESHOLD_ITEMS) {
+	if (pending_batch_full (view)) {
 		send_pending_removes (view);
 	}
 
@@ -824,6 +1476,7 @@ notify_remove (EDataBookView *view,
 	g_array_append_val (view->priv->removes, valid_id);
 	g_hash_table_remove (view->priv->ids, valid_id);
 
+	pending_queued (view, strlen (valid_id));
 	ensure_pending_flush_timeout (view);
 }
 
@@ -847,18 +1500,21 @@ notify_add (EDataBookView *view,
 	flags = e_data_book_view_get_flags (view);
 	if (view->priv->complete || (flags & E_BOOK_CLIENT_VIEW_FLAGS_NOTIFY_INITIAL) != 0) {
 		gchar *utf8_id_copy = g_strdup (utf8_id);
+		gsize n_bytes = 0;
 
-		if (view->priv->adds->len == THRESHOLD_ITEMS) {
+		if (pending_batch_full (view)) {
 			send_pending_adds (view);
 		}
 
 		if (view->priv->send_uids_only == FALSE) {
-			utf8_vcard = e_util_utf8_make_valid (vcard);
+			utf8_vcard = data_book_view_prepare_vcard (view, vcard);
 			g_array_append_val (view->priv->adds, utf8_vcard);
+			n_bytes = strlen (utf8_vcard);
 		}
 
 		g_array_append_val (view->priv->adds, utf8_id_copy);
 
+		pending_queued (view, n_bytes);
 		ensure_pending_flush_timeout (view);
 	}
 
@@ -882,6 +1538,18 @@ id_is_in_view (EDataBookView *view,
 	return res;
 }
 
+/* Remembers the contact was notified while the query is being
+ * changed, the requery keeps it as the notification left it */
+static void
+requery_note_id (EDataBookView *view,
+                 const gchar *id)
+{
+	if (view->priv->requery_ids != NULL)
+		g_hash_table_add (
+			view->priv->requery_ids,
+			e_util_utf8_make_valid (id));
+}
+
 /**
  * e_data_book_view_notify_update:
  * @view: an #EDataBookView
@@ -910,6 +1578,7 @@ e_data_book_view_notify_update (EDataBookView *view,
 	g_mutex_lock (&view->priv->pending_mutex);
 
 	id = e_contact_get_const ((EContact *) contact, E_CONTACT_UID);
+	requery_note_id (view, id);
 
 	currently_in_view = id_is_in_view (view, id);
 	want_in_view = e_book_backend_sexp_match_contact (
@@ -965,6 +1634,8 @@ e_data_book_view_notify_update_vcard (EDataBookView *view,
 
 	g_mutex_lock (&view->priv->pending_mutex);
 
+	requery_note_id (view, id);
+
 	contact = e_contact_new_from_vcard_with_uid (vcard, id);
 	currently_in_view = id_is_in_view (view, id);
 	want_in_view = e_book_backend_sexp_match_contact (
@@ -1023,6 +1694,7 @@ e_data_book_view_notify_update_prefiltered_vcard (EDataBookView *view,
 
 	g_mutex_lock (&view->priv->pending_mutex);
 
+	requery_note_id (view, id);
 	currently_in_view = id_is_in_view (view, id);
 
 	if (currently_in_view)
@@ -1053,6 +1725,8 @@ e_data_book_view_notify_remove (EDataBookView *view,
 
 	g_mutex_lock (&view->priv->pending_mutex);
 
+	requery_note_id (view, id);
+
 	if (id_is_in_view (view, id))
 		notify_remove (view, id);
 
@@ -1148,3 +1822,34 @@ e_data_book_view_get_fields_of_interest (EDataBookView *view)
 	return view->priv->fields_of_interest;
 }
 
+/**
+ * e_data_book_view_dup_attributes_of_interest:
+ * @view: an #EDataBookView
+ *
+ * Gets the names of the vCard attributes which hold the fields of
+ * interest of @view, including %EVC_UID and %EVC_REV.  Any other
+ * attributes are stripped from the vCards @view sends, so backends
+ * can save themselves building those.
+ *
+ * The fields of interest can change at any time, thus a copy is
+ * returned.  Free it with g_strfreev() when done with it.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the attribute
+ * names, or %NULL when whole vCards are sent.
+ *
+ * Since: 3.20
+ **/
+gchar **
+e_data_book_view_dup_attributes_of_interest (EDataBookView *view)
+{
+	gchar **attributes;
+
+	g_return_val_if_fail (E_IS_DATA_BOOK_VIEW (view), NULL);
+
+	g_mutex_lock (&view->priv->pending_mutex);
+	attributes = g_strdupv (view->priv->attributes_strv);
+	g_mutex_unlock (&view->priv->pending_mutex);
+
+	return attributes;
+}
+
@@ -83,6 +83,15 @@ EBookBackendSExp *
 		e_data_book_view_get_sexp	(EDataBookView *view);
 EBookClientViewFlags
 		e_data_book_view_get_flags	(EDataBookView *view);
+void		e_data_book_view_get_notify_stats
+						(EDataBookView *view,
+						 guint *out_n_signals,
+						 guint *out_n_objects,
+						 gint64 *out_max_latency);
+void		e_data_book_view_get_projection_stats
+						(EDataBookView *view,
+						 guint64 *out_n_bytes,
+						 guint64 *out_n_bytes_saved);
 void		e_data_book_view_notify_update	(EDataBookView *view,
 						 const EContact *contact);
 
@@ -107,6 +116,8 @@ void		e_data_book_view_notify_progress
 
 GHashTable *	e_data_book_view_get_fields_of_interest
 						(EDataBookView *view);
+gchar **	e_data_book_view_dup_attributes_of_interest
+						(EDataBookView *view);
 
 G_END_DECLS
 
@@ -31,9 +31,22 @@
 #include <locale.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 #include <glib/gi18n.h>
 #include <gio/gio.h>
 
+#ifdef G_OS_UNIX
+#include <glib/gstdio.h>
+#include <gio/gunixfdlist.h>
+#include <gio/gunixinputstream.h>
+#include <gio/gunixoutputstream.h>
+#endif
+
+#ifdef HAVE_LINUX_MEMFD_H
+#include <sys/syscall.h>
+#include <linux/memfd.h>
+#endif
+
 /* Private D-Bus classes. */
 #include <e-dbus-address-book.h>
 
@@ -818,6 +831,42 @@ data_book_handle_get_contact_cb (EDBusAddressBook *dbus_interface,
 	return TRUE;
 }
 
+/* Converts the contacts in @queue to valid UTF-8 vCard strings
+ * and releases them; @out_size is set to the total size of the
+ * strings, including their NUL terminators */
+static gchar **
+data_book_take_vcards (GQueue *queue,
+                       gsize *out_size)
+{
+	gchar **strv;
+	gsize size = 0;
+	gint ii = 0;
+
+	strv = g_new0 (gchar *, queue->length + 1);
+
+	while (!g_queue_is_empty (queue)) {
+		EContact *contact;
+		gchar *vcard;
+
+		contact = g_queue_pop_head (queue);
+
+		vcard = e_vcard_to_string (
+			E_VCARD (contact),
+			EVC_FORMAT_VCARD_30);
+		strv[ii] = e_util_utf8_make_valid (vcard);
+		size += strlen (strv[ii]) + 1;
+		ii++;
+		g_free (vcard);
+
+		g_object_unref (contact);
+	}
+
+	if (out_size != NULL)
+		*out_size = size;
+
+	return strv;
+}
+
 static void
 data_book_complete_get_contact_list_cb (GObject *source_object,
                                         GAsyncResult *result,
@@ -832,24 +881,8 @@ data_book_complete_get_contact_list_cb (GObject *source_object,
 
 	if (error == NULL) {
 		gchar **strv;
-		gint ii = 0;
-
-		strv = g_new0 (gchar *, queue.length + 1);
-
-		while (!g_queue_is_empty (&queue)) {
-			EContact *contact;
-			gchar *vcard;
 
-			contact = g_queue_pop_head (&queue);
-
-			vcard = e_vcard_to_string (
-				E_VCARD (contact),
-				EVC_FORMAT_VCARD_30);
-			strv[ii++] = e_util_utf8_make_valid (vcard);
-			g_free (vcard);
-
-			g_object_unref (contact);
-		}
+		strv = data_book_take_vcards (&queue, NULL);
 
 		e_dbus_address_book_complete_get_contact_list (
 			async_context->dbus_interface,
@@ -891,6 +924,143 @@ data_book_handle_get_contact_list_cb (EDBusAddressBook *dbus_interface,
 	return TRUE;
 }
 
+#ifdef G_OS_UNIX
+/* Results of GetContactListFd up to this size
+ * are returned in the D-Bus message itself */
+#define SNAPSHOT_THRESHOLD (64 * 1024)
+
+/* Writes @vcards, each with its NUL terminator, into a new
+ * anonymous file, which the client maps to read them back */
+static gint
+data_book_write_snapshot (gchar **vcards,
+                          GError **error)
+{
+	GOutputStream *stream;
+	gchar *filename = NULL;
+	gint fd = -1;
+	gint ii;
+
+#if defined (SYS_memfd_create) && defined (MFD_CLOEXEC)
+	/* Not every C library wraps the system call */
+	fd = syscall (SYS_memfd_create, "e-data-book-snapshot", MFD_CLOEXEC);
+#endif
+
+	/* Kernels without memfd, use an unlinked temporary file */
+	if (fd == -1) {
+		fd = g_file_open_tmp ("e-data-book-snapshot-XXXXXX", &filename, error);
+		if (fd == -1)
+			return -1;
+
+		g_unlink (filename);
+		g_free (filename);
+	}
+
+	stream = g_unix_output_stream_new (fd, FALSE);
+
+	for (ii = 0; vcards[ii] != NULL; ii++) {
+		if (!g_output_stream_write_all (
+			stream, vcards[ii], strlen (vcards[ii]) + 1,
+			NULL, NULL, error)) {
+			close (fd);
+			fd = -1;
+			break;
+		}
+	}
+
+	g_object_unref (stream);
+
+	return fd;
+}
+#endif
+
+static void
+data_book_complete_get_contact_list_fd_cb (GObject *source_object,
+                                           GAsyncResult *result,
+                                           gpointer user_data)
+{
+	AsyncContext *async_context = user_data;
+	GQueue queue = G_QUEUE_INIT;
+	GError *error = NULL;
+
+	e_book_backend_get_contact_list_finish (
+		E_BOOK_BACKEND (source_object), result, &queue, &error);
+
+	if (error == NULL) {
+		gchar **strv;
+		gsize size;
+
+		strv = data_book_take_vcards (&queue, &size);
+
+#ifdef G_OS_UNIX
+		if (size > SNAPSHOT_THRESHOLD) {
+			const gchar *empty[] = { NULL };
+			gint fd;
+
+			fd = data_book_write_snapshot (strv, &error);
+
+			if (fd != -1) {
+				GUnixFDList *fd_list;
+
+				/* Takes ownership of the descriptor */
+				fd_list = g_unix_fd_list_new_from_array (&fd, 1);
+
+				g_dbus_method_invocation_return_value_with_unix_fd_list (
+					async_context->invocation,
+					g_variant_new ("(^ash)", empty, 0),
+					fd_list);
+
+				g_object_unref (fd_list);
+			} else {
+				data_book_convert_to_client_error (error);
+				g_dbus_method_invocation_take_error (
+					async_context->invocation, error);
+			}
+
+			g_strfreev (strv);
+			async_context_free (async_context);
+			return;
+		}
+#endif
+
+		g_dbus_method_invocation_return_value (
+			async_context->invocation,
+			g_variant_new ("(^ash)", strv, -1));
+
+		g_strfreev (strv);
+	} else {
+		data_book_convert_to_client_error (error);
+		g_dbus_method_invocation_take_error (
+			async_context->invocation, error);
+	}
+
+	async_context_free (async_context);
+}
+
+static gboolean
+data_book_handle_get_contact_list_fd_cb (EDBusAddressBook *dbus_interface,
+                                         GDBusMethodInvocation *invocation,
+                                         const gchar *in_query,
+                                         EDataBook *data_book)
+{
+	EBookBackend *backend;
+	AsyncContext *async_context;
+
+	backend = e_data_book_ref_backend (data_book);
+	g_return_val_if_fail (backend != NULL, FALSE);
+
+	async_context = async_context_new (data_book, invocation);
+
+	e_book_backend_get_contact_list (
+		backend, in_query,
+		async_context->cancellable,
+		data_book_complete_get_contact_list_fd_cb,
+		async_context);
+
+	g_object_unref (backend);
+
+	return TRUE;
+}
+
 static void
 data_book_complete_get_contact_list_uids_cb (GObject *source_object,
                                              GAsyncResult *result,
@@ -1023,6 +1193,108 @@ data_book_handle_create_contacts_cb (EDBusAddressBook *dbus_interface,
 	return TRUE;
 }
 
+static void
+data_book_complete_import_contacts_cb (GObject *source_object,
+                                       GAsyncResult *result,
+                                       gpointer user_data)
+{
+	AsyncContext *async_context = user_data;
+	GQueue queue = G_QUEUE_INIT;
+	GError *error = NULL;
+
+	e_book_backend_import_contacts_finish (
+		E_BOOK_BACKEND (source_object), result, &queue, &error);
+
+	if (error == NULL) {
+		gchar **strv;
+		gint ii = 0;
+
+		strv = g_new0 (gchar *, queue.length + 1);
+
+		while (!g_queue_is_empty (&queue)) {
+			gchar *uid = g_queue_pop_head (&queue);
+
+			strv[ii++] = e_util_utf8_make_valid (uid);
+			g_free (uid);
+		}
+
+		e_dbus_address_book_complete_import_contacts (
+			async_context->dbus_interface,
+			async_context->invocation,
+			(const gchar * const *) strv);
+
+		g_strfreev (strv);
+	} else {
+		while (!g_queue_is_empty (&queue))
+			g_free (g_queue_pop_head (&queue));
+
+		data_book_convert_to_client_error (error);
+		g_dbus_method_invocation_take_error (
+			async_context->invocation, error);
+	}
+
+	async_context_free (async_context);
+}
+
+static gboolean
+data_book_handle_import_contacts_cb (EDBusAddressBook *dbus_interface,
+                                     GDBusMethodInvocation *invocation,
+                                     gint in_stream,
+                                     EDataBook *data_book)
+{
+#ifdef G_OS_UNIX
+	EBookBackend *backend;
+	AsyncContext *async_context;
+	GDBusMessage *message;
+	GUnixFDList *fd_list;
+	GInputStream *stream;
+	GError *error = NULL;
+	gint fd = -1;
+
+	message = g_dbus_method_invocation_get_message (invocation);
+	fd_list = g_dbus_message_get_unix_fd_list (message);
+
+	if (fd_list != NULL)
+		fd = g_unix_fd_list_get (fd_list, in_stream, &error);
+	else
+		error = g_error_new_literal (
+			E_CLIENT_ERROR,
+			E_CLIENT_ERROR_INVALID_ARG,
+			e_client_error_to_string (
+			E_CLIENT_ERROR_INVALID_ARG));
+
+	if (fd == -1) {
+		data_book_convert_to_client_error (error);
+		g_dbus_method_invocation_take_error (invocation, error);
+		return TRUE;
+	}
+
+	backend = e_data_book_ref_backend (data_book);
+	g_return_val_if_fail (backend != NULL, FALSE);
+
+	async_context = async_context_new (data_book, invocation);
+
+	stream = g_unix_input_stream_new (fd, TRUE);
+
+	e_book_backend_import_contacts (
+		backend, stream,
+		async_context->cancellable,
+		data_book_complete_import_contacts_cb,
+		async_context);
+
+	g_object_unref (stream);
+	g_object_unref (backend);
+#else
+	g_dbus_method_invocation_return_error_literal (
+		invocation, E_CLIENT_ERROR,
+		E_CLIENT_ERROR_NOT_SUPPORTED,
+		e_client_error_to_string (
+		E_CLIENT_ERROR_NOT_SUPPORTED));
+#endif
+
+	return TRUE;
+}
+
 static void
 data_book_complete_modify_contacts_cb (GObject *source_object,
                                        GAsyncResult *result,
@@ -2213,6 +2485,10 @@ e_data_book_init (EDataBook *data_book)
 		dbus_interface, "handle-get-contact-list",
 		G_CALLBACK (data_book_handle_get_contact_list_cb),
 		data_book);
+	g_signal_connect (
+		dbus_interface, "handle-get-contact-list-fd",
+		G_CALLBACK (data_book_handle_get_contact_list_fd_cb),
+		data_book);
 	g_signal_connect (
 		dbus_interface, "handle-get-contact-list-uids",
 		G_CALLBACK (data_book_handle_get_contact_list_uids_cb),
@@ -2221,6 +2497,10 @@ e_data_book_init (EDataBook *data_book)
 		dbus_interface, "handle-create-contacts",
 		G_CALLBACK (data_book_handle_create_contacts_cb),
 		data_book);
+	g_signal_connect (
+		dbus_interface, "handle-import-contacts",
+		G_CALLBACK (data_book_handle_import_contacts_cb),
+		data_book);
 	g_signal_connect (
 		dbus_interface, "handle-remove-contacts",
 		G_CALLBACK (data_book_handle_remove_contacts_cb),
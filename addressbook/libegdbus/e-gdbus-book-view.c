@@ -40,6 +40,7 @@ enum
 	__SET_FLAGS_METHOD,
 	__DISPOSE_METHOD,
 	__SET_FIELDS_OF_INTEREST_METHOD,
+	__SET_QUERY_METHOD,
 	__LAST_SIGNAL
 };
 
@@ -153,6 +154,11 @@ e_gdbus_book_view_default_init (EGdbusBookViewIface *iface)
 		"set_fields_of_interest",
 		set_fields_of_interest,
 		__SET_FIELDS_OF_INTEREST_METHOD)
+	E_INIT_GDBUS_METHOD_STRING (
+		EGdbusBookViewIface,
+		"set_query",
+		set_query,
+		__SET_QUERY_METHOD)
 }
 
 void
@@ -284,6 +290,33 @@ e_gdbus_book_view_call_set_fields_of_interest_sync (GDBusProxy *proxy,
 	return e_gdbus_proxy_method_call_sync_strv__void ("set_fields_of_interest", proxy, in_only_fields, cancellable, error);
 }
 
+void
+e_gdbus_book_view_call_set_query (GDBusProxy *proxy,
+                                  const gchar *in_query,
+                                  GCancellable *cancellable,
+                                  GAsyncReadyCallback callback,
+                                  gpointer user_data)
+{
+	e_gdbus_proxy_method_call_string ("set_query", proxy, in_query, cancellable, callback, user_data);
+}
+
+gboolean
+e_gdbus_book_view_call_set_query_finish (GDBusProxy *proxy,
+                                         GAsyncResult *result,
+                                         GError **error)
+{
+	return e_gdbus_proxy_method_call_finish_void (proxy, result, error);
+}
+
+gboolean
+e_gdbus_book_view_call_set_query_sync (GDBusProxy *proxy,
+                                       const gchar *in_query,
+                                       GCancellable *cancellable,
+                                       GError **error)
+{
+	return e_gdbus_proxy_method_call_sync_string__void ("set_query", proxy, in_query, cancellable, error);
+}
+
 void
 e_gdbus_book_view_emit_objects_added (EGdbusBookView *object,
                                       const gchar * const *arg_objects)
@@ -357,6 +390,10 @@ E_DECLARE_GDBUS_SYNC_METHOD_1 (book_view,
                                set_fields_of_interest,
                                fields_of_interest,
                                "as")
+E_DECLARE_GDBUS_SYNC_METHOD_1 (book_view,
+                               set_query,
+                               query,
+                               "s")
 
 static const GDBusMethodInfo * const e_gdbus_book_view_method_info_pointers[] =
 {
@@ -365,6 +402,7 @@ static const GDBusMethodInfo * const e_gdbus_book_view_method_info_pointers[] =
 	&E_DECLARED_GDBUS_METHOD_INFO_NAME (book_view, set_flags),
 	&E_DECLARED_GDBUS_METHOD_INFO_NAME (book_view, dispose),
 	&E_DECLARED_GDBUS_METHOD_INFO_NAME (book_view, set_fields_of_interest),
+	&E_DECLARED_GDBUS_METHOD_INFO_NAME (book_view, set_query),
 	NULL
 };
 
@@ -115,6 +115,7 @@ struct _EGdbusBookViewIface
 	gboolean (*handle_set_flags)            (EGdbusBookView *object, GDBusMethodInvocation *invocation, guint in_flags);
 	gboolean (*handle_dispose)		(EGdbusBookView *object, GDBusMethodInvocation *invocation);
 	gboolean (*handle_set_fields_of_interest)(EGdbusBookView *object, GDBusMethodInvocation *invocation, const gchar * const *in_only_fields);
+	gboolean (*handle_set_query)		(EGdbusBookView *object, GDBusMethodInvocation *invocation, const gchar *in_query);
 };
 
 /* D-Bus Methods */
@@ -147,12 +148,17 @@ void		e_gdbus_book_view_call_set_fields_of_interest		(GDBusProxy *proxy, const g
 gboolean	e_gdbus_book_view_call_set_fields_of_interest_finish	(GDBusProxy *proxy, GAsyncResult *result, GError **error);
 gboolean	e_gdbus_book_view_call_set_fields_of_interest_sync	(GDBusProxy *proxy, const gchar * const *in_only_fileds, GCancellable *cancellable, GError **error);
 
+void		e_gdbus_book_view_call_set_query		(GDBusProxy *proxy, const gchar *in_query, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+gboolean	e_gdbus_book_view_call_set_query_finish	(GDBusProxy *proxy, GAsyncResult *result, GError **error);
+gboolean	e_gdbus_book_view_call_set_query_sync	(GDBusProxy *proxy, const gchar *in_query, GCancellable *cancellable, GError **error);
+
 /* D-Bus Methods Completion Helpers */
 #define e_gdbus_book_view_complete_start			e_gdbus_complete_sync_method_void
 #define e_gdbus_book_view_complete_stop				e_gdbus_complete_sync_method_void
 #define e_gdbus_book_view_complete_set_flags			e_gdbus_complete_sync_method_void
 #define e_gdbus_book_view_complete_dispose			e_gdbus_complete_sync_method_void
 #define e_gdbus_book_view_complete_set_fields_of_interest	e_gdbus_complete_sync_method_void
+#define e_gdbus_book_view_complete_set_query			e_gdbus_complete_sync_method_void
 
 /* D-Bus Signal Emission Helpers */
 void	e_gdbus_book_view_emit_objects_added	(EGdbusBookView *object, const gchar * const *arg_objects);
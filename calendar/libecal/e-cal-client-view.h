@@ -61,6 +61,10 @@ struct _ECalClient;
  *   If this flag is set then all objects matching the view's query will
  *   be sent as notifications when starting the view, otherwise only future
  *   changes will be reported.  The default for a #ECalClientView is %TRUE.
+ * @E_CAL_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT:
+ *   If this flag is set then change notifications are held back for up to
+ *   a few seconds and sent in large batches.  Otherwise they are sent soon
+ *   after they stop coming, which suits interactive clients.  Since: 3.20
  *
  * Flags that control the behaviour of an #ECalClientView.
  *
@@ -68,7 +72,8 @@ struct _ECalClient;
  */
 typedef enum {
 	E_CAL_CLIENT_VIEW_FLAGS_NONE = 0,
-	E_CAL_CLIENT_VIEW_FLAGS_NOTIFY_INITIAL = (1 << 0)
+	E_CAL_CLIENT_VIEW_FLAGS_NOTIFY_INITIAL = (1 << 0),
+	E_CAL_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT = (1 << 1)
 } ECalClientViewFlags;
 
 /**
@@ -47,10 +47,22 @@
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), E_TYPE_DATA_CAL_VIEW, EDataCalViewPrivate))
 
-/* how many items can be hold in a cache, before propagated to UI */
+/* how many items can be hold in a cache, before propagated to UI;
+ * the limit doubles each time it is reached, up to THRESHOLD_ITEMS_MAX,
+ * and halves again once notifications slow down */
 #define THRESHOLD_ITEMS 32
+#define THRESHOLD_ITEMS_MAX 4096
 
-/* how long to wait until notifications are propagated to UI; in seconds */
+/* a batch is also propagated once its items take this many bytes */
+#define THRESHOLD_BYTES (1024 * 1024)
+
+/* how long to wait for more notifications before propagating the pending
+ * ones to UI, and the longest to keep waiting while they keep coming */
+#define FLUSH_DELAY_MS 10
+#define FLUSH_DELAY_MAX_MS 500
+
+/* how long to wait until notifications are propagated to UI with
+ * E_CAL_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT; in seconds */
 #define THRESHOLD_SECONDS 2
 
 struct _EDataCalViewPrivate {
@@ -77,6 +89,19 @@ struct _EDataCalViewPrivate {
 	GMutex pending_mutex;
 	guint flush_id;
 
+	/* the pending batch, only one of the arrays
+	 * above holds items at any time */
+	guint batch_size;
+	guint pending_items;
+	gsize pending_bytes;
+	gint64 pending_since;
+	gint64 last_queued;
+
+	/* notification statistics */
+	guint n_signals;
+	guint n_objects;
+	gint64 max_latency;
+
 	/* view flags */
 	ECalClientViewFlags flags;
 
@@ -608,6 +633,7 @@ e_data_cal_view_init (EDataCalView *view)
 
 	g_mutex_init (&view->priv->pending_mutex);
 	view->priv->flush_id = 0;
+	view->priv->batch_size = THRESHOLD_ITEMS;
 }
 
 /**
@@ -645,6 +671,52 @@ e_data_cal_view_new (ECalBackend *backend,
 		NULL);
 }
 
+/* Accounts for an item being added to the pending batch */
+static void
+pending_queued (EDataCalView *view,
+                gsize n_bytes)
+{
+	view->priv->last_queued = g_get_monotonic_time ();
+
+	if (view->priv->pending_items == 0)
+		view->priv->pending_since = view->priv->last_queued;
+
+	view->priv->pending_items++;
+	view->priv->pending_bytes += n_bytes;
+}
+
+/* Accounts for the pending batch being sent */
+static void
+pending_sent (EDataCalView *view)
+{
+	gint64 latency;
+
+	latency = g_get_monotonic_time () - view->priv->pending_since;
+
+	view->priv->n_signals++;
+	view->priv->n_objects += view->priv->pending_items;
+	view->priv->max_latency = MAX (view->priv->max_latency, latency);
+
+	view->priv->pending_items = 0;
+	view->priv->pending_bytes = 0;
+}
+
+/* Whether the pending batch is full and is to be sent before
+ * queueing more items.  Reaching the limit means notifications
+ * come in faster than they are sent, thus it is raised. */
+static gboolean
+pending_batch_full (EDataCalView *view)
+{
+	if (view->priv->pending_items < view->priv->batch_size &&
+	    view->priv->pending_bytes < THRESHOLD_BYTES)
+		return FALSE;
+
+	view->priv->batch_size = MIN (
+		view->priv->batch_size * 2, THRESHOLD_ITEMS_MAX);
+
+	return TRUE;
+}
+
 static void
 send_pending_adds (EDataCalView *view)
 {
@@ -655,6 +727,7 @@ send_pending_adds (EDataCalView *view)
 		view->priv->gdbus_object,
 		(const gchar * const *) view->priv->adds->data);
 	reset_array (view->priv->adds);
+	pending_sent (view);
 }
 
 static void
@@ -667,6 +740,7 @@ send_pending_changes (EDataCalView *view)
 		view->priv->gdbus_object,
 		(const gchar * const *) view->priv->changes->data);
 	reset_array (view->priv->changes);
+	pending_sent (view);
 }
 
 static void
@@ -680,17 +754,36 @@ send_pending_removes (EDataCalView *view)
 		view->priv->gdbus_object,
 		(const gchar * const *) view->priv->removes->data);
 	reset_array (view->priv->removes);
+	pending_sent (view);
 }
 
 static gboolean
 pending_flush_timeout_cb (gpointer data)
 {
 	EDataCalView *view = data;
+	gint64 now;
 
 	g_mutex_lock (&view->priv->pending_mutex);
 
+	now = g_get_monotonic_time ();
+
+	/* Notifications are still coming, wait for
+	 * more of them unless it takes too long */
+	if ((view->priv->flags & E_CAL_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT) == 0 &&
+	    view->priv->pending_items > 0 &&
+	    now - view->priv->last_queued < FLUSH_DELAY_MS * 1000 &&
+	    now - view->priv->pending_since < FLUSH_DELAY_MAX_MS * 1000) {
+		g_mutex_unlock (&view->priv->pending_mutex);
+		return TRUE;
+	}
+
 	view->priv->flush_id = 0;
 
+	/* Things calmed down, go back to smaller batches */
+	if (view->priv->pending_items < view->priv->batch_size / 2)
+		view->priv->batch_size = MAX (
+			view->priv->batch_size / 2, THRESHOLD_ITEMS);
+
 	send_pending_adds (view);
 	send_pending_changes (view);
 	send_pending_removes (view);
@@ -706,12 +799,12 @@ ensure_pending_flush_timeout (EDataCalView *view)
 	if (view->priv->flush_id > 0)
 		return;
 
-	if (e_data_cal_view_is_completed (view)) {
-		view->priv->flush_id = e_named_timeout_add (
-			10 /* ms */, pending_flush_timeout_cb, view);
-	} else {
+	if (view->priv->flags & E_CAL_CLIENT_VIEW_FLAGS_PREFER_THROUGHPUT) {
 		view->priv->flush_id = e_named_timeout_add_seconds (
 			THRESHOLD_SECONDS, pending_flush_timeout_cb, view);
+	} else {
+		view->priv->flush_id = e_named_timeout_add (
+			FLUSH_DELAY_MS, pending_flush_timeout_cb, view);
 	}
 }
 
@@ -730,10 +823,11 @@ notify_add_component (EDataCalView *view,
 	/* Do not send component add notifications during initial stage */
 	flags = e_data_cal_view_get_flags (view);
 	if (view->priv->complete || (flags & E_CAL_CLIENT_VIEW_FLAGS_NOTIFY_INITIAL) != 0) {
-		if (view->priv->adds->len == THRESHOLD_ITEMS)
+		if (pending_batch_full (view))
 			send_pending_adds (view);
 		g_array_append_val (view->priv->adds, obj);
 
+		pending_queued (view, strlen (obj));
 		ensure_pending_flush_timeout (view);
 	}
 
@@ -750,11 +844,12 @@ notify_change (EDataCalView *view,
 	send_pending_adds (view);
 	send_pending_removes (view);
 
-	if (view->priv->changes->len == THRESHOLD_ITEMS)
+	if (pending_batch_full (view))
 		send_pending_changes (view);
 
 	g_array_append_val (view->priv->changes, obj);
 
+	pending_queued (view, strlen (obj));
 	ensure_pending_flush_timeout (view);
 }
 
@@ -781,7 +876,7 @@ notify_remove (EDataCalView *view,
 	send_pending_adds (view);
 	send_pending_changes (view);
 
-	if (view->priv->removes->len == THRESHOLD_ITEMS)
+	if (pending_batch_full (view))
 		send_pending_removes (view);
 
 	/* store ECalComponentId as <uid>[\n<rid>] (matches D-Bus API) */
@@ -820,6 +915,7 @@ notify_remove (EDataCalView *view,
 
 	g_hash_table_remove (view->priv->ids, id);
 
+	pending_queued (view, uid_len + rid_len);
 	ensure_pending_flush_timeout (view);
 }
 
@@ -1048,6 +1144,43 @@ e_data_cal_view_get_flags (EDataCalView *view)
 	return view->priv->flags;
 }
 
+/**
+ * e_data_cal_view_get_notify_stats:
+ * @view: an #EDataCalView
+ * @out_n_signals: (out) (allow-none): return location for the number
+ *                 of signals emitted, or %NULL
+ * @out_n_objects: (out) (allow-none): return location for the number
+ *                 of objects sent in them, or %NULL
+ * @out_max_latency: (out) (allow-none): return location for the longest
+ *                   time an object was held back, in microseconds, or %NULL
+ *
+ * Gets statistics about the change notifications sent by @view, which
+ * are batched more when many of them come in a short time.
+ *
+ * Since: 3.20
+ **/
+void
+e_data_cal_view_get_notify_stats (EDataCalView *view,
+                                  guint *out_n_signals,
+                                  guint *out_n_objects,
+                                  gint64 *out_max_latency)
+{
+	g_return_if_fail (E_IS_DATA_CAL_VIEW (view));
+
+	g_mutex_lock (&view->priv->pending_mutex);
+
+	if (out_n_signals != NULL)
+		*out_n_signals = view->priv->n_signals;
+
+	if (out_n_objects != NULL)
+		*out_n_objects = view->priv->n_objects;
+
+	if (out_max_latency != NULL)
+		*out_max_latency = view->priv->max_latency;
+
+	g_mutex_unlock (&view->priv->pending_mutex);
+}
+
 static gboolean
 filter_component (icalcomponent *icomponent,
                   GHashTable *fields_of_interest,
@@ -88,6 +88,11 @@ GHashTable *	e_data_cal_view_get_fields_of_interest
 						(EDataCalView *view);
 ECalClientViewFlags
 		e_data_cal_view_get_flags	(EDataCalView *view);
+void		e_data_cal_view_get_notify_stats
+						(EDataCalView *view,
+						 guint *out_n_signals,
+						 guint *out_n_objects,
+						 gint64 *out_max_latency);
 
 gchar *		e_data_cal_view_get_component_string
 						(EDataCalView *view,
@@ -51,6 +51,13 @@
  * once an hour should be enough */
 #define CAMEL_DATA_CACHE_CYCLE_TIME (60*60)
 
+/* an item known to the size index */
+typedef struct _DataCacheEntry {
+	gchar *filename;
+	goffset size;		/* -1 until the item is written out */
+	GList link;		/* in the LRU queue, data points back here */
+} DataCacheEntry;
+
 struct _CamelDataCachePrivate {
 	CamelObjectBag *busy_bag;
 
@@ -60,6 +67,24 @@ struct _CamelDataCachePrivate {
 	time_t expire_access;
 
 	time_t expire_last[1 << CAMEL_DATA_CACHE_BITS];
+
+	/* Size index, only kept while a size limit is set.  It is filled
+	 * by a single walk of the cache directory in the background and
+	 * then maintained as items are added, read and removed. */
+	GMutex index_lock;
+	GHashTable *index;	/* filename -> DataCacheEntry */
+	GQueue lru;		/* DataCacheEntry, least recently used first */
+	goffset size_limit;
+	goffset total_size;
+	gboolean index_loaded;
+	gboolean evicting;
+	guint index_generation;	/* bumped whenever the index is reset */
+
+	gboolean write_behind;
+
+	guint64 hits;
+	guint64 misses;
+	guint64 evictions;
 };
 
 enum {
@@ -67,6 +92,8 @@ enum {
 	PROP_PATH
 };
 
+static void	data_cache_maybe_evict		(CamelDataCache *cdc);
+
 G_DEFINE_TYPE (CamelDataCache, camel_data_cache, G_TYPE_OBJECT)
 
 static void
@@ -103,6 +130,13 @@ data_cache_get_property (GObject *object,
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
 }
 
+static void
+data_cache_entry_free (DataCacheEntry *entry)
+{
+	g_free (entry->filename);
+	g_slice_free (DataCacheEntry, entry);
+}
+
 static void
 data_cache_finalize (GObject *object)
 {
@@ -113,6 +147,10 @@ data_cache_finalize (GObject *object)
 	camel_object_bag_destroy (priv->busy_bag);
 	g_free (priv->path);
 
+	if (priv->index)
+		g_hash_table_destroy (priv->index);
+	g_mutex_clear (&priv->index_lock);
+
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (camel_data_cache_parent_class)->finalize (object);
 }
@@ -155,6 +193,9 @@ camel_data_cache_init (CamelDataCache *data_cache)
 	data_cache->priv->busy_bag = busy_bag;
 	data_cache->priv->expire_age = -1;
 	data_cache->priv->expire_access = -1;
+
+	g_mutex_init (&data_cache->priv->index_lock);
+	g_queue_init (&data_cache->priv->lru);
 }
 
 /**
@@ -223,6 +264,19 @@ camel_data_cache_set_path (CamelDataCache *cdc,
 	g_free (cdc->priv->path);
 	cdc->priv->path = g_strdup (path);
 
+	/* The indexed items are those of the old path, start over */
+	g_mutex_lock (&cdc->priv->index_lock);
+	if (cdc->priv->index != NULL) {
+		g_queue_init (&cdc->priv->lru);
+		g_hash_table_remove_all (cdc->priv->index);
+		cdc->priv->index_loaded = FALSE;
+		cdc->priv->total_size = 0;
+	}
+	cdc->priv->index_generation++;
+	g_mutex_unlock (&cdc->priv->index_lock);
+
+	data_cache_maybe_evict (cdc);
+
 	g_object_notify (G_OBJECT (cdc), "path");
 }
 
@@ -274,6 +328,492 @@ camel_data_cache_set_expire_access (CamelDataCache *cdc,
 	cdc->priv->expire_access = when;
 }
 
+/* Call with index_lock held */
+static DataCacheEntry *
+data_cache_index_lookup (CamelDataCache *cdc,
+                         const gchar *filename,
+                         gboolean create)
+{
+	DataCacheEntry *entry;
+
+	if (cdc->priv->index == NULL)
+		return NULL;
+
+	entry = g_hash_table_lookup (cdc->priv->index, filename);
+	if (entry == NULL && create) {
+		entry = g_slice_new0 (DataCacheEntry);
+		entry->filename = g_strdup (filename);
+		entry->size = -1;
+		entry->link.data = entry;
+
+		g_hash_table_insert (cdc->priv->index, entry->filename, entry);
+		g_queue_push_tail_link (&cdc->priv->lru, &entry->link);
+	}
+
+	return entry;
+}
+
+/* Call with index_lock held */
+static void
+data_cache_index_set_size (CamelDataCache *cdc,
+                           DataCacheEntry *entry,
+                           goffset size)
+{
+	if (entry->size > 0)
+		cdc->priv->total_size -= entry->size;
+
+	entry->size = size;
+
+	if (entry->size > 0)
+		cdc->priv->total_size += entry->size;
+}
+
+/* Marks the item as the most recently used one, updating its size if
+ * set_size is TRUE.  A negative size means it is still being written
+ * and its size is not known yet. */
+static void
+data_cache_index_touch (CamelDataCache *cdc,
+                        const gchar *filename,
+                        gboolean set_size,
+                        goffset size)
+{
+	DataCacheEntry *entry;
+
+	g_mutex_lock (&cdc->priv->index_lock);
+
+	entry = data_cache_index_lookup (cdc, filename, TRUE);
+	if (entry != NULL) {
+		g_queue_unlink (&cdc->priv->lru, &entry->link);
+		g_queue_push_tail_link (&cdc->priv->lru, &entry->link);
+		if (set_size)
+			data_cache_index_set_size (cdc, entry, size);
+	}
+
+	g_mutex_unlock (&cdc->priv->index_lock);
+}
+
+static void
+data_cache_index_remove (CamelDataCache *cdc,
+                         const gchar *filename)
+{
+	DataCacheEntry *entry;
+
+	g_mutex_lock (&cdc->priv->index_lock);
+
+	entry = data_cache_index_lookup (cdc, filename, FALSE);
+	if (entry != NULL) {
+		data_cache_index_set_size (cdc, entry, -1);
+		g_queue_unlink (&cdc->priv->lru, &entry->link);
+		g_hash_table_remove (cdc->priv->index, filename);
+	}
+
+	g_mutex_unlock (&cdc->priv->index_lock);
+}
+
+typedef struct _DataCacheFound {
+	gchar *filename;
+	goffset size;
+	time_t atime;
+} DataCacheFound;
+
+static gint
+data_cache_found_compare_atime (gconstpointer a,
+                                gconstpointer b)
+{
+	const DataCacheFound *fa = a, *fb = b;
+
+	return fa->atime < fb->atime ? -1 : fa->atime > fb->atime ? 1 : 0;
+}
+
+/* Items live in '<path>/<2 hex digits>/<key>'; anything else
+ * under the cache directory is left alone. */
+static void
+data_cache_index_scan (const gchar *dirname,
+                       gint depth,
+                       GArray *found)
+{
+	const gchar *dname, *base;
+	gboolean item_dir;
+	struct stat st;
+	GDir *dir;
+
+	dir = g_dir_open (dirname, 0, NULL);
+	if (dir == NULL)
+		return;
+
+	base = strrchr (dirname, G_DIR_SEPARATOR);
+	base = base ? base + 1 : dirname;
+	item_dir = depth > 0 && strlen (base) == 2 &&
+		g_ascii_isxdigit (base[0]) && g_ascii_isxdigit (base[1]);
+
+	while ((dname = g_dir_read_name (dir))) {
+		gchar *dpath;
+
+		/* built the same way as data_cache_path() does */
+		dpath = g_strdup_printf ("%s/%s", dirname, dname);
+
+		if (g_stat (dpath, &st) == 0) {
+			if (S_ISDIR (st.st_mode) && depth < 8) {
+				data_cache_index_scan (dpath, depth + 1, found);
+			} else if (S_ISREG (st.st_mode) && item_dir) {
+				DataCacheFound item;
+
+				item.filename = dpath;
+				item.size = st.st_size;
+				item.atime = st.st_atime;
+				g_array_append_val (found, item);
+				dpath = NULL;
+			}
+		}
+
+		g_free (dpath);
+	}
+
+	g_dir_close (dir);
+}
+
+static gboolean
+data_cache_is_busy (CamelDataCache *cdc,
+                    const gchar *filename)
+{
+	GIOStream *stream;
+
+	stream = camel_object_bag_peek (cdc->priv->busy_bag, filename);
+	if (stream != NULL) {
+		g_object_unref (stream);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gpointer
+data_cache_evict_thread (gpointer user_data)
+{
+	CamelDataCache *cdc = user_data;
+	CamelDataCachePrivate *priv = cdc->priv;
+	GPtrArray *unsized;
+	GList *link;
+	guint ii, n_tries, generation;
+	gchar *path;
+
+	g_mutex_lock (&priv->index_lock);
+	generation = priv->index_generation;
+	g_mutex_unlock (&priv->index_lock);
+
+	if (!priv->index_loaded) {
+		GArray *found;
+
+		path = g_strdup (priv->path);
+		found = g_array_new (FALSE, FALSE, sizeof (DataCacheFound));
+		data_cache_index_scan (path, 0, found);
+		g_free (path);
+
+		/* Newest first, each pushed in front of the items touched
+		 * since the index was created, which are newer still. */
+		g_array_sort (found, data_cache_found_compare_atime);
+
+		g_mutex_lock (&priv->index_lock);
+
+		/* the path changed meanwhile, what was found is stale */
+		for (ii = found->len; ii > 0 && priv->index && generation == priv->index_generation; ii--) {
+			DataCacheFound *item = &g_array_index (found, DataCacheFound, ii - 1);
+			DataCacheEntry *entry;
+
+			if (g_hash_table_contains (priv->index, item->filename))
+				continue;
+
+			entry = g_slice_new0 (DataCacheEntry);
+			entry->filename = g_strdup (item->filename);
+			entry->size = -1;
+			entry->link.data = entry;
+
+			g_hash_table_insert (priv->index, entry->filename, entry);
+			g_queue_push_head_link (&priv->lru, &entry->link);
+			data_cache_index_set_size (cdc, entry, item->size);
+		}
+
+		if (generation == priv->index_generation)
+			priv->index_loaded = priv->index != NULL;
+
+		g_mutex_unlock (&priv->index_lock);
+
+		for (ii = 0; ii < found->len; ii++)
+			g_free (g_array_index (found, DataCacheFound, ii).filename);
+		g_array_free (found, TRUE);
+	}
+
+	/* Pick up the sizes of the items written since the last run */
+	unsized = g_ptr_array_new_with_free_func (g_free);
+
+	g_mutex_lock (&priv->index_lock);
+	for (link = priv->lru.head; link; link = g_list_next (link)) {
+		DataCacheEntry *entry = link->data;
+
+		if (entry->size < 0)
+			g_ptr_array_add (unsized, g_strdup (entry->filename));
+	}
+	g_mutex_unlock (&priv->index_lock);
+
+	for (ii = 0; ii < unsized->len; ii++) {
+		const gchar *filename = unsized->pdata[ii];
+		struct stat st;
+
+		if (data_cache_is_busy (cdc, filename))
+			continue;
+
+		if (g_stat (filename, &st) == 0) {
+			DataCacheEntry *entry;
+
+			g_mutex_lock (&priv->index_lock);
+			entry = data_cache_index_lookup (cdc, filename, FALSE);
+			if (entry != NULL && entry->size < 0)
+				data_cache_index_set_size (cdc, entry, st.st_size);
+			g_mutex_unlock (&priv->index_lock);
+		} else {
+			data_cache_index_remove (cdc, filename);
+		}
+	}
+
+	g_ptr_array_unref (unsized);
+
+	/* Evict least recently used items down to the budget; items
+	 * which are open are moved to the back and kept. */
+	g_mutex_lock (&priv->index_lock);
+
+	n_tries = g_queue_get_length (&priv->lru);
+	while (priv->size_limit > 0 && priv->total_size > priv->size_limit && n_tries-- > 0) {
+		DataCacheEntry *entry = g_queue_peek_head (&priv->lru);
+		gchar *filename;
+
+		if (entry == NULL)
+			break;
+
+		filename = g_strdup (entry->filename);
+
+		g_queue_unlink (&priv->lru, &entry->link);
+		g_queue_push_tail_link (&priv->lru, &entry->link);
+
+		g_mutex_unlock (&priv->index_lock);
+
+		if (!data_cache_is_busy (cdc, filename) && g_unlink (filename) == 0) {
+			data_cache_index_remove (cdc, filename);
+
+			g_mutex_lock (&priv->index_lock);
+			priv->evictions++;
+		} else {
+			g_mutex_lock (&priv->index_lock);
+		}
+
+		g_free (filename);
+	}
+
+	priv->evicting = FALSE;
+
+	g_mutex_unlock (&priv->index_lock);
+
+	g_object_unref (cdc);
+
+	return NULL;
+}
+
+/* Starts an eviction run in the background, unless one is already going */
+static void
+data_cache_maybe_evict (CamelDataCache *cdc)
+{
+	gboolean start;
+
+	g_mutex_lock (&cdc->priv->index_lock);
+
+	start = cdc->priv->size_limit > 0 && !cdc->priv->evicting &&
+		(!cdc->priv->index_loaded || cdc->priv->total_size > cdc->priv->size_limit);
+	if (start)
+		cdc->priv->evicting = TRUE;
+
+	g_mutex_unlock (&cdc->priv->index_lock);
+
+	if (start) {
+		GThread *thread;
+
+		thread = g_thread_new (NULL, data_cache_evict_thread, g_object_ref (cdc));
+		g_thread_unref (thread);
+	}
+}
+
+typedef struct _DataCacheAdded {
+	CamelDataCache *cdc;
+	gchar *filename;
+} DataCacheAdded;
+
+/* The stream returned by camel_data_cache_add() is gone, and with it
+ * closed, so the size of the item is final: account for it, and make
+ * room for it if the cache went over its size limit. */
+static void
+data_cache_added_stream_gone_cb (gpointer user_data,
+                                 GObject *where_the_object_was)
+{
+	DataCacheAdded *added = user_data;
+	CamelDataCache *cdc = added->cdc;
+	DataCacheEntry *entry;
+	struct stat st;
+
+	if (g_stat (added->filename, &st) == 0) {
+		g_mutex_lock (&cdc->priv->index_lock);
+		entry = data_cache_index_lookup (cdc, added->filename, FALSE);
+		if (entry != NULL)
+			data_cache_index_set_size (cdc, entry, st.st_size);
+		g_mutex_unlock (&cdc->priv->index_lock);
+
+		data_cache_maybe_evict (cdc);
+	} else {
+		/* renamed or removed meanwhile */
+		data_cache_index_remove (cdc, added->filename);
+	}
+
+	g_object_unref (added->cdc);
+	g_free (added->filename);
+	g_slice_free (DataCacheAdded, added);
+}
+
+/**
+ * camel_data_cache_set_size_limit:
+ * @cdc: a #CamelDataCache
+ * @size_limit: the most bytes the cache may occupy, or 0 for no limit
+ *
+ * Bounds the total size of the items in the cache.  Once it grows past
+ * @size_limit, the least recently used items are removed in a background
+ * thread until it fits again.  Items which are currently open are left
+ * alone.  The size of an item added with camel_data_cache_add() counts
+ * once the returned stream is closed and released.
+ *
+ * Since: 3.20
+ **/
+void
+camel_data_cache_set_size_limit (CamelDataCache *cdc,
+                                 goffset size_limit)
+{
+	g_return_if_fail (CAMEL_IS_DATA_CACHE (cdc));
+
+	g_mutex_lock (&cdc->priv->index_lock);
+
+	cdc->priv->size_limit = MAX (size_limit, 0);
+
+	if (cdc->priv->size_limit > 0 && cdc->priv->index == NULL) {
+		cdc->priv->index = g_hash_table_new_full (
+			g_str_hash, g_str_equal,
+			(GDestroyNotify) NULL,
+			(GDestroyNotify) data_cache_entry_free);
+		cdc->priv->index_loaded = FALSE;
+	} else if (cdc->priv->size_limit == 0 && cdc->priv->index != NULL) {
+		/* the entries are freed with the table */
+		g_queue_init (&cdc->priv->lru);
+		g_hash_table_destroy (cdc->priv->index);
+		cdc->priv->index = NULL;
+		cdc->priv->index_loaded = FALSE;
+		cdc->priv->total_size = 0;
+	}
+
+	g_mutex_unlock (&cdc->priv->index_lock);
+
+	data_cache_maybe_evict (cdc);
+}
+
+/**
+ * camel_data_cache_get_size_limit:
+ * @cdc: a #CamelDataCache
+ *
+ * Returns: the size limit set by camel_data_cache_set_size_limit(),
+ * or 0 when the cache size is not bounded
+ *
+ * Since: 3.20
+ **/
+goffset
+camel_data_cache_get_size_limit (CamelDataCache *cdc)
+{
+	g_return_val_if_fail (CAMEL_IS_DATA_CACHE (cdc), 0);
+
+	return cdc->priv->size_limit;
+}
+
+/**
+ * camel_data_cache_get_stats:
+ * @cdc: a #CamelDataCache
+ * @hits: (out) (allow-none): return location for the number of lookups
+ *   which found their item, or %NULL
+ * @misses: (out) (allow-none): return location for the number of lookups
+ *   which did not, or %NULL
+ * @evictions: (out) (allow-none): return location for the number of items
+ *   removed to keep within the size limit, or %NULL
+ *
+ * Returns counters of camel_data_cache_get() results and of size limit
+ * evictions since @cdc was created.
+ *
+ * Since: 3.20
+ **/
+void
+camel_data_cache_get_stats (CamelDataCache *cdc,
+                            guint64 *hits,
+                            guint64 *misses,
+                            guint64 *evictions)
+{
+	g_return_if_fail (CAMEL_IS_DATA_CACHE (cdc));
+
+	g_mutex_lock (&cdc->priv->index_lock);
+
+	if (hits)
+		*hits = cdc->priv->hits;
+	if (misses)
+		*misses = cdc->priv->misses;
+	if (evictions)
+		*evictions = cdc->priv->evictions;
+
+	g_mutex_unlock (&cdc->priv->index_lock);
+}
+
+/**
+ * camel_data_cache_set_write_behind:
+ * @cdc: a #CamelDataCache
+ * @write_behind: whether new items are written in the background
+ *
+ * Sets whether the streams returned by camel_data_cache_add() from now
+ * on write in the background.  Their writes are queued in memory and a
+ * dedicated thread writes them to disk, so that a caller receiving the
+ * data from the network does not wait for the disk.  The caller only
+ * waits when a bounded amount of data is queued already, or when it
+ * seeks elsewhere, flushes or closes the stream.
+ *
+ * A failed write is reported by the following write or flush, or by
+ * g_io_stream_close(), whose result thus has to be checked.  Flush such
+ * a stream before reading from it.
+ *
+ * Since: 3.20
+ **/
+void
+camel_data_cache_set_write_behind (CamelDataCache *cdc,
+                                   gboolean write_behind)
+{
+	g_return_if_fail (CAMEL_IS_DATA_CACHE (cdc));
+
+	cdc->priv->write_behind = write_behind;
+}
+
+/**
+ * camel_data_cache_get_write_behind:
+ * @cdc: a #CamelDataCache
+ *
+ * Returns: whether new items are written in the background,
+ * see camel_data_cache_set_write_behind()
+ *
+ * Since: 3.20
+ **/
+gboolean
+camel_data_cache_get_write_behind (CamelDataCache *cdc)
+{
+	g_return_val_if_fail (CAMEL_IS_DATA_CACHE (cdc), FALSE);
+
+	return cdc->priv->write_behind;
+}
+
 static void
 data_cache_expire (CamelDataCache *cdc,
                    const gchar *path,
@@ -304,6 +844,7 @@ data_cache_expire (CamelDataCache *cdc,
 			|| (cdc->priv->expire_age != -1 && st.st_mtime + cdc->priv->expire_age < now)
 			|| (cdc->priv->expire_access != -1 && st.st_atime + cdc->priv->expire_access < now))) {
 			g_unlink (dpath);
+			data_cache_index_remove (cdc, dpath);
 			stream = camel_object_bag_get (cdc->priv->busy_bag, dpath);
 			if (stream) {
 				camel_object_bag_remove (cdc->priv->busy_bag, stream);
@@ -357,6 +898,446 @@ data_cache_path (CamelDataCache *cdc,
 	return real;
 }
 
+/* Write-behind streams, see camel_data_cache_set_write_behind().
+ *
+ * Writes are queued as chunks of up to WRITE_BEHIND_CHUNK_SIZE and
+ * return at once; a single shared I/O thread writes the chunks out,
+ * one stream at a time.  The writer only waits when more than
+ * WRITE_BEHIND_MAX_QUEUED bytes are queued, or when it seeks
+ * elsewhere, flushes or closes the stream.  A failed write is
+ * reported by the following write, flush or close. */
+
+#define WRITE_BEHIND_CHUNK_SIZE (64 * 1024)
+#define WRITE_BEHIND_MAX_QUEUED (1024 * 1024)
+
+typedef struct _DataCacheOutput DataCacheOutput;
+typedef struct _DataCacheOutputClass DataCacheOutputClass;
+
+struct _DataCacheOutput {
+	GOutputStream parent;
+
+	GIOStream *base;
+
+	GMutex lock;
+	GCond cond;
+	GQueue queue;		/* GByteArray chunks, oldest first */
+	gsize n_queued;		/* bytes in the queue or being written */
+	goffset position;	/* where the next write lands, while draining */
+	gboolean draining;	/* a drain of the queue is pending or running */
+	GError *error;		/* the first failed write */
+};
+
+struct _DataCacheOutputClass {
+	GOutputStreamClass parent_class;
+};
+
+typedef struct _DataCacheIOStream DataCacheIOStream;
+typedef struct _DataCacheIOStreamClass DataCacheIOStreamClass;
+
+struct _DataCacheIOStream {
+	GIOStream parent;
+
+	GIOStream *base;
+	DataCacheOutput *output;
+};
+
+struct _DataCacheIOStreamClass {
+	GIOStreamClass parent_class;
+};
+
+static GType data_cache_output_get_type (void);
+static GType data_cache_io_stream_get_type (void);
+static void data_cache_io_stream_seekable_init (GSeekableIface *iface);
+
+G_DEFINE_TYPE (DataCacheOutput, data_cache_output, G_TYPE_OUTPUT_STREAM)
+
+G_DEFINE_TYPE_WITH_CODE (DataCacheIOStream, data_cache_io_stream, G_TYPE_IO_STREAM,
+	G_IMPLEMENT_INTERFACE (G_TYPE_SEEKABLE, data_cache_io_stream_seekable_init))
+
+static void
+data_cache_output_drain (gpointer data,
+                         gpointer user_data)
+{
+	DataCacheOutput *output = data;
+	GOutputStream *base_output;
+
+	base_output = g_io_stream_get_output_stream (output->base);
+
+	g_mutex_lock (&output->lock);
+
+	while (!g_queue_is_empty (&output->queue)) {
+		GByteArray *chunk = g_queue_pop_head (&output->queue);
+		GError *local_error = NULL;
+		gboolean failed = output->error != NULL;
+
+		g_mutex_unlock (&output->lock);
+
+		/* after a failure the rest is only dropped */
+		if (!failed)
+			g_output_stream_write_all (
+				base_output, chunk->data, chunk->len,
+				NULL, NULL, &local_error);
+
+		g_mutex_lock (&output->lock);
+
+		if (local_error != NULL && output->error == NULL)
+			output->error = local_error;
+		else
+			g_clear_error (&local_error);
+
+		output->n_queued -= chunk->len;
+		g_byte_array_unref (chunk);
+
+		g_cond_broadcast (&output->cond);
+	}
+
+	output->draining = FALSE;
+	g_cond_broadcast (&output->cond);
+
+	g_mutex_unlock (&output->lock);
+
+	g_object_unref (output);
+}
+
+static GThreadPool *
+data_cache_output_get_pool (void)
+{
+	static GThreadPool *pool;
+	static gsize pool_initialized = 0;
+
+	if (g_once_init_enter (&pool_initialized)) {
+		pool = g_thread_pool_new (
+			data_cache_output_drain, NULL, 1, FALSE, NULL);
+		g_once_init_leave (&pool_initialized, 1);
+	}
+
+	return pool;
+}
+
+/* Waits until everything queued is written, call with the lock held */
+static gboolean
+data_cache_output_wait_locked (DataCacheOutput *output,
+                               GError **error)
+{
+	while (output->draining)
+		g_cond_wait (&output->cond, &output->lock);
+
+	if (output->error != NULL) {
+		g_propagate_error (error, g_error_copy (output->error));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gssize
+data_cache_output_write (GOutputStream *stream,
+                         const void *buffer,
+                         gsize count,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	DataCacheOutput *output = (DataCacheOutput *) stream;
+	GByteArray *chunk;
+
+	g_mutex_lock (&output->lock);
+
+	while (output->error == NULL && output->n_queued >= WRITE_BEHIND_MAX_QUEUED)
+		g_cond_wait (&output->cond, &output->lock);
+
+	if (output->error != NULL) {
+		g_propagate_error (error, g_error_copy (output->error));
+		g_mutex_unlock (&output->lock);
+		return -1;
+	}
+
+	/* Nothing is being written, the base stream knows where it is;
+	 * its input side shares the position and may have moved it */
+	if (!output->draining)
+		output->position = g_seekable_tell (G_SEEKABLE (output->base));
+
+	/* Small writes are merged, the I/O thread never touches
+	 * the chunks while they are in the queue */
+	chunk = g_queue_peek_tail (&output->queue);
+	if (chunk == NULL || chunk->len + count > WRITE_BEHIND_CHUNK_SIZE) {
+		chunk = g_byte_array_sized_new (MAX (count, WRITE_BEHIND_CHUNK_SIZE));
+		g_queue_push_tail (&output->queue, chunk);
+	}
+
+	g_byte_array_append (chunk, buffer, count);
+	output->n_queued += count;
+	output->position += count;
+
+	if (!output->draining) {
+		output->draining = TRUE;
+		g_thread_pool_push (
+			data_cache_output_get_pool (),
+			g_object_ref (output), NULL);
+	}
+
+	g_mutex_unlock (&output->lock);
+
+	return count;
+}
+
+static gboolean
+data_cache_output_flush (GOutputStream *stream,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	DataCacheOutput *output = (DataCacheOutput *) stream;
+	gboolean success;
+
+	g_mutex_lock (&output->lock);
+	success = data_cache_output_wait_locked (output, error);
+	g_mutex_unlock (&output->lock);
+
+	if (success)
+		success = g_output_stream_flush (
+			g_io_stream_get_output_stream (output->base),
+			cancellable, error);
+
+	return success;
+}
+
+static gboolean
+data_cache_output_close (GOutputStream *stream,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	DataCacheOutput *output = (DataCacheOutput *) stream;
+	gboolean success;
+
+	/* The base stream is closed with the DataCacheIOStream */
+	g_mutex_lock (&output->lock);
+	success = data_cache_output_wait_locked (output, error);
+	g_mutex_unlock (&output->lock);
+
+	return success;
+}
+
+static void
+data_cache_output_finalize (GObject *object)
+{
+	DataCacheOutput *output = (DataCacheOutput *) object;
+
+	/* the queue is empty, a pending drain holds a reference */
+	g_object_unref (output->base);
+	g_mutex_clear (&output->lock);
+	g_cond_clear (&output->cond);
+	g_clear_error (&output->error);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (data_cache_output_parent_class)->finalize (object);
+}
+
+static void
+data_cache_output_class_init (DataCacheOutputClass *class)
+{
+	GObjectClass *object_class;
+	GOutputStreamClass *output_stream_class;
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->finalize = data_cache_output_finalize;
+
+	output_stream_class = G_OUTPUT_STREAM_CLASS (class);
+	output_stream_class->write_fn = data_cache_output_write;
+	output_stream_class->flush = data_cache_output_flush;
+	output_stream_class->close_fn = data_cache_output_close;
+}
+
+static void
+data_cache_output_init (DataCacheOutput *output)
+{
+	g_mutex_init (&output->lock);
+	g_cond_init (&output->cond);
+	g_queue_init (&output->queue);
+}
+
+static GInputStream *
+data_cache_io_stream_get_input_stream (GIOStream *stream)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) stream;
+
+	return g_io_stream_get_input_stream (io_stream->base);
+}
+
+static GOutputStream *
+data_cache_io_stream_get_output_stream (GIOStream *stream)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) stream;
+
+	return G_OUTPUT_STREAM (io_stream->output);
+}
+
+static gboolean
+data_cache_io_stream_close (GIOStream *stream,
+                            GCancellable *cancellable,
+                            GError **error)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) stream;
+	GError *local_error = NULL;
+
+	/* Completes the queued writes and reports their failure */
+	g_output_stream_close (
+		G_OUTPUT_STREAM (io_stream->output),
+		cancellable, &local_error);
+
+	if (local_error == NULL)
+		g_io_stream_close (io_stream->base, cancellable, &local_error);
+	else
+		g_io_stream_close (io_stream->base, cancellable, NULL);
+
+	if (local_error != NULL) {
+		g_propagate_error (error, local_error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+data_cache_io_stream_dispose (GObject *object)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) object;
+
+	/* Chain up to parent's dispose() method, which closes the stream */
+	G_OBJECT_CLASS (data_cache_io_stream_parent_class)->dispose (object);
+
+	g_clear_object (&io_stream->output);
+	g_clear_object (&io_stream->base);
+}
+
+static goffset
+data_cache_io_stream_tell (GSeekable *seekable)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) seekable;
+	DataCacheOutput *output = io_stream->output;
+	goffset position;
+
+	g_mutex_lock (&output->lock);
+	if (output->draining)
+		position = output->position;
+	else
+		position = g_seekable_tell (G_SEEKABLE (io_stream->base));
+	g_mutex_unlock (&output->lock);
+
+	return position;
+}
+
+static gboolean
+data_cache_io_stream_can_seek (GSeekable *seekable)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) seekable;
+
+	return g_seekable_can_seek (G_SEEKABLE (io_stream->base));
+}
+
+static gboolean
+data_cache_io_stream_seek (GSeekable *seekable,
+                           goffset offset,
+                           GSeekType type,
+                           GCancellable *cancellable,
+                           GError **error)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) seekable;
+	DataCacheOutput *output = io_stream->output;
+	gboolean success;
+
+	g_mutex_lock (&output->lock);
+
+	/* Sequential writes which seek to where they are already,
+	 * like the IMAP fetches do, need not wait for the disk */
+	if (output->draining &&
+	    ((type == G_SEEK_SET && offset == output->position) ||
+	     (type == G_SEEK_CUR && offset == 0))) {
+		g_mutex_unlock (&output->lock);
+		return TRUE;
+	}
+
+	success = data_cache_output_wait_locked (output, error) &&
+		g_seekable_seek (
+			G_SEEKABLE (io_stream->base),
+			offset, type, cancellable, error);
+
+	g_mutex_unlock (&output->lock);
+
+	return success;
+}
+
+static gboolean
+data_cache_io_stream_can_truncate (GSeekable *seekable)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) seekable;
+
+	return g_seekable_can_truncate (G_SEEKABLE (io_stream->base));
+}
+
+static gboolean
+data_cache_io_stream_truncate (GSeekable *seekable,
+                               goffset offset,
+                               GCancellable *cancellable,
+                               GError **error)
+{
+	DataCacheIOStream *io_stream = (DataCacheIOStream *) seekable;
+	DataCacheOutput *output = io_stream->output;
+	gboolean success;
+
+	g_mutex_lock (&output->lock);
+
+	success = data_cache_output_wait_locked (output, error) &&
+		g_seekable_truncate (
+			G_SEEKABLE (io_stream->base),
+			offset, cancellable, error);
+
+	g_mutex_unlock (&output->lock);
+
+	return success;
+}
+
+static void
+data_cache_io_stream_class_init (DataCacheIOStreamClass *class)
+{
+	GObjectClass *object_class;
+	GIOStreamClass *io_stream_class;
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->dispose = data_cache_io_stream_dispose;
+
+	io_stream_class = G_IO_STREAM_CLASS (class);
+	io_stream_class->get_input_stream = data_cache_io_stream_get_input_stream;
+	io_stream_class->get_output_stream = data_cache_io_stream_get_output_stream;
+	io_stream_class->close_fn = data_cache_io_stream_close;
+}
+
+static void
+data_cache_io_stream_seekable_init (GSeekableIface *iface)
+{
+	iface->tell = data_cache_io_stream_tell;
+	iface->can_seek = data_cache_io_stream_can_seek;
+	iface->seek = data_cache_io_stream_seek;
+	iface->can_truncate = data_cache_io_stream_can_truncate;
+	iface->truncate_fn = data_cache_io_stream_truncate;
+}
+
+static void
+data_cache_io_stream_init (DataCacheIOStream *io_stream)
+{
+}
+
+static GIOStream *
+data_cache_io_stream_new (GIOStream *base)
+{
+	DataCacheIOStream *io_stream;
+
+	io_stream = g_object_new (data_cache_io_stream_get_type (), NULL);
+	io_stream->base = g_object_ref (base);
+	io_stream->output = g_object_new (data_cache_output_get_type (), NULL);
+	io_stream->output->base = g_object_ref (base);
+
+	return G_IO_STREAM (io_stream);
+}
+
 /**
  * camel_data_cache_add:
  * @cdc: A #CamelDataCache
@@ -384,6 +1365,7 @@ camel_data_cache_add (CamelDataCache *cdc,
 {
 	gchar *real;
 	GFileIOStream *stream;
+	GIOStream *io_stream = NULL;
 	GFile *file;
 
 	g_return_val_if_fail (CAMEL_IS_DATA_CACHE (cdc), NULL);
@@ -406,14 +1388,32 @@ camel_data_cache_add (CamelDataCache *cdc,
 		file, NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL, error);
 	g_object_unref (file);
 
-	if (stream != NULL)
-		camel_object_bag_add (cdc->priv->busy_bag, real, stream);
-	else
+	if (stream != NULL) {
+		DataCacheAdded *added;
+
+		if (cdc->priv->write_behind) {
+			io_stream = data_cache_io_stream_new (G_IO_STREAM (stream));
+			g_object_unref (stream);
+		} else {
+			io_stream = G_IO_STREAM (stream);
+		}
+
+		camel_object_bag_add (cdc->priv->busy_bag, real, io_stream);
+		data_cache_index_touch (cdc, real, TRUE, -1);
+
+		added = g_slice_new (DataCacheAdded);
+		added->cdc = g_object_ref (cdc);
+		added->filename = g_strdup (real);
+		g_object_weak_ref (
+			G_OBJECT (io_stream),
+			data_cache_added_stream_gone_cb, added);
+	} else {
 		camel_object_bag_abort (cdc->priv->busy_bag, real);
+	}
 
 	g_free (real);
 
-	return G_IO_STREAM (stream);
+	return io_stream;
 }
 
 /**
@@ -447,11 +1447,16 @@ camel_data_cache_get (CamelDataCache *cdc,
 
 	real = data_cache_path (cdc, FALSE, path, key);
 	stream = camel_object_bag_reserve (cdc->priv->busy_bag, real);
-	if (stream != NULL)
+	if (stream != NULL) {
+		data_cache_index_touch (cdc, real, FALSE, -1);
 		goto exit;
+	}
+
+	if (g_stat (real, &st) == -1)
+		st.st_size = -1;
 
 	/* An empty cache file is useless.  Return an error. */
-	if (g_stat (real, &st) == 0 && st.st_size == 0) {
+	if (st.st_size == 0) {
 		g_set_error (
 			error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
 			"%s: %s", _("Empty cache file"), real);
@@ -463,12 +1468,22 @@ camel_data_cache_get (CamelDataCache *cdc,
 	stream = g_file_open_readwrite (file, NULL, error);
 	g_object_unref (file);
 
-	if (stream != NULL)
+	if (stream != NULL) {
 		camel_object_bag_add (cdc->priv->busy_bag, real, stream);
-	else
+		data_cache_index_touch (cdc, real, TRUE, st.st_size);
+		data_cache_maybe_evict (cdc);
+	} else {
 		camel_object_bag_abort (cdc->priv->busy_bag, real);
+	}
 
 exit:
+	g_mutex_lock (&cdc->priv->index_lock);
+	if (stream != NULL)
+		cdc->priv->hits++;
+	else
+		cdc->priv->misses++;
+	g_mutex_unlock (&cdc->priv->index_lock);
+
 	g_free (real);
 
 	return G_IO_STREAM (stream);
@@ -526,6 +1541,8 @@ camel_data_cache_remove (CamelDataCache *cdc,
 		g_object_unref (stream);
 	}
 
+	data_cache_index_remove (cdc, real);
+
 	/* maybe we were a mem stream */
 	if (g_unlink (real) == -1 && errno != ENOENT) {
 		g_set_error (
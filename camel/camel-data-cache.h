@@ -72,6 +72,18 @@ void		camel_data_cache_set_expire_age	(CamelDataCache *cdc,
 void		camel_data_cache_set_expire_access
 						(CamelDataCache *cdc,
 						 time_t when);
+void		camel_data_cache_set_size_limit	(CamelDataCache *cdc,
+						 goffset size_limit);
+goffset		camel_data_cache_get_size_limit	(CamelDataCache *cdc);
+void		camel_data_cache_get_stats	(CamelDataCache *cdc,
+						 guint64 *hits,
+						 guint64 *misses,
+						 guint64 *evictions);
+void		camel_data_cache_set_write_behind
+						(CamelDataCache *cdc,
+						 gboolean write_behind);
+gboolean	camel_data_cache_get_write_behind
+						(CamelDataCache *cdc);
 GIOStream *	camel_data_cache_add		(CamelDataCache *cdc,
 						 const gchar *path,
 						 const gchar *key,
@@ -135,8 +135,8 @@ data_wrapper_write_to_stream_sync (CamelDataWrapper *data_wrapper,
                                    GCancellable *cancellable,
                                    GError **error)
 {
-	CamelStream *memory_stream;
-	gssize ret;
+	GByteArray *byte_array;
+	gsize n_written = 0;
 
 	g_mutex_lock (&data_wrapper->priv->stream_lock);
 
@@ -146,21 +146,30 @@ data_wrapper_write_to_stream_sync (CamelDataWrapper *data_wrapper,
 		return -1;
 	}
 
-	memory_stream = camel_stream_mem_new ();
+	/* The content is already in memory, so hand it to the stream
+	 * as one block rather than copying it through a memory stream
+	 * in small chunks; this lets the underlying stream (and any
+	 * filters on top of it) process the data in as few writes as
+	 * it can. */
+	byte_array = data_wrapper->priv->byte_array;
 
-	/* We retain ownership of the byte array. */
-	camel_stream_mem_set_byte_array (
-		CAMEL_STREAM_MEM (memory_stream),
-		data_wrapper->priv->byte_array);
+	while (n_written < byte_array->len) {
+		gssize len;
 
-	ret = camel_stream_write_to_stream (
-		memory_stream, stream, cancellable, error);
+		len = camel_stream_write (
+			stream, (const gchar *) byte_array->data + n_written,
+			byte_array->len - n_written, cancellable, error);
+		if (len < 0) {
+			g_mutex_unlock (&data_wrapper->priv->stream_lock);
+			return -1;
+		}
 
-	g_object_unref (memory_stream);
+		n_written += len;
+	}
 
 	g_mutex_unlock (&data_wrapper->priv->stream_lock);
 
-	return ret;
+	return (gssize) n_written;
 }
 
 static gssize
@@ -41,12 +41,14 @@
 #include "camel-filter-driver.h"
 #include "camel-filter-search.h"
 #include "camel-mime-message.h"
+#include "camel-search-private.h"
 #include "camel-service.h"
 #include "camel-session.h"
 #include "camel-sexp.h"
 #include "camel-store.h"
 #include "camel-stream-fs.h"
 #include "camel-stream-mem.h"
+#include "camel-utf8.h"
 
 #define d(x)
 
@@ -70,6 +72,15 @@ struct _filter_rule {
 	gchar *match;
 	gchar *action;
 	gchar *name;
+
+	/* Pre-analysed form of simple '(match-all (header-xxx "name" ...))'
+	 * rules, which can be decided from the message info alone. */
+	gboolean simple;
+	guint info_key;            /* CAMEL_MESSAGE_INFO_SUBJECT, _FROM, ... */
+	camel_search_match_t how;
+	gchar **values;
+	gchar **index_keys;        /* keys in the rule index, or NULL */
+	guint serial;              /* last message this rule was a candidate for */
 };
 
 struct _CamelFilterDriverPrivate {
@@ -114,6 +125,10 @@ struct _CamelFilterDriverPrivate {
 	FILE *logfile;             /* log file */
 
 	GQueue rules;		   /* queue of _filter_rule structs */
+	GHashTable *rule_index;    /* mailing list key -> GPtrArray of exact-match rules */
+	guint rule_serial;         /* bumped for every filtered message */
+	guint64 rules_evaluated;   /* rules run through the full search expression */
+	guint64 rules_skipped;     /* rules decided from the rule index or message info */
 
 	GError *error;
 
@@ -186,6 +201,269 @@ filter_rule_compare_by_name (struct _filter_rule *rule,
 	return g_strcmp0 (rule->name, name);
 }
 
+static const struct {
+	const gchar *name;
+	camel_search_match_t how;
+} simple_rule_funcs[] = {
+	{ "header-contains",    CAMEL_SEARCH_MATCH_CONTAINS },
+	{ "header-has-words",   CAMEL_SEARCH_MATCH_WORD },
+	{ "header-matches",     CAMEL_SEARCH_MATCH_EXACT },
+	{ "header-starts-with", CAMEL_SEARCH_MATCH_STARTS },
+	{ "header-ends-with",   CAMEL_SEARCH_MATCH_ENDS }
+};
+
+static const struct {
+	const gchar *name;
+	guint info_key;
+} simple_rule_headers[] = {
+	{ "x-camel-mlist", CAMEL_MESSAGE_INFO_MLIST },
+	{ "Subject",       CAMEL_MESSAGE_INFO_SUBJECT },
+	{ "From",          CAMEL_MESSAGE_INFO_FROM },
+	{ "To",            CAMEL_MESSAGE_INFO_TO },
+	{ "Cc",            CAMEL_MESSAGE_INFO_CC }
+};
+
+/* The key a mailing list value or an exact-match constant is indexed
+ * under: everything before the domain, lowercased the same way as
+ * camel_search_header_match() compares it, so that two values which
+ * match exactly (including the old-style list name hack, which drops
+ * the domain) always share a key. */
+static gchar *
+filter_rule_index_key (const gchar *value)
+{
+	const guchar *ptr = (const guchar *) value;
+	GString *key;
+	gunichar c;
+
+	key = g_string_sized_new (strlen (value));
+
+	while ((c = camel_utf8_getc (&ptr)) != 0 && c != '@')
+		g_string_append_unichar (key, g_unichar_tolower (c));
+
+	return g_string_free (key, FALSE);
+}
+
+static gboolean
+filter_rule_is_wrapper (const gchar *name)
+{
+	return g_strcmp0 (name, "match-all") == 0 ||
+		g_strcmp0 (name, "and") == 0 ||
+		g_strcmp0 (name, "or") == 0;
+}
+
+/* Recognises rules consisting of a single header test against constant
+ * strings, on a header which camel_filter_search_match() answers from the
+ * message info, and records what is needed to decide them without the
+ * search expression.  Anything else is left to the full evaluation. */
+static void
+filter_rule_analyse (struct _filter_rule *rule)
+{
+	CamelSExp *sexp;
+	CamelSExpTerm *term;
+	gint ii;
+
+	sexp = camel_sexp_new ();
+
+	camel_sexp_add_ifunction (sexp, 0, "match-all", NULL, NULL);
+	for (ii = 0; ii < G_N_ELEMENTS (simple_rule_funcs); ii++)
+		camel_sexp_add_function (sexp, 0, simple_rule_funcs[ii].name, NULL, NULL);
+
+	camel_sexp_input_text (sexp, rule->match, strlen (rule->match));
+	if (camel_sexp_parse (sexp) == -1 || !sexp->tree)
+		goto exit;
+
+	/* Rules built by EFilterRule wrap their parts in (and ...) or
+	 * (or ...), depending on the grouping, and the parts and possibly
+	 * the whole rule in (match-all ...); with a single part, all of
+	 * these reduce to it. */
+	term = sexp->tree;
+	while (term->type == CAMEL_SEXP_TERM_IFUNC &&
+	       term->value.func.termcount == 1 &&
+	       filter_rule_is_wrapper (term->value.func.sym->name))
+		term = term->value.func.terms[0];
+
+	if (term->type != CAMEL_SEXP_TERM_FUNC || term->value.func.termcount < 2)
+		goto exit;
+
+	for (ii = 0; ii < G_N_ELEMENTS (simple_rule_funcs); ii++) {
+		if (g_strcmp0 (term->value.func.sym->name, simple_rule_funcs[ii].name) == 0)
+			break;
+	}
+
+	if (ii == G_N_ELEMENTS (simple_rule_funcs))
+		goto exit;
+
+	rule->how = simple_rule_funcs[ii].how;
+
+	if (term->value.func.terms[0]->type != CAMEL_SEXP_TERM_STRING)
+		goto exit;
+
+	for (ii = 0; ii < G_N_ELEMENTS (simple_rule_headers); ii++) {
+		if (g_ascii_strcasecmp (term->value.func.terms[0]->value.string, simple_rule_headers[ii].name) == 0)
+			break;
+	}
+
+	if (ii == G_N_ELEMENTS (simple_rule_headers))
+		goto exit;
+
+	rule->info_key = simple_rule_headers[ii].info_key;
+
+	/* An empty constant matches any message; leave such rules alone. */
+	for (ii = 1; ii < term->value.func.termcount; ii++) {
+		if (term->value.func.terms[ii]->type != CAMEL_SEXP_TERM_STRING ||
+		    !*term->value.func.terms[ii]->value.string)
+			goto exit;
+	}
+
+	rule->values = g_new0 (gchar *, term->value.func.termcount);
+	for (ii = 1; ii < term->value.func.termcount; ii++)
+		rule->values[ii - 1] = g_strdup (term->value.func.terms[ii]->value.string);
+
+	if (rule->info_key == CAMEL_MESSAGE_INFO_MLIST && rule->how == CAMEL_SEARCH_MATCH_EXACT) {
+		rule->index_keys = g_new0 (gchar *, term->value.func.termcount);
+		for (ii = 0; rule->values[ii]; ii++)
+			rule->index_keys[ii] = filter_rule_index_key (rule->values[ii]);
+	}
+
+	rule->simple = TRUE;
+
+ exit:
+	g_object_unref (sexp);
+}
+
+static void
+filter_driver_index_rule (CamelFilterDriver *driver,
+                          struct _filter_rule *rule)
+{
+	gint ii;
+
+	if (!rule->index_keys)
+		return;
+
+	for (ii = 0; rule->index_keys[ii]; ii++) {
+		GPtrArray *bucket;
+
+		bucket = g_hash_table_lookup (driver->priv->rule_index, rule->index_keys[ii]);
+		if (!bucket) {
+			bucket = g_ptr_array_new ();
+			g_hash_table_insert (driver->priv->rule_index, g_strdup (rule->index_keys[ii]), bucket);
+		}
+
+		g_ptr_array_add (bucket, rule);
+	}
+}
+
+static void
+filter_driver_unindex_rule (CamelFilterDriver *driver,
+                            struct _filter_rule *rule)
+{
+	gint ii;
+
+	if (!rule->index_keys)
+		return;
+
+	for (ii = 0; rule->index_keys[ii]; ii++) {
+		GPtrArray *bucket;
+
+		bucket = g_hash_table_lookup (driver->priv->rule_index, rule->index_keys[ii]);
+		if (!bucket)
+			continue;
+
+		g_ptr_array_remove (bucket, rule);
+		if (!bucket->len)
+			g_hash_table_remove (driver->priv->rule_index, rule->index_keys[ii]);
+	}
+}
+
+/* Marks the indexed rules which could match the message's mailing list,
+ * so that the rest of them can be skipped outright. */
+static void
+filter_driver_mark_candidates (CamelFilterDriver *driver,
+                               CamelMessageInfo *info,
+                               guint serial)
+{
+	const gchar *mlist;
+	const guchar *ptr;
+	GPtrArray *bucket;
+	gunichar c;
+	gchar *key;
+	guint ii;
+
+	if (!g_hash_table_size (driver->priv->rule_index))
+		return;
+
+	mlist = camel_message_info_get_mlist (info);
+	if (!mlist || !*mlist)
+		return;
+
+	/* camel_search_header_match() skips leading white space */
+	ptr = (const guchar *) mlist;
+	while ((c = camel_utf8_getc (&ptr)) && g_unichar_isspace (c))
+		mlist = (const gchar *) ptr;
+
+	key = filter_rule_index_key (mlist);
+	bucket = g_hash_table_lookup (driver->priv->rule_index, key);
+	g_free (key);
+
+	for (ii = 0; bucket && ii < bucket->len; ii++) {
+		struct _filter_rule *rule = bucket->pdata[ii];
+
+		rule->serial = serial;
+	}
+}
+
+/* Decides a pre-analysed rule the same way camel_filter_search_match()
+ * would, but straight from the message info.  Returns FALSE when the info
+ * does not carry the header, or when the message is already loaded, in
+ * which case the search matches every instance of the header in the
+ * message itself. */
+static gboolean
+filter_rule_match_info (struct _filter_rule *rule,
+                        CamelMessageInfo *info,
+                        CamelMimeMessage *message,
+                        guint serial,
+                        gboolean *matched)
+{
+	camel_search_t type;
+	const gchar *value;
+	gint ii;
+
+	*matched = FALSE;
+
+	if (rule->index_keys && rule->serial != serial)
+		return TRUE;
+
+	value = camel_message_info_get_ptr (info, rule->info_key);
+
+	if (rule->info_key == CAMEL_MESSAGE_INFO_MLIST) {
+		if (!value)
+			return TRUE;
+		type = CAMEL_SEARCH_TYPE_MLIST;
+	} else if (message || !value) {
+		return FALSE;
+	} else if (rule->info_key == CAMEL_MESSAGE_INFO_SUBJECT) {
+		type = CAMEL_SEARCH_TYPE_ENCODED;
+	} else {
+		type = CAMEL_SEARCH_TYPE_ADDRESS_ENCODED;
+	}
+
+	for (ii = 0; rule->values[ii] && !*matched; ii++)
+		*matched = camel_search_header_match (value, rule->values[ii], rule->how, type, NULL);
+
+	return TRUE;
+}
+
+static void
+filter_rule_free (struct _filter_rule *rule)
+{
+	g_free (rule->match);
+	g_free (rule->action);
+	g_free (rule->name);
+	g_strfreev (rule->values);
+	g_strfreev (rule->index_keys);
+	g_free (rule);
+}
+
 static void
 filter_driver_dispose (GObject *object)
 {
@@ -228,12 +506,10 @@ filter_driver_finalize (GObject *object)
 
 	g_object_unref (priv->eval);
 
-	while ((node = g_queue_pop_head (&priv->rules)) != NULL) {
-		g_free (node->match);
-		g_free (node->action);
-		g_free (node->name);
-		g_free (node);
-	}
+	while ((node = g_queue_pop_head (&priv->rules)) != NULL)
+		filter_rule_free (node);
+
+	g_hash_table_destroy (priv->rule_index);
 
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (camel_filter_driver_parent_class)->finalize (object);
@@ -260,6 +536,11 @@ camel_filter_driver_init (CamelFilterDriver *filter_driver)
 
 	g_queue_init (&filter_driver->priv->rules);
 
+	filter_driver->priv->rule_index = g_hash_table_new_full (
+		g_str_hash, g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) g_ptr_array_unref);
+
 	filter_driver->priv->eval = camel_sexp_new ();
 
 	/* Load in builtin symbols */
@@ -400,11 +681,14 @@ camel_filter_driver_add_rule (CamelFilterDriver *d,
 {
 	struct _filter_rule *node;
 
-	node = g_malloc (sizeof (*node));
+	node = g_new0 (struct _filter_rule, 1);
 	node->match = g_strdup (match);
 	node->action = g_strdup (action);
 	node->name = g_strdup (name);
 
+	filter_rule_analyse (node);
+	filter_driver_index_rule (d, node);
+
 	g_queue_push_tail (&d->priv->rules, node);
 }
 
@@ -423,10 +707,8 @@ camel_filter_driver_remove_rule_by_name (CamelFilterDriver *d,
 
 		g_queue_delete_link (&d->priv->rules, link);
 
-		g_free (rule->match);
-		g_free (rule->action);
-		g_free (rule->name);
-		g_free (rule);
+		filter_driver_unindex_rule (d, rule);
+		filter_rule_free (rule);
 
 		return 0;
 	}
@@ -434,6 +716,35 @@ camel_filter_driver_remove_rule_by_name (CamelFilterDriver *d,
 	return -1;
 }
 
+/**
+ * camel_filter_driver_get_rule_stats:
+ * @driver: a #CamelFilterDriver
+ * @evaluated: (out) (allow-none): return location for the number of rules
+ *   evaluated through the full search expression, or %NULL
+ * @skipped: (out) (allow-none): return location for the number of rules
+ *   decided without it, or %NULL
+ *
+ * Returns counters describing how the rules were applied to the messages
+ * filtered so far.  Rules testing a single header against constants are
+ * analysed when added; those on the mailing list header are looked up in
+ * an index, and they and those on Subject, From, To or Cc are decided from
+ * the message info, both of which show up in @skipped.
+ *
+ * Since: 3.20
+ **/
+void
+camel_filter_driver_get_rule_stats (CamelFilterDriver *driver,
+                                    guint64 *evaluated,
+                                    guint64 *skipped)
+{
+	g_return_if_fail (CAMEL_IS_FILTER_DRIVER (driver));
+
+	if (evaluated)
+		*evaluated = driver->priv->rules_evaluated;
+	if (skipped)
+		*skipped = driver->priv->rules_skipped;
+}
+
 static void
 report_status (CamelFilterDriver *driver,
                enum camel_filter_status_t status,
@@ -1364,6 +1675,97 @@ decode_flags_from_xev (const gchar *xev,
 	return 0;
 }
 
+/* How many parsed messages camel_filter_driver_filter_mbox() may have
+ * waiting for the filters at any time. */
+#define FILTER_MBOX_PARSE_AHEAD 8
+
+/* one parsed message, or with message == NULL the end of the mailbox
+ * (error set if parsing failed) */
+struct _mbox_parse_item {
+	CamelMimeMessage *message;
+	CamelMessageInfo *info;
+	gint pc;
+	GError *error;
+};
+
+struct _mbox_parse_data {
+	CamelMimeParser *mp;
+	goffset size;
+	GCancellable *cancellable;
+	GAsyncQueue *items;	/* parsed messages, in mailbox order */
+	GAsyncQueue *slots;	/* tokens limiting how far parsing gets ahead */
+	volatile gint stop;
+};
+
+static void
+mbox_parse_item_free (struct _mbox_parse_item *item)
+{
+	g_clear_object (&item->message);
+	g_clear_object (&item->info);
+	g_clear_error (&item->error);
+
+	g_slice_free (struct _mbox_parse_item, item);
+}
+
+/* Splits the mailbox into messages on its own thread, so the next
+ * messages are already parsed while the filters run on the current one.
+ * Filtering itself stays on the calling thread and sees the messages
+ * in their original order. */
+static gpointer
+filter_mbox_parse_thread (gpointer user_data)
+{
+	struct _mbox_parse_data *data = user_data;
+	struct _mbox_parse_item *item;
+	goffset last = 0;
+
+	while (camel_mime_parser_step (data->mp, NULL, NULL) == CAMEL_MIME_PARSER_STATE_FROM) {
+		CamelMimePart *mime_part;
+		const gchar *xev;
+
+		g_async_queue_pop (data->slots);
+		if (g_atomic_int_get (&data->stop))
+			return NULL;
+
+		item = g_slice_new0 (struct _mbox_parse_item);
+
+		if (data->size > 0)
+			item->pc = (gint)(100.0 * ((double) camel_mime_parser_tell (data->mp) / (double) data->size));
+
+		item->message = camel_mime_message_new ();
+		mime_part = CAMEL_MIME_PART (item->message);
+
+		if (!camel_mime_part_construct_from_parser_sync (
+			mime_part, data->mp, data->cancellable, &item->error)) {
+			g_clear_object (&item->message);
+			if (item->error == NULL)
+				g_set_error (
+					&item->error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
+					_("Unable to process spool folder"));
+			g_async_queue_push (data->items, item);
+			return NULL;
+		}
+
+		item->info = camel_message_info_new_from_header (NULL, mime_part->headers);
+		/* Try and see if it has X-Evolution headers */
+		xev = camel_header_raw_find (&mime_part->headers, "X-Evolution", NULL);
+		if (xev)
+			decode_flags_from_xev (xev, (CamelMessageInfoBase *) item->info);
+
+		((CamelMessageInfoBase *) item->info)->size = camel_mime_parser_tell (data->mp) - last;
+
+		last = camel_mime_parser_tell (data->mp);
+
+		/* skip over the FROM_END state */
+		camel_mime_parser_step (data->mp, NULL, NULL);
+
+		g_async_queue_push (data->items, item);
+	}
+
+	g_async_queue_push (data->items, g_slice_new0 (struct _mbox_parse_item));
+
+	return NULL;
+}
+
 /**
  * camel_filter_driver_filter_mbox:
  * @driver: CamelFilterDriver
@@ -1387,13 +1789,15 @@ camel_filter_driver_filter_mbox (CamelFilterDriver *driver,
                                  GCancellable *cancellable,
                                  GError **error)
 {
+	struct _mbox_parse_data data = { NULL, };
+	struct _mbox_parse_item *item;
 	CamelMimeParser *mp = NULL;
+	GThread *parse_thread;
 	gchar *source_url = NULL;
 	gint fd = -1;
 	gint i = 0;
 	struct stat st;
 	gint status;
-	goffset last = 0;
 	gint ret = -1;
 
 	fd = g_open (mbox, O_RDONLY | O_BINARY, 0);
@@ -1419,67 +1823,76 @@ camel_filter_driver_filter_mbox (CamelFilterDriver *driver,
 
 	source_url = g_filename_to_uri (mbox, NULL, NULL);
 
-	while (camel_mime_parser_step (mp, NULL, NULL) == CAMEL_MIME_PARSER_STATE_FROM) {
-		CamelMessageInfo *info;
-		CamelMimeMessage *message;
-		CamelMimePart *mime_part;
-		gint pc = 0;
-		const gchar *xev;
-		GError *local_error = NULL;
+	data.mp = mp;
+	data.size = st.st_size;
+	data.cancellable = cancellable;
+	data.items = g_async_queue_new_full ((GDestroyNotify) mbox_parse_item_free);
+	data.slots = g_async_queue_new ();
+	data.stop = FALSE;
 
-		if (st.st_size > 0)
-			pc = (gint)(100.0 * ((double) camel_mime_parser_tell (mp) / (double) st.st_size));
+	for (i = 0; i < FILTER_MBOX_PARSE_AHEAD; i++)
+		g_async_queue_push (data.slots, GINT_TO_POINTER (1));
+	i = 0;
 
-		if (pc > 0)
-			camel_operation_progress (cancellable, pc);
+	parse_thread = g_thread_new (
+		"camel-filter-mbox", filter_mbox_parse_thread, &data);
 
-		report_status (
-			driver, CAMEL_FILTER_STATUS_START,
-			pc, _("Getting message %d (%d%%)"), i, pc);
+	while ((item = g_async_queue_pop (data.items))->message != NULL) {
+		GError *local_error = NULL;
 
-		message = camel_mime_message_new ();
-		mime_part = CAMEL_MIME_PART (message);
+		/* let the parser fetch the next message meanwhile */
+		g_async_queue_push (data.slots, GINT_TO_POINTER (1));
 
-		if (!camel_mime_part_construct_from_parser_sync (
-			mime_part, mp, cancellable, error)) {
-			report_status (
-				driver, CAMEL_FILTER_STATUS_END,
-				100, _("Failed on message %d"), i);
-			g_object_unref (message);
-			goto fail;
-		}
+		if (item->pc > 0)
+			camel_operation_progress (cancellable, item->pc);
 
-		info = camel_message_info_new_from_header (NULL, mime_part->headers);
-		/* Try and see if it has X-Evolution headers */
-		xev = camel_header_raw_find (&mime_part->headers, "X-Evolution", NULL);
-		if (xev)
-			decode_flags_from_xev (xev, (CamelMessageInfoBase *) info);
-
-		((CamelMessageInfoBase *) info)->size = camel_mime_parser_tell (mp) - last;
+		report_status (
+			driver, CAMEL_FILTER_STATUS_START,
+			item->pc, _("Getting message %d (%d%%)"), i, item->pc);
 
-		last = camel_mime_parser_tell (mp);
 		status = camel_filter_driver_filter_message (
-			driver, message, info, NULL, NULL, source_url,
+			driver, item->message, item->info, NULL, NULL, source_url,
 			original_source_url ? original_source_url :
 			source_url, cancellable, &local_error);
-		g_object_unref (message);
+		mbox_parse_item_free (item);
+		item = NULL;
+
 		if (local_error != NULL || status == -1) {
 			report_status (
 				driver, CAMEL_FILTER_STATUS_END,
 				100, _("Failed on message %d"), i);
-			g_object_unref (info);
 			g_propagate_error (error, local_error);
-			goto fail;
+			break;
 		}
 
 		i++;
+	}
 
-		/* skip over the FROM_END state */
-		camel_mime_parser_step (mp, NULL, NULL);
+	/* Stop the parser (it may be waiting for a slot) and wait for it. */
+	g_atomic_int_set (&data.stop, TRUE);
+	g_async_queue_push (data.slots, GINT_TO_POINTER (1));
+	g_thread_join (parse_thread);
 
-		g_object_unref (info);
+	if (item != NULL) {
+		/* end of the mailbox, or a parse error */
+		if (item->error != NULL) {
+			report_status (
+				driver, CAMEL_FILTER_STATUS_END,
+				100, _("Failed on message %d"), i);
+			g_propagate_error (error, item->error);
+			item->error = NULL;
+		} else {
+			ret = 0;
+		}
+		mbox_parse_item_free (item);
 	}
 
+	g_async_queue_unref (data.items);
+	g_async_queue_unref (data.slots);
+
+	if (ret == -1)
+		goto fail;
+
 	camel_operation_progress (cancellable, 100);
 
 	if (driver->priv->defaultfolder) {
@@ -1492,7 +1905,6 @@ camel_filter_driver_filter_mbox (CamelFilterDriver *driver,
 
 	report_status (driver, CAMEL_FILTER_STATUS_END, 100, _("Complete"));
 
-	ret = 0;
 fail:
 	g_free (source_url);
 	if (fd != -1)
@@ -1686,6 +2098,7 @@ camel_filter_driver_filter_message (CamelFilterDriver *driver,
 	gboolean filtered = FALSE;
 	CamelSExpResult *r;
 	GList *list, *link;
+	guint serial;
 	gint result;
 
 	g_return_val_if_fail (message != NULL || (source != NULL && uid != NULL), -1);
@@ -1740,9 +2153,13 @@ camel_filter_driver_filter_message (CamelFilterDriver *driver,
 	list = g_queue_peek_head_link (&driver->priv->rules);
 	result = CAMEL_SEARCH_NOMATCH;
 
+	serial = ++driver->priv->rule_serial;
+	filter_driver_mark_candidates (driver, info, serial);
+
 	for (link = list; link != NULL; link = g_list_next (link)) {
 		struct _filter_rule *rule = link->data;
 		struct _get_message data;
+		gboolean matched;
 
 		if (driver->priv->terminated)
 			break;
@@ -1758,9 +2175,15 @@ camel_filter_driver_filter_message (CamelFilterDriver *driver,
 		if (original_store_uid == NULL)
 			original_store_uid = store_uid;
 
-		result = camel_filter_search_match (
-			driver->priv->session, get_message_cb, &data, driver->priv->info,
-			original_store_uid, source, rule->match, cancellable, &driver->priv->error);
+		if (rule->simple && filter_rule_match_info (rule, driver->priv->info, driver->priv->message, serial, &matched)) {
+			driver->priv->rules_skipped++;
+			result = matched ? CAMEL_SEARCH_MATCHED : CAMEL_SEARCH_NOMATCH;
+		} else {
+			driver->priv->rules_evaluated++;
+			result = camel_filter_search_match (
+				driver->priv->session, get_message_cb, &data, driver->priv->info,
+				original_store_uid, source, rule->match, cancellable, &driver->priv->error);
+		}
 
 		switch (result) {
 		case CAMEL_SEARCH_ERROR:
@@ -100,6 +100,8 @@ void camel_filter_driver_set_default_folder   (CamelFilterDriver *d, CamelFolder
 void camel_filter_driver_add_rule             (CamelFilterDriver *d, const gchar *name, const gchar *match,
 					       const gchar *action);
 gint  camel_filter_driver_remove_rule_by_name  (CamelFilterDriver *d, const gchar *name);
+void camel_filter_driver_get_rule_stats       (CamelFilterDriver *driver, guint64 *evaluated,
+					       guint64 *skipped);
 
 /*void camel_filter_driver_set_global(CamelFilterDriver *, const gchar *name, const gchar *value);*/
 
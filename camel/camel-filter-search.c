@@ -143,8 +143,8 @@ camel_filter_search_get_message (FilterMessageSearch *fms,
 
 static gboolean
 check_header_in_message_info (CamelMessageInfo *info,
-                              gint argc,
-                              struct _CamelSExpResult **argv,
+                              const gchar *name,
+                              CamelSearchMatcher *matcher,
                               camel_search_match_t how,
                               gboolean *matched)
 {
@@ -158,20 +158,17 @@ check_header_in_message_info (CamelMessageInfo *info,
 		{ "Cc", CAMEL_MESSAGE_INFO_CC }
 	};
 	camel_search_t type = CAMEL_SEARCH_TYPE_ENCODED;
-	const gchar *name, *value;
+	const gchar *value;
 	gboolean found = FALSE;
 	gint ii;
 
-	g_return_val_if_fail (argc > 1, FALSE);
-	g_return_val_if_fail (argv != NULL, FALSE);
+	g_return_val_if_fail (name != NULL, FALSE);
+	g_return_val_if_fail (matcher != NULL, FALSE);
 	g_return_val_if_fail (matched != NULL, FALSE);
 
 	if (!info)
 		return FALSE;
 
-	name = argv[0]->value.string;
-	g_return_val_if_fail (name != NULL, FALSE);
-
 	/* test against any header */
 	if (!*name) {
 		gint jj;
@@ -186,10 +183,8 @@ check_header_in_message_info (CamelMessageInfo *info,
 			else
 				type = CAMEL_SEARCH_TYPE_ADDRESS_ENCODED;
 
-			for (ii = 1; ii < argc && !*matched; ii++) {
-				if (argv[ii]->type == CAMEL_SEXP_RES_STRING)
-					*matched = camel_search_header_match (value, argv[ii]->value.string, how, type, NULL);
-			}
+			if (!*matched)
+				*matched = camel_search_header_match_any (value, matcher, how, type, NULL);
 
 			if (*matched)
 				return TRUE;
@@ -213,10 +208,8 @@ check_header_in_message_info (CamelMessageInfo *info,
 	if (!found || !value)
 		return FALSE;
 
-	for (ii = 1; ii < argc && !*matched; ii++) {
-		if (argv[ii]->type == CAMEL_SEXP_RES_STRING)
-			*matched = camel_search_header_match (value, argv[ii]->value.string, how, type, NULL);
-	}
+	if (!*matched)
+		*matched = camel_search_header_match_any (value, matcher, how, type, NULL);
 
 	return TRUE;
 }
@@ -234,21 +227,21 @@ check_header (struct _CamelSExp *f,
 
 	if (argc > 1 && argv[0]->type == CAMEL_SEXP_RES_STRING) {
 		gchar *name = argv[0]->value.string;
+		CamelSearchMatcher *matcher;
 
 		/* shortcut: a match for "" against any header always matches */
 		for (i = 1; i < argc && !matched; i++)
 			matched = argv[i]->type == CAMEL_SEXP_RES_STRING && argv[i]->value.string[0] == 0;
 
+		/* all the values are looked for at once */
+		matcher = camel_search_matcher_ref_for_argv (argc - 1, argv + 1);
+
 		if (g_ascii_strcasecmp (name, "x-camel-mlist") == 0) {
 			const gchar *list = camel_message_info_get_mlist (fms->info);
 
-			if (list) {
-				for (i = 1; i < argc && !matched; i++) {
-					if (argv[i]->type == CAMEL_SEXP_RES_STRING)
-						matched = camel_search_header_match (list, argv[i]->value.string, how, CAMEL_SEARCH_TYPE_MLIST, NULL);
-				}
-			}
-		} else if (fms->message || !check_header_in_message_info (fms->info, argc, argv, how, &matched)) {
+			if (list && !matched)
+				matched = camel_search_header_match_any (list, matcher, how, CAMEL_SEARCH_TYPE_MLIST, NULL);
+		} else if (fms->message || !check_header_in_message_info (fms->info, name, matcher, how, &matched)) {
 			CamelMimeMessage *message;
 			CamelMimePart *mime_part;
 			CamelHeaderRaw *header;
@@ -272,14 +265,12 @@ check_header (struct _CamelSExp *f,
 
 			for (header = mime_part->headers; header && !matched; header = header->next) {
 				/* empty name means any header */
-				if (!name || !*name || !g_ascii_strcasecmp (header->name, name)) {
-					for (i = 1; i < argc && !matched; i++) {
-						if (argv[i]->type == CAMEL_SEXP_RES_STRING)
-							matched = camel_search_header_match (header->value, argv[i]->value.string, how, type, charset);
-					}
-				}
+				if (!name || !*name || !g_ascii_strcasecmp (header->name, name))
+					matched = camel_search_header_match_any (header->value, matcher, how, type, charset);
 			}
 		}
+
+		camel_search_matcher_unref (matcher);
 	}
 
 	r = camel_sexp_result_new (f, CAMEL_SEXP_RES_BOOL);
@@ -468,14 +459,18 @@ body_contains (struct _CamelSExp *f,
 {
 	CamelSExpResult *r = camel_sexp_result_new (f, CAMEL_SEXP_RES_BOOL);
 	CamelMimeMessage *message;
-	regex_t pattern;
+	CamelSearchMatcher *matcher;
+	gint i;
 
-	if (camel_search_build_match_regex (&pattern, CAMEL_SEARCH_MATCH_ICASE, argc, argv, fms->error) == 0) {
-		message = camel_filter_search_get_message (fms, f);
-		r->value.boolean = camel_search_message_body_contains ((CamelDataWrapper *) message, &pattern);
-		regfree (&pattern);
-	} else
-		r->value.boolean = FALSE;
+	for (i = 0; i < argc; i++) {
+		if (argv[i]->type != CAMEL_SEXP_RES_STRING)
+			g_warning ("Invalid type passed to body-contains match function");
+	}
+
+	matcher = camel_search_matcher_ref_for_argv (argc, argv);
+	message = camel_filter_search_get_message (fms, f);
+	r->value.boolean = camel_search_message_body_contains_any ((CamelDataWrapper *) message, matcher);
+	camel_search_matcher_unref (matcher);
 
 	return r;
 }
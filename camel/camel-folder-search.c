@@ -483,8 +483,8 @@ match_words_index (CamelFolderSearch *search,
 
 static gboolean
 match_words_1message (CamelDataWrapper *object,
-                      struct _camel_search_words *words,
-                      guint32 *mask,
+                      CamelSearchMatcher *matcher,
+                      guint8 *found,
                       GCancellable *cancellable)
 {
 	CamelDataWrapper *containee;
@@ -505,11 +505,11 @@ match_words_1message (CamelDataWrapper *object,
 		for (i = 0; i < parts && truth == FALSE; i++) {
 			CamelDataWrapper *part = (CamelDataWrapper *) camel_multipart_get_part (CAMEL_MULTIPART (containee), i);
 			if (part)
-				truth = match_words_1message (part, words, mask, cancellable);
+				truth = match_words_1message (part, matcher, found, cancellable);
 		}
 	} else if (CAMEL_IS_MIME_MESSAGE (containee)) {
 		/* for messages we only look at its contents */
-		truth = match_words_1message ((CamelDataWrapper *) containee, words, mask, cancellable);
+		truth = match_words_1message ((CamelDataWrapper *) containee, matcher, found, cancellable);
 	} else if (camel_content_type_is (CAMEL_DATA_WRAPPER (containee)->mime_type, "text", "*")) {
 		/* for all other text parts, we look inside, otherwise we dont care */
 		CamelStream *stream;
@@ -539,15 +539,11 @@ match_words_1message (CamelDataWrapper *object,
 		camel_data_wrapper_decode_to_stream_sync (
 			containee, stream, cancellable, NULL);
 		camel_stream_write (stream, "", 1, NULL, NULL);
-		for (i = 0; i < words->len; i++) {
-			/* FIXME: This is horridly slow, and should use a real search algorithm */
-			if (camel_ustrstrcase ((const gchar *) byte_array->data, words->words[i]->word) != NULL) {
-				*mask |= (1 << i);
-				/* shortcut a match */
-				if (*mask == (1 << (words->len)) - 1)
-					return TRUE;
-			}
-		}
+
+		/* all the words are looked for in a single pass */
+		truth = camel_search_matcher_contains_all (
+			matcher, (const gchar *) byte_array->data,
+			byte_array->len, found) == 0;
 
 		g_object_unref (stream);
 	}
@@ -558,11 +554,11 @@ match_words_1message (CamelDataWrapper *object,
 static gboolean
 match_words_message (CamelFolder *folder,
                      const gchar *uid,
-                     struct _camel_search_words *words,
+                     CamelSearchMatcher *matcher,
                      GCancellable *cancellable,
                      GError **error)
 {
-	guint32 mask;
+	guint8 *found;
 	CamelMimeMessage *msg;
 	gint truth = FALSE;
 
@@ -571,8 +567,9 @@ match_words_message (CamelFolder *folder,
 
 	msg = camel_folder_get_message_sync (folder, uid, cancellable, error);
 	if (msg) {
-		mask = 0;
-		truth = match_words_1message ((CamelDataWrapper *) msg, words, &mask, cancellable);
+		found = g_new0 (guint8, camel_search_matcher_get_n_patterns (matcher) + 1);
+		truth = match_words_1message ((CamelDataWrapper *) msg, matcher, found, cancellable);
+		g_free (found);
 		g_object_unref (msg);
 	}
 
@@ -587,10 +584,13 @@ match_words_messages (CamelFolderSearch *search,
 {
 	gint i;
 	GPtrArray *matches = g_ptr_array_new ();
+	CamelSearchMatcher *matcher;
 
 	if (g_cancellable_set_error_if_cancelled (cancellable, error))
 		return matches;
 
+	matcher = camel_search_matcher_new_for_words (words);
+
 	if (search->body_index) {
 		GPtrArray *indexed;
 		struct _camel_search_words *simple;
@@ -603,7 +603,7 @@ match_words_messages (CamelFolderSearch *search,
 			const gchar *uid = g_ptr_array_index (indexed, i);
 
 			if (match_words_message (
-					search->folder, uid, words,
+					search->folder, uid, matcher,
 					cancellable, error))
 				g_ptr_array_add (matches, (gchar *) uid);
 		}
@@ -616,12 +616,14 @@ match_words_messages (CamelFolderSearch *search,
 			gchar *uid = g_ptr_array_index (v, i);
 
 			if (match_words_message (
-				search->folder, uid, words,
+				search->folder, uid, matcher,
 				cancellable, error))
 				g_ptr_array_add (matches, (gchar *) uid);
 		}
 	}
 
+	camel_search_matcher_unref (matcher);
+
 	return matches;
 }
 
@@ -1128,13 +1130,19 @@ folder_search_body_contains (CamelSExp *sexp,
 								words->words[j]->word,
 								error);
 					} else {
+						CamelSearchMatcher *matcher;
+
+						matcher = camel_search_matcher_new_for_words (words);
+
 						/* TODO: cache current message incase of multiple body search terms */
 						truth = match_words_message (
 							search->folder,
 							camel_message_info_get_uid (search->current),
-							words,
+							matcher,
 							search->priv->cancellable,
 							error);
+
+						camel_search_matcher_unref (matcher);
 					}
 					camel_search_words_free (words);
 				}
@@ -39,6 +39,7 @@
 #include "camel-folder-summary.h"
 #include "camel-folder.h"
 #include "camel-iconv.h"
+#include "camel-memchunk.h"
 #include "camel-mime-filter-basic.h"
 #include "camel-mime-filter-charset.h"
 #include "camel-mime-filter-html.h"
@@ -100,8 +101,17 @@ struct _CamelFolderSummaryPrivate {
 	struct _CamelFolder *folder; /* parent folder, for events */
 	time_t cache_load_time;
 	guint timeout_handle;
+
+	/* content info trees are allocated from here rather than
+	 * individually, they are small, fixed-size and numerous */
+	GMutex content_info_lock;
+	CamelMemChunk *content_info_chunk;
+	guint content_info_count;
 };
 
+/* content infos allocated per memchunk block */
+#define CONTENT_INFO_CHUNK_ATOMS (256)
+
 /* this should probably be conditional on it existing */
 #define USE_BSEARCH
 
@@ -246,6 +256,10 @@ folder_summary_finalize (GObject *object)
 	g_rec_mutex_clear (&priv->summary_lock);
 	g_rec_mutex_clear (&priv->filter_lock);
 
+	if (priv->content_info_chunk != NULL)
+		camel_memchunk_destroy (priv->content_info_chunk);
+	g_mutex_clear (&priv->content_info_lock);
+
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (camel_folder_summary_parent_class)->finalize (object);
 }
@@ -1343,6 +1357,7 @@ camel_folder_summary_init (CamelFolderSummary *summary)
 
 	g_rec_mutex_init (&summary->priv->summary_lock);
 	g_rec_mutex_init (&summary->priv->filter_lock);
+	g_mutex_init (&summary->priv->content_info_lock);
 
 	summary->priv->cache_load_time = 0;
 	summary->priv->timeout_handle = 0;
@@ -3282,6 +3297,16 @@ camel_folder_summary_clear (CamelFolderSummary *summary,
 	remove_all_loaded (summary);
 	g_hash_table_remove_all (summary->priv->loaded_infos);
 
+	/* Give the content info blocks back to the system in one go,
+	 * unless somebody still holds a message info using them. */
+	g_mutex_lock (&summary->priv->content_info_lock);
+	if (summary->priv->content_info_chunk != NULL &&
+	    summary->priv->content_info_count == 0) {
+		camel_memchunk_destroy (summary->priv->content_info_chunk);
+		summary->priv->content_info_chunk = NULL;
+	}
+	g_mutex_unlock (&summary->priv->content_info_lock);
+
 	summary->priv->saved_count = 0;
 	summary->priv->unread_count = 0;
 	summary->priv->deleted_count = 0;
@@ -3599,7 +3624,9 @@ summary_format_string (CamelHeaderRaw *h,
  * @summary: a #CamelFolderSummary object
  *
  * Allocate a new #CamelMessageContentInfo, suitable for adding
- * to this summary.
+ * to this summary.  The memory comes from a per-summary pool and
+ * must be released with camel_folder_summary_content_info_free()
+ * on the same @summary.
  *
  * Returns: a newly allocated #CamelMessageContentInfo
  **/
@@ -3607,11 +3634,20 @@ CamelMessageContentInfo *
 camel_folder_summary_content_info_new (CamelFolderSummary *summary)
 {
 	CamelFolderSummaryClass *class;
+	CamelMessageContentInfo *ci;
 
 	class = CAMEL_FOLDER_SUMMARY_GET_CLASS (summary);
 	g_return_val_if_fail (class->content_info_size > 0, NULL);
 
-	return g_slice_alloc0 (class->content_info_size);
+	g_mutex_lock (&summary->priv->content_info_lock);
+	if (summary->priv->content_info_chunk == NULL)
+		summary->priv->content_info_chunk = camel_memchunk_new (
+			CONTENT_INFO_CHUNK_ATOMS, class->content_info_size);
+	ci = camel_memchunk_alloc0 (summary->priv->content_info_chunk);
+	summary->priv->content_info_count++;
+	g_mutex_unlock (&summary->priv->content_info_lock);
+
+	return ci;
 }
 
 static CamelMessageInfo *
@@ -3780,15 +3816,16 @@ static void
 content_info_free (CamelFolderSummary *summary,
                    CamelMessageContentInfo *ci)
 {
-	CamelFolderSummaryClass *class;
-
-	class = CAMEL_FOLDER_SUMMARY_GET_CLASS (summary);
-
-	g_object_unref (ci->type);
+	if (ci->type != NULL)
+		g_object_unref (ci->type);
 	g_free (ci->id);
 	g_free (ci->description);
 	g_free (ci->encoding);
-	g_slice_free1 (class->content_info_size, ci);
+
+	g_mutex_lock (&summary->priv->content_info_lock);
+	camel_memchunk_free (summary->priv->content_info_chunk, ci);
+	summary->priv->content_info_count--;
+	g_mutex_unlock (&summary->priv->content_info_lock);
 }
 
 static gchar *
@@ -724,9 +724,252 @@ add_present_rec (CamelFolderThread *thread,
 	}
 }
 
+/* State for applying a new uid set to an existing tree in place. */
+typedef struct _ThreadUpdate ThreadUpdate;
+
+struct _ThreadUpdate {
+	GHashTable *have;	/* uid -> uid, the new set of messages */
+	GHashTable *present;	/* uid -> node, messages already in the tree */
+	GHashTable *id_table;	/* message-id -> node */
+	GHashTable *ref_table;	/* message-ids referenced by any message */
+	GSList *removed;	/* nodes whose messages are gone */
+	guint32 max_order;
+	gboolean can_update;
+};
+
+static void
+thread_update_add_references (ThreadUpdate *update,
+                              const CamelMessageInfo *mi)
+{
+	const CamelSummaryReferences *references;
+	gint j;
+
+	references = camel_message_info_get_references ((CamelMessageInfo *) mi);
+	if (references == NULL)
+		return;
+
+	for (j = 0; j < references->size; j++) {
+		if (references->references[j].id.id != 0)
+			g_hash_table_add (
+				update->ref_table,
+				(gpointer) &references->references[j]);
+	}
+}
+
+static void
+thread_update_scan_rec (ThreadUpdate *update,
+                        CamelFolderThreadNode *node)
+{
+	while (node && update->can_update) {
+		const CamelSummaryMessageID *mid;
+		const gchar *uid;
+		gboolean removed = FALSE;
+
+		if (node->message == NULL) {
+			update->can_update = FALSE;
+			return;
+		}
+
+		uid = camel_message_info_get_uid ((CamelMessageInfo *) node->message);
+		g_hash_table_insert (update->present, (gpointer) uid, node);
+
+		if (!g_hash_table_contains (update->have, uid)) {
+			/* only leaves can be dropped without regrouping */
+			if (node->child) {
+				update->can_update = FALSE;
+				return;
+			}
+			update->removed = g_slist_prepend (update->removed, node);
+			removed = TRUE;
+		}
+
+		/* removed nodes are freed, so new replies must not find
+		 * them; a reply to one falls back to a full rethread */
+		mid = camel_message_info_get_message_id ((CamelMessageInfo *) node->message);
+		if (!removed && mid != NULL && mid->id.id &&
+		    !g_hash_table_contains (update->id_table, mid))
+			g_hash_table_insert (update->id_table, (gpointer) mid, node);
+
+		thread_update_add_references (update, node->message);
+
+		update->max_order = MAX (update->max_order, node->order);
+
+		if (node->child)
+			thread_update_scan_rec (update, node->child);
+		node = node->next;
+	}
+}
+
+static void
+thread_append_node (CamelFolderThreadNode **list,
+                    CamelFolderThreadNode *node)
+{
+	CamelFolderThreadNode *c;
+
+	/* siblings are sorted by summary order and new nodes always
+	 * come last, so appending keeps the list sorted */
+	c = (CamelFolderThreadNode *) list;
+	while (c->next)
+		c = c->next;
+	c->next = node;
+}
+
+/* Try to bring the tree up to date with @uids without rebuilding it.
+ * This only handles the common new mail/expunge cases: removing leaf
+ * messages, and adding messages which are either replies to a message
+ * already in the tree or (when not threading by subject) stand-alone.
+ * Anything which could change how existing messages are grouped makes
+ * this return %FALSE, with the tree untouched, so the caller falls
+ * back to threading everything from scratch. */
+static gboolean
+thread_update_incremental (CamelFolderThread *thread,
+                           GHashTable *have,
+                           GPtrArray *uids)
+{
+	ThreadUpdate update;
+	GPtrArray *added;
+	GSList *link;
+	gint i;
+
+	update.have = have;
+	update.present = g_hash_table_new (g_str_hash, g_str_equal);
+	update.id_table = g_hash_table_new ((GHashFunc) id_hash, (GCompareFunc) id_equal);
+	update.ref_table = g_hash_table_new ((GHashFunc) id_hash, (GCompareFunc) id_equal);
+	update.removed = NULL;
+	update.max_order = 0;
+	update.can_update = TRUE;
+
+	thread_update_scan_rec (&update, thread->tree);
+
+	added = g_ptr_array_new ();
+
+	for (i = 0; i < uids->len && update.can_update; i++) {
+		const CamelSummaryMessageID *mid;
+		const CamelSummaryReferences *references;
+		CamelFolderThreadNode *node, *parent = NULL;
+		CamelMessageInfo *info;
+
+		if (g_hash_table_contains (update.present, uids->pdata[i]))
+			continue;
+
+		info = camel_folder_get_message_info (thread->folder, uids->pdata[i]);
+		if (info == NULL)
+			continue;
+
+		mid = camel_message_info_get_message_id (info);
+		references = camel_message_info_get_references (info);
+
+		if (mid != NULL && mid->id.id &&
+		    (g_hash_table_contains (update.id_table, mid) ||
+		     g_hash_table_contains (update.ref_table, mid))) {
+			/* duplicate, or a parent arriving after its replies */
+			update.can_update = FALSE;
+		} else if (references != NULL && references->size > 0 &&
+			   references->references[0].id.id != 0) {
+			parent = g_hash_table_lookup (
+				update.id_table, &references->references[0]);
+			if (parent == NULL)
+				update.can_update = FALSE;
+		} else if (thread->subject) {
+			/* a new root might need grouping by subject */
+			update.can_update = FALSE;
+		}
+
+		if (!update.can_update) {
+			g_object_unref (info);
+			break;
+		}
+
+		node = camel_memchunk_alloc0 (thread->node_chunks);
+		node->message = info;
+		node->order = ++update.max_order;
+		node->parent = parent;
+
+		if (mid != NULL && mid->id.id)
+			g_hash_table_insert (update.id_table, (gpointer) mid, node);
+		thread_update_add_references (&update, info);
+
+		g_ptr_array_add (added, node);
+	}
+
+	g_hash_table_destroy (update.present);
+	g_hash_table_destroy (update.id_table);
+	g_hash_table_destroy (update.ref_table);
+
+	if (!update.can_update) {
+		for (i = 0; i < added->len; i++) {
+			CamelFolderThreadNode *node = added->pdata[i];
+
+			g_object_unref ((CamelMessageInfo *) node->message);
+			camel_memchunk_free (thread->node_chunks, node);
+		}
+		g_ptr_array_free (added, TRUE);
+		g_slist_free (update.removed);
+		return FALSE;
+	}
+
+	if (update.removed != NULL) {
+		GHashTable *gone;
+		guint j = 0;
+
+		/* drop the removed messages from the summary in one pass */
+		gone = g_hash_table_new (g_direct_hash, g_direct_equal);
+		for (link = update.removed; link != NULL; link = g_slist_next (link)) {
+			CamelFolderThreadNode *node = link->data;
+
+			g_hash_table_add (gone, (gpointer) node->message);
+		}
+
+		for (i = 0; i < thread->summary->len; i++) {
+			if (!g_hash_table_contains (gone, thread->summary->pdata[i]))
+				thread->summary->pdata[j++] = thread->summary->pdata[i];
+		}
+		g_ptr_array_set_size (thread->summary, j);
+
+		g_hash_table_destroy (gone);
+	}
+
+	for (link = update.removed; link != NULL; link = g_slist_next (link)) {
+		CamelFolderThreadNode *node = link->data;
+		CamelFolderThreadNode *c;
+
+		if (node->parent)
+			c = (CamelFolderThreadNode *) &node->parent->child;
+		else
+			c = (CamelFolderThreadNode *) &thread->tree;
+
+		while (c->next && c->next != node)
+			c = c->next;
+		if (c->next == node)
+			c->next = node->next;
+
+		g_object_unref ((CamelMessageInfo *) node->message);
+		camel_memchunk_free (thread->node_chunks, node);
+	}
+	g_slist_free (update.removed);
+
+	for (i = 0; i < added->len; i++) {
+		CamelFolderThreadNode *node = added->pdata[i];
+
+		if (node->parent)
+			thread_append_node (&node->parent->child, node);
+		else
+			thread_append_node (&thread->tree, node);
+
+		g_ptr_array_add (thread->summary, (gpointer) node->message);
+	}
+	g_ptr_array_free (added, TRUE);
+
+	return TRUE;
+}
+
 /**
  * camel_folder_thread_messages_apply:
  * @uids:(element-type utf8) (transfer none):
+ *
+ * Updates @thread to contain exactly the messages in @uids.  Removing
+ * messages without replies and adding replies to messages already in
+ * the tree is done in place; other changes rethread all messages.
  **/
 void
 camel_folder_thread_messages_apply (CamelFolderThread *thread,
@@ -737,11 +980,18 @@ camel_folder_thread_messages_apply (CamelFolderThread *thread,
 	GHashTable *table;
 	CamelMessageInfo *info;
 
-	all = g_ptr_array_new ();
 	table = g_hash_table_new (g_str_hash, g_str_equal);
 	for (i = 0; i < uids->len; i++)
 		g_hash_table_insert (table, uids->pdata[i], uids->pdata[i]);
 
+	/* Most changes are a few new or expunged messages; handle
+	 * those in place instead of rethreading the whole folder. */
+	if (thread_update_incremental (thread, table, uids)) {
+		g_hash_table_destroy (table);
+		return;
+	}
+
+	all = g_ptr_array_new ();
 	add_present_rec (thread, table, all, thread->tree);
 
 	/* add any new ones, in supplied order */
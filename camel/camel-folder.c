@@ -1772,6 +1772,67 @@ camel_folder_set_message_flags (CamelFolder *folder,
 	return class->set_message_flags (folder, uid, flags, set);
 }
 
+/**
+ * camel_folder_set_message_flags_many:
+ * @folder: a #CamelFolder
+ * @uids: (element-type utf8): UIDs of messages in @folder
+ * @flags: a set of #CamelMessageFlag values to set
+ * @set: the mask of values in @flags to use.
+ *
+ * Sets those flags specified by @flags to the values specified by @set
+ * on every message in @uids, the same as camel_folder_set_message_flags()
+ * would for each of them, but as a single operation: the summary lock is
+ * taken once, count property notifications are emitted once and
+ * listeners of #CamelFolder::changed receive one combined
+ * #CamelFolderChangeInfo for the whole batch.
+ *
+ * Returns: how many messages had their flags changed
+ *
+ * Since: 3.20
+ **/
+guint
+camel_folder_set_message_flags_many (CamelFolder *folder,
+                                     GPtrArray *uids,
+                                     CamelMessageFlags flags,
+                                     CamelMessageFlags set)
+{
+	CamelFolderClass *class;
+	guint ii, n_changed = 0;
+
+	g_return_val_if_fail (CAMEL_IS_FOLDER (folder), 0);
+	g_return_val_if_fail (uids != NULL, 0);
+
+	class = CAMEL_FOLDER_GET_CLASS (folder);
+	g_return_val_if_fail (class->set_message_flags != NULL, 0);
+
+	if ((flags & (CAMEL_MESSAGE_JUNK | CAMEL_MESSAGE_JUNK_LEARN)) == CAMEL_MESSAGE_JUNK) {
+		flags |= CAMEL_MESSAGE_JUNK_LEARN;
+		set &= ~CAMEL_MESSAGE_JUNK_LEARN;
+	}
+
+	/* Freezing collects the per-message change infos into one
+	 * and defers the summary save to the final thaw, freezing
+	 * the summary's notifications merges the count updates. */
+	camel_folder_freeze (folder);
+	if (folder->summary != NULL) {
+		g_object_freeze_notify (G_OBJECT (folder->summary));
+		camel_folder_summary_lock (folder->summary);
+	}
+
+	for (ii = 0; ii < uids->len; ii++) {
+		if (class->set_message_flags (folder, uids->pdata[ii], flags, set))
+			n_changed++;
+	}
+
+	if (folder->summary != NULL) {
+		camel_folder_summary_unlock (folder->summary);
+		g_object_thaw_notify (G_OBJECT (folder->summary));
+	}
+	camel_folder_thaw (folder);
+
+	return n_changed;
+}
+
 /**
  * camel_folder_get_message_user_flag:
  * @folder: a #CamelFolder
@@ -335,6 +335,11 @@ void		camel_folder_set_message_user_tag
 						 const gchar *name,
 						 const gchar *value);
 #endif /* CAMEL_DISABLE_DEPRECATED */
+guint		camel_folder_set_message_flags_many
+						(CamelFolder *folder,
+						 GPtrArray *uids,
+						 CamelMessageFlags flags,
+						 CamelMessageFlags set);
 gboolean	camel_folder_has_summary_capability
 						(CamelFolder *folder);
 gint		camel_folder_get_message_count	(CamelFolder *folder);
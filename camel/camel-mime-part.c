@@ -103,61 +103,30 @@ async_context_free (AsyncContext *async_context)
 	g_slice_free (AsyncContext, async_context);
 }
 
-static gssize
-write_header (gpointer stream,
-              const gchar *name,
-              const gchar *value,
-              GCancellable *cancellable,
-              GError **error)
-{
-	GString *buffer;
-	gssize n_written = 0;
+typedef void (*CamelMimePartFormatHeaderFunc) (GString *buffer,
+                                               const gchar *name,
+                                               const gchar *value);
 
-	buffer = g_string_new (name);
+static void
+format_header (GString *buffer,
+               const gchar *name,
+               const gchar *value)
+{
+	g_string_append (buffer, name);
 	g_string_append_c (buffer, ':');
 	if (!isspace (value[0]))
 		g_string_append_c (buffer, ' ');
 	g_string_append (buffer, value);
 	g_string_append_c (buffer, '\n');
-
-	/* XXX For now we handle both types of streams. */
-
-	if (CAMEL_IS_STREAM (stream)) {
-		n_written = camel_stream_write (
-			CAMEL_STREAM (stream),
-			buffer->str, buffer->len,
-			cancellable, error);
-	} else if (G_IS_OUTPUT_STREAM (stream)) {
-		gboolean success;
-		gsize bytes_written = 0;
-
-		success = g_output_stream_write_all (
-			G_OUTPUT_STREAM (stream),
-			buffer->str, buffer->len,
-			&bytes_written, cancellable, error);
-		if (success)
-			n_written = (gssize) bytes_written;
-		else
-			n_written = -1;
-	} else {
-		g_warn_if_reached ();
-	}
-
-	g_string_free (buffer, TRUE);
-
-	return n_written;
 }
 
-static gssize
-write_references (gpointer stream,
-                  const gchar *name,
-                  const gchar *value,
-                  GCancellable *cancellable,
-                  GError **error)
+static void
+format_references (GString *buffer,
+                   const gchar *name,
+                   const gchar *value)
 {
-	GString *buffer;
 	const gchar *ids, *ide;
-	gssize n_written = 0;
+	gsize start = buffer->len;
 	gsize len;
 
 	/* this is only approximate, based on the next >, this way it retains
@@ -165,12 +134,12 @@ write_references (gpointer stream,
 	 * etc.  It also doesn't handle the case where an individual messageid
 	 * is too long, however thats a bad mail to start with ... */
 
-	buffer = g_string_new (name);
+	g_string_append (buffer, name);
 	g_string_append_c (buffer, ':');
 	if (!isspace (value[0]))
 		g_string_append_c (buffer, ' ');
 
-	len = buffer->len;
+	len = buffer->len - start;
 
 	while (*value) {
 		ids = value;
@@ -190,33 +159,44 @@ write_references (gpointer stream,
 	}
 
 	g_string_append_c (buffer, '\n');
+}
 
-	/* XXX For now we handle both types of streams. */
-
-	if (CAMEL_IS_STREAM (stream)) {
-		n_written = camel_stream_write (
-			CAMEL_STREAM (stream),
-			buffer->str, buffer->len,
-			cancellable, error);
-	} else if (G_IS_OUTPUT_STREAM (stream)) {
-		gboolean success;
-		gsize bytes_written = 0;
-
-		success = g_output_stream_write_all (
-			G_OUTPUT_STREAM (stream),
-			buffer->str, buffer->len,
-			&bytes_written, cancellable, error);
-		if (success)
-			n_written = (gssize) bytes_written;
-		else
-			n_written = -1;
-	} else {
-		g_warn_if_reached ();
-	}
+/* Formats the whole header block of @mime_part, including the blank
+ * line separating it from the content, into @buffer.  The block is
+ * then handed to the output stream in a single write instead of one
+ * write per header line, which matters once the stream is a filter
+ * chain sitting on top of a socket or a file. */
+static void
+mime_part_format_headers (CamelMimePart *mime_part,
+                          GString *buffer)
+{
+	CamelHeaderRaw *h;
 
-	g_string_free (buffer, TRUE);
+	/* FIXME: something needs to be done about this ... */
+	/* TODO: content-languages header? */
+
+	/* fold/write the headers.   But dont fold headers that are already formatted
+	 * (e.g. ones with parameter-lists, that we know about, and have created) */
+	for (h = mime_part->headers; h != NULL; h = h->next) {
+		CamelMimePartFormatHeaderFunc formatfn;
+		gchar *val;
+
+		if (h->value == NULL) {
+			g_warning ("h->value is NULL here for %s", h->name);
+			continue;
+		}
 
-	return n_written;
+		formatfn = g_hash_table_lookup (header_formatted_table, h->name);
+		if (formatfn == NULL) {
+			val = camel_header_fold (h->value, strlen (h->name));
+			format_header (buffer, h->name, val);
+			g_free (val);
+		} else {
+			formatfn (buffer, h->name, h->value);
+		}
+	}
+
+	g_string_append_c (buffer, '\n');
 }
 
 /* loads in a hash table the set of header names we */
@@ -263,25 +243,25 @@ init_header_name_table (void)
 		camel_strcase_hash, camel_strcase_equal);
 	g_hash_table_insert (
 		header_formatted_table,
-		(gpointer) "Content-Type", write_header);
+		(gpointer) "Content-Type", format_header);
 	g_hash_table_insert (
 		header_formatted_table,
-		(gpointer) "Content-Disposition", write_header);
+		(gpointer) "Content-Disposition", format_header);
 	g_hash_table_insert (
 		header_formatted_table,
-		(gpointer) "From", write_header);
+		(gpointer) "From", format_header);
 	g_hash_table_insert (
 		header_formatted_table,
-		(gpointer) "Reply-To", write_header);
+		(gpointer) "Reply-To", format_header);
 	g_hash_table_insert (
 		header_formatted_table,
-		(gpointer) "Message-ID", write_header);
+		(gpointer) "Message-ID", format_header);
 	g_hash_table_insert (
 		header_formatted_table,
-		(gpointer) "In-Reply-To", write_header);
+		(gpointer) "In-Reply-To", format_header);
 	g_hash_table_insert (
 		header_formatted_table,
-		(gpointer) "References", write_references);
+		(gpointer) "References", format_references);
 }
 
 static void
@@ -567,51 +547,18 @@ mime_part_write_to_stream_sync (CamelDataWrapper *dw,
 	CamelMedium *medium = CAMEL_MEDIUM (dw);
 	CamelStream *ostream = stream;
 	CamelDataWrapper *content;
+	GString *headers;
 	gssize total = 0;
 	gssize count;
 	gint errnosav;
 
 	d (printf ("mime_part::write_to_stream\n"));
 
-	/* FIXME: something needs to be done about this ... */
-	/* TODO: content-languages header? */
-
-	if (mp->headers) {
-		CamelHeaderRaw *h = mp->headers;
-		gchar *val;
-		gssize (*writefn) (
-			gpointer stream,
-			const gchar *name,
-			const gchar *value,
-			GCancellable *cancellable,
-			GError **error);
-
-		/* fold/write the headers.   But dont fold headers that are already formatted
-		 * (e.g. ones with parameter-lists, that we know about, and have created) */
-		while (h) {
-			val = h->value;
-			if (val == NULL) {
-				g_warning ("h->value is NULL here for %s", h->name);
-				count = 0;
-			} else if ((writefn = g_hash_table_lookup (header_formatted_table, h->name)) == NULL) {
-				val = camel_header_fold (val, strlen (h->name));
-				count = write_header (
-					stream, h->name, val,
-					cancellable, error);
-				g_free (val);
-			} else {
-				count = writefn (
-					stream, h->name, h->value,
-					cancellable, error);
-			}
-			if (count == -1)
-				return -1;
-			total += count;
-			h = h->next;
-		}
-	}
-
-	count = camel_stream_write (stream, "\n", 1, cancellable, error);
+	headers = g_string_sized_new (1024);
+	mime_part_format_headers (mp, headers);
+	count = camel_stream_write (
+		stream, headers->str, headers->len, cancellable, error);
+	g_string_free (headers, TRUE);
 	if (count == -1)
 		return -1;
 	total += count;
@@ -759,6 +706,7 @@ mime_part_write_to_output_stream_sync (CamelDataWrapper *dw,
 	CamelMimePart *mp = CAMEL_MIME_PART (dw);
 	CamelMedium *medium = CAMEL_MEDIUM (dw);
 	CamelDataWrapper *content;
+	GString *headers;
 	gsize bytes_written;
 	gssize total = 0;
 	gssize result;
@@ -766,48 +714,12 @@ mime_part_write_to_output_stream_sync (CamelDataWrapper *dw,
 
 	d (printf ("mime_part::write_to_stream\n"));
 
-	/* FIXME: something needs to be done about this ... */
-	/* TODO: content-languages header? */
-
-	if (mp->headers) {
-		CamelHeaderRaw *h = mp->headers;
-		gchar *val;
-		gssize (*writefn) (
-			gpointer stream,
-			const gchar *name,
-			const gchar *value,
-			GCancellable *cancellable,
-			GError **error);
-
-		/* fold/write the headers.   But dont fold headers that are already formatted
-		 * (e.g. ones with parameter-lists, that we know about, and have created) */
-		while (h) {
-			val = h->value;
-			if (val == NULL) {
-				g_warning ("h->value is NULL here for %s", h->name);
-				bytes_written = 0;
-				result = 0;
-			} else if ((writefn = g_hash_table_lookup (header_formatted_table, h->name)) == NULL) {
-				val = camel_header_fold (val, strlen (h->name));
-				result = write_header (
-					output_stream, h->name, val,
-					cancellable, error);
-				g_free (val);
-			} else {
-				result = writefn (
-					output_stream, h->name, h->value,
-					cancellable, error);
-			}
-			if (result == -1)
-				return -1;
-			total += result;
-			h = h->next;
-		}
-	}
-
+	headers = g_string_sized_new (1024);
+	mime_part_format_headers (mp, headers);
 	success = g_output_stream_write_all (
-		output_stream, "\n", 1,
+		output_stream, headers->str, headers->len,
 		&bytes_written, cancellable, error);
+	g_string_free (headers, TRUE);
 	if (!success)
 		return -1;
 	total += (gssize) bytes_written;
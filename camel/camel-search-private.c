@@ -36,6 +36,7 @@
 #include "camel-multipart.h"
 #include "camel-search-private.h"
 #include "camel-stream-mem.h"
+#include "camel-trie.h"
 
 #define d(x)
 
@@ -500,11 +501,513 @@ camel_search_header_match (const gchar *value,
 	return truth;
 }
 
-/* Performs a 'slow' content-based match. */
-/* There is also an identical copy of this in camel-filter-search.c. */
+/* A set of patterns searched for together with a single CamelTrie,
+ * so that a haystack is decoded and case-folded once no matter how
+ * many patterns there are.  The trie and the split words are only
+ * built by the matches which need them; the lock guards that, so a
+ * matcher from the cache can be used by several threads. */
+struct _CamelSearchMatcher {
+	volatile gint ref_count;
+	gint n_patterns;
+	gchar **patterns;
+	gint *canonical;	/* first pattern equal to each, ignoring case */
+	gboolean has_empty;	/* an empty pattern matches anything */
+	GMutex lock;
+	CamelTrie *trie;	/* built on first contains match */
+	GPtrArray **words;	/* case-folded words of each pattern, built on first word match */
+};
+
+/* matchers for recently used argument lists, see camel_search_matcher_ref_for_argv() */
+#define SEARCH_MATCHER_CACHE_SIZE (64)
+
+static GMutex matcher_cache_lock;
+static GHashTable *matcher_cache;
+
+static gchar *
+search_fold_word (const gchar *word)
+{
+	const guchar *ptr = (const guchar *) word;
+	GString *folded;
+	gunichar c;
+
+	folded = g_string_sized_new (strlen (word));
+
+	while ((c = camel_utf8_getc (&ptr)) != 0)
+		g_string_append_unichar (folded, g_unichar_tolower (c));
+
+	return g_string_free (folded, FALSE);
+}
+
+/* The words camel_uwordcase() would split the text into, case-folded. */
+static struct _camel_search_words *
+search_split_words (const gchar *text)
+{
+	struct _camel_search_words *words;
+	gchar *copy;
+	gint ii;
+
+	copy = depunct_string (text);
+	words = camel_search_words_split ((const guchar *) copy);
+	g_free (copy);
+
+	for (ii = 0; ii < words->len; ii++) {
+		gchar *folded = search_fold_word (words->words[ii]->word);
+
+		g_free (words->words[ii]->word);
+		words->words[ii]->word = folded;
+	}
+
+	return words;
+}
+
+CamelSearchMatcher *
+camel_search_matcher_new (const gchar * const *patterns,
+                          gint n_patterns)
+{
+	CamelSearchMatcher *matcher;
+	gint ii, jj;
+
+	g_return_val_if_fail (patterns != NULL || n_patterns == 0, NULL);
+
+	matcher = g_slice_new0 (CamelSearchMatcher);
+	matcher->ref_count = 1;
+	matcher->n_patterns = n_patterns;
+	matcher->patterns = g_new0 (gchar *, n_patterns + 1);
+	matcher->canonical = g_new0 (gint, n_patterns);
+	g_mutex_init (&matcher->lock);
+
+	for (ii = 0; ii < n_patterns; ii++) {
+		matcher->patterns[ii] = g_strdup (patterns[ii]);
+
+		if (!*patterns[ii]) {
+			matcher->canonical[ii] = ii;
+			matcher->has_empty = TRUE;
+			continue;
+		}
+
+		for (jj = 0; jj < ii; jj++) {
+			if (camel_ustrcasecmp (patterns[jj], patterns[ii]) == 0)
+				break;
+		}
+
+		matcher->canonical[ii] = jj;
+	}
+
+	return matcher;
+}
+
+/* Call with the matcher's lock held */
+static void
+search_matcher_build_trie (CamelSearchMatcher *matcher)
+{
+	gint ii;
+
+	matcher->trie = camel_trie_new (TRUE);
+
+	/* The trie keeps a single id per pattern */
+	for (ii = 0; ii < matcher->n_patterns; ii++) {
+		if (*matcher->patterns[ii] && matcher->canonical[ii] == ii)
+			camel_trie_add (matcher->trie, matcher->patterns[ii], ii);
+	}
+}
+
+static CamelTrie *
+search_matcher_get_trie (CamelSearchMatcher *matcher)
+{
+	CamelTrie *trie;
+
+	g_mutex_lock (&matcher->lock);
+	if (!matcher->trie)
+		search_matcher_build_trie (matcher);
+	trie = matcher->trie;
+	g_mutex_unlock (&matcher->lock);
+
+	return trie;
+}
+
+CamelSearchMatcher *
+camel_search_matcher_new_for_words (struct _camel_search_words *words)
+{
+	CamelSearchMatcher *matcher;
+	const gchar **patterns;
+	gint ii;
+
+	g_return_val_if_fail (words != NULL, NULL);
+
+	patterns = g_new (const gchar *, words->len + 1);
+	for (ii = 0; ii < words->len; ii++)
+		patterns[ii] = words->words[ii]->word;
+	patterns[ii] = NULL;
+
+	matcher = camel_search_matcher_new (patterns, words->len);
+
+	g_free (patterns);
+
+	return matcher;
+}
+
+/* Returns a matcher for the string arguments of a search function.  Filters
+ * evaluate the same rules for every message, so matchers are shared by the
+ * calls with the same argument list, through a small cache. */
+CamelSearchMatcher *
+camel_search_matcher_ref_for_argv (gint argc,
+                                   CamelSExpResult **argv)
+{
+	CamelSearchMatcher *matcher;
+	const gchar **patterns;
+	GString *key;
+	gint ii, n_patterns = 0;
+
+	patterns = g_new (const gchar *, argc + 1);
+	key = g_string_new ("");
+
+	for (ii = 0; ii < argc; ii++) {
+		if (argv[ii]->type == CAMEL_SEXP_RES_STRING) {
+			patterns[n_patterns++] = argv[ii]->value.string;
+
+			/* length prefixed, so no two lists share a key */
+			g_string_append_printf (key, "%" G_GSIZE_FORMAT ":", strlen (argv[ii]->value.string));
+			g_string_append (key, argv[ii]->value.string);
+		}
+	}
+	patterns[n_patterns] = NULL;
+
+	g_mutex_lock (&matcher_cache_lock);
+
+	if (!matcher_cache)
+		matcher_cache = g_hash_table_new_full (
+			g_str_hash, g_str_equal, g_free,
+			(GDestroyNotify) camel_search_matcher_unref);
+
+	matcher = g_hash_table_lookup (matcher_cache, key->str);
+	if (matcher) {
+		camel_search_matcher_ref (matcher);
+	} else {
+		matcher = camel_search_matcher_new (patterns, n_patterns);
+
+		if (g_hash_table_size (matcher_cache) >= SEARCH_MATCHER_CACHE_SIZE)
+			g_hash_table_remove_all (matcher_cache);
+
+		g_hash_table_insert (
+			matcher_cache, g_strdup (key->str),
+			camel_search_matcher_ref (matcher));
+	}
+
+	g_mutex_unlock (&matcher_cache_lock);
+
+	g_string_free (key, TRUE);
+	g_free (patterns);
+
+	return matcher;
+}
+
+CamelSearchMatcher *
+camel_search_matcher_ref (CamelSearchMatcher *matcher)
+{
+	g_return_val_if_fail (matcher != NULL, NULL);
+
+	g_atomic_int_inc (&matcher->ref_count);
+
+	return matcher;
+}
+
+void
+camel_search_matcher_unref (CamelSearchMatcher *matcher)
+{
+	gint ii;
+
+	if (!matcher)
+		return;
+
+	if (!g_atomic_int_dec_and_test (&matcher->ref_count))
+		return;
+
+	if (matcher->words) {
+		for (ii = 0; ii < matcher->n_patterns; ii++) {
+			if (matcher->words[ii])
+				g_ptr_array_unref (matcher->words[ii]);
+		}
+		g_free (matcher->words);
+	}
+
+	if (matcher->trie)
+		camel_trie_free (matcher->trie);
+	g_mutex_clear (&matcher->lock);
+	g_strfreev (matcher->patterns);
+	g_free (matcher->canonical);
+	g_slice_free (CamelSearchMatcher, matcher);
+}
+
+gint
+camel_search_matcher_get_n_patterns (CamelSearchMatcher *matcher)
+{
+	g_return_val_if_fail (matcher != NULL, 0);
+
+	return matcher->n_patterns;
+}
+
+static gboolean
+search_matcher_any_cb (gint pattern_id,
+                       const gchar *match_end,
+                       gpointer user_data)
+{
+	gboolean *found = user_data;
+
+	*found = TRUE;
+
+	return FALSE;
+}
+
+/* Whether any of the patterns occurs in the text, ignoring case. */
 gboolean
-camel_search_message_body_contains (CamelDataWrapper *object,
-                                    regex_t *pattern)
+camel_search_matcher_contains_any (CamelSearchMatcher *matcher,
+                                   const gchar *text,
+                                   gssize len)
+{
+	gboolean found = FALSE;
+
+	g_return_val_if_fail (matcher != NULL, FALSE);
+	g_return_val_if_fail (text != NULL, FALSE);
+
+	if (matcher->has_empty)
+		return TRUE;
+
+	if (len < 0)
+		len = strlen (text);
+
+	camel_trie_search_all (search_matcher_get_trie (matcher), text, len, search_matcher_any_cb, &found);
+
+	return found;
+}
+
+struct _SearchMatcherAllData {
+	CamelSearchMatcher *matcher;
+	guint8 *found;
+	gint missing;
+};
+
+static gboolean
+search_matcher_all_cb (gint pattern_id,
+                       const gchar *match_end,
+                       gpointer user_data)
+{
+	struct _SearchMatcherAllData *data = user_data;
+	gint ii;
+
+	for (ii = pattern_id; ii < data->matcher->n_patterns; ii++) {
+		if (data->matcher->canonical[ii] == pattern_id && !data->found[ii]) {
+			data->found[ii] = TRUE;
+			data->missing--;
+		}
+	}
+
+	return data->missing > 0;
+}
+
+/* Marks in found[] (one element per pattern, kept by the caller across
+ * calls) the patterns which occur in the text, ignoring case.  Stops as
+ * soon as all are found.  Returns how many patterns are still missing. */
+gint
+camel_search_matcher_contains_all (CamelSearchMatcher *matcher,
+                                   const gchar *text,
+                                   gssize len,
+                                   guint8 *found)
+{
+	struct _SearchMatcherAllData data;
+	gint ii;
+
+	g_return_val_if_fail (matcher != NULL, -1);
+	g_return_val_if_fail (text != NULL, -1);
+	g_return_val_if_fail (found != NULL, -1);
+
+	data.matcher = matcher;
+	data.found = found;
+	data.missing = 0;
+
+	for (ii = 0; ii < matcher->n_patterns; ii++) {
+		if (!*matcher->patterns[ii])
+			found[ii] = TRUE;
+		else if (!found[ii])
+			data.missing++;
+	}
+
+	if (data.missing == 0)
+		return 0;
+
+	if (len < 0)
+		len = strlen (text);
+
+	camel_trie_search_all (search_matcher_get_trie (matcher), text, len, search_matcher_all_cb, &data);
+
+	return data.missing;
+}
+
+/* The case-folded words of the pattern at index, split on first use */
+static GPtrArray *
+search_matcher_get_words (CamelSearchMatcher *matcher,
+                          gint index)
+{
+	GPtrArray *words;
+
+	g_mutex_lock (&matcher->lock);
+
+	if (!matcher->words)
+		matcher->words = g_new0 (GPtrArray *, matcher->n_patterns);
+
+	words = matcher->words[index];
+	if (!words) {
+		struct _camel_search_words *nwords;
+		gint ii;
+
+		nwords = search_split_words (matcher->patterns[index]);
+		words = g_ptr_array_new_with_free_func (g_free);
+		for (ii = 0; ii < nwords->len; ii++)
+			g_ptr_array_add (words, g_strdup (nwords->words[ii]->word));
+		camel_search_words_free (nwords);
+
+		matcher->words[index] = words;
+	}
+
+	g_mutex_unlock (&matcher->lock);
+
+	return words;
+}
+
+/* camel_uwordcase() for all the patterns at once */
+static gboolean
+search_matcher_has_words (CamelSearchMatcher *matcher,
+                          const gchar *value)
+{
+	struct _camel_search_words *hwords = NULL;
+	GHashTable *hwords_set = NULL;
+	gsize vlen = strlen (value);
+	gboolean truth = FALSE;
+	gint ii, jj;
+
+	for (ii = 0; ii < matcher->n_patterns && !truth; ii++) {
+		const gchar *pattern = matcher->patterns[ii];
+		GPtrArray *words;
+
+		if (vlen < strlen (pattern))
+			continue;
+
+		if (!*pattern) {
+			truth = TRUE;
+			break;
+		}
+
+		if (!*value)
+			continue;
+
+		if (!hwords) {
+			hwords = search_split_words (value);
+			hwords_set = g_hash_table_new (g_str_hash, g_str_equal);
+			for (jj = 0; jj < hwords->len; jj++)
+				g_hash_table_add (hwords_set, hwords->words[jj]->word);
+		}
+
+		words = search_matcher_get_words (matcher, ii);
+
+		truth = TRUE;
+		for (jj = 0; jj < words->len && truth; jj++)
+			truth = g_hash_table_contains (hwords_set, words->pdata[jj]);
+	}
+
+	if (hwords) {
+		g_hash_table_destroy (hwords_set);
+		camel_search_words_free (hwords);
+	}
+
+	return truth;
+}
+
+static gboolean
+search_matcher_match_value (CamelSearchMatcher *matcher,
+                            const gchar *value,
+                            camel_search_match_t how)
+{
+	if (how == CAMEL_SEARCH_MATCH_WORD)
+		return search_matcher_has_words (matcher, value);
+
+	return camel_search_matcher_contains_any (matcher, value, -1);
+}
+
+/* Like camel_search_header_match() for each of the patterns of the matcher,
+ * returning whether any of them matched.  The header value is decoded only
+ * once, and contains and word matches test all the patterns in one go. */
+gboolean
+camel_search_header_match_any (const gchar *value,
+                               CamelSearchMatcher *matcher,
+                               camel_search_match_t how,
+                               camel_search_t type,
+                               const gchar *default_charset)
+{
+	const gchar *name, *addr;
+	const guchar *ptr;
+	gint truth = FALSE, i;
+	CamelInternetAddress *cia;
+	gchar *v;
+	gunichar c;
+
+	g_return_val_if_fail (value != NULL, FALSE);
+	g_return_val_if_fail (matcher != NULL, FALSE);
+
+	if ((how != CAMEL_SEARCH_MATCH_CONTAINS && how != CAMEL_SEARCH_MATCH_WORD) ||
+	    type == CAMEL_SEARCH_TYPE_MLIST) {
+		for (i = 0; i < matcher->n_patterns && !truth; i++)
+			truth = camel_search_header_match (value, matcher->patterns[i], how, type, default_charset);
+
+		return truth;
+	}
+
+	ptr = (const guchar *) value;
+	while ((c = camel_utf8_getc (&ptr)) && g_unichar_isspace (c))
+		value = (const gchar *) ptr;
+
+	switch (type) {
+	case CAMEL_SEARCH_TYPE_ENCODED:
+		v = camel_header_decode_string (value, default_charset);
+		truth = search_matcher_match_value (matcher, v, how);
+		g_free (v);
+		break;
+	case CAMEL_SEARCH_TYPE_ASIS:
+		truth = search_matcher_match_value (matcher, value, how);
+		break;
+	case CAMEL_SEARCH_TYPE_ADDRESS_ENCODED:
+	case CAMEL_SEARCH_TYPE_ADDRESS:
+		if (search_matcher_match_value (matcher, value, how))
+			return TRUE;
+
+		cia = camel_internet_address_new ();
+		if (type == CAMEL_SEARCH_TYPE_ADDRESS_ENCODED)
+			camel_address_decode ((CamelAddress *) cia, value);
+		else
+			camel_address_unformat ((CamelAddress *) cia, value);
+
+		for (i = 0; !truth && camel_internet_address_get (cia, i, &name, &addr); i++)
+			truth =
+				(name && search_matcher_match_value (matcher, name, how)) ||
+				(addr && search_matcher_match_value (matcher, addr, how));
+
+		g_object_unref (cia);
+		break;
+	default:
+		break;
+	}
+
+	return truth;
+}
+
+typedef gboolean (*SearchBodyTextFunc) (const gchar *text,
+					 gsize len,
+					 gpointer user_data);
+
+/* Decodes each textual part of the message to UTF-8 and hands it to
+ * func, until func returns TRUE. */
+static gboolean
+search_message_body_foreach (CamelDataWrapper *object,
+                             SearchBodyTextFunc func,
+                             gpointer user_data)
 {
 	CamelDataWrapper *containee;
 	gint truth = FALSE;
@@ -521,11 +1024,11 @@ camel_search_message_body_contains (CamelDataWrapper *object,
 		for (i = 0; i < parts && truth == FALSE; i++) {
 			CamelDataWrapper *part = (CamelDataWrapper *) camel_multipart_get_part (CAMEL_MULTIPART (containee), i);
 			if (part)
-				truth = camel_search_message_body_contains (part, pattern);
+				truth = search_message_body_foreach (part, func, user_data);
 		}
 	} else if (CAMEL_IS_MIME_MESSAGE (containee)) {
 		/* For messages we only look at its contents. */
-		truth = camel_search_message_body_contains ((CamelDataWrapper *) containee, pattern);
+		truth = search_message_body_foreach ((CamelDataWrapper *) containee, func, user_data);
 	} else if (camel_content_type_is (CAMEL_DATA_WRAPPER (containee)->mime_type, "text", "*")
 		|| camel_content_type_is (CAMEL_DATA_WRAPPER (containee)->mime_type, "x-evolution", "evolution-rss-feed")) {
 		/* For all other text parts we look
@@ -556,13 +1059,51 @@ camel_search_message_body_contains (CamelDataWrapper *object,
 		camel_data_wrapper_decode_to_stream_sync (
 			containee, stream, NULL, NULL);
 		camel_stream_write (stream, "", 1, NULL, NULL);
-		truth = regexec (pattern, (gchar *) byte_array->data, 0, NULL, 0) == 0;
+		truth = func ((const gchar *) byte_array->data, byte_array->len, user_data);
 		g_object_unref (stream);
 	}
 
 	return truth;
 }
 
+static gboolean
+search_body_regex_cb (const gchar *text,
+                      gsize len,
+                      gpointer user_data)
+{
+	regex_t *pattern = user_data;
+
+	return regexec (pattern, text, 0, NULL, 0) == 0;
+}
+
+/* Performs a 'slow' content-based match. */
+/* There is also an identical copy of this in camel-filter-search.c. */
+gboolean
+camel_search_message_body_contains (CamelDataWrapper *object,
+                                    regex_t *pattern)
+{
+	return search_message_body_foreach (object, search_body_regex_cb, pattern);
+}
+
+static gboolean
+search_body_matcher_cb (const gchar *text,
+                        gsize len,
+                        gpointer user_data)
+{
+	CamelSearchMatcher *matcher = user_data;
+
+	return camel_search_matcher_contains_any (matcher, text, len);
+}
+
+/* Like camel_search_message_body_contains(), but looks for any of the
+ * patterns of the matcher, ignoring case, in a single pass over each part. */
+gboolean
+camel_search_message_body_contains_any (CamelDataWrapper *object,
+                                        CamelSearchMatcher *matcher)
+{
+	return search_message_body_foreach (object, search_body_matcher_cb, matcher);
+}
+
 static void
 output_c (GString *w,
           guint32 c,
@@ -53,6 +53,9 @@ typedef enum {
 	CAMEL_SEARCH_TYPE_MLIST /* its a mailing list pseudo-header */
 } camel_search_t;
 
+/* a set of patterns to look for at once */
+typedef struct _CamelSearchMatcher CamelSearchMatcher;
+
 /* builds a regex that represents a string search */
 gint		camel_search_build_match_regex	(regex_t *pattern,
 						 camel_search_flags_t type,
@@ -62,12 +65,20 @@ gint		camel_search_build_match_regex	(regex_t *pattern,
 gboolean	camel_search_message_body_contains
 						(CamelDataWrapper *object,
 						 regex_t *pattern);
+gboolean	camel_search_message_body_contains_any
+						(CamelDataWrapper *object,
+						 CamelSearchMatcher *matcher);
 
 gboolean	camel_search_header_match	(const gchar *value,
 						 const gchar *match,
 						 camel_search_match_t how,
 						 camel_search_t type,
 						 const gchar *default_charset);
+gboolean	camel_search_header_match_any	(const gchar *value,
+						 CamelSearchMatcher *matcher,
+						 camel_search_match_t how,
+						 camel_search_t type,
+						 const gchar *default_charset);
 gboolean	camel_search_camel_header_soundex
 						(const gchar *header,
 						 const gchar *match);
@@ -100,6 +111,31 @@ struct _camel_search_words *
 		camel_search_words_simple	(struct _camel_search_words *words);
 void		camel_search_words_free		(struct _camel_search_words *words);
 
+CamelSearchMatcher *
+		camel_search_matcher_new	(const gchar * const *patterns,
+						 gint n_patterns);
+CamelSearchMatcher *
+		camel_search_matcher_new_for_words
+						(struct _camel_search_words *words);
+CamelSearchMatcher *
+		camel_search_matcher_ref_for_argv
+						(gint argc,
+						 CamelSExpResult **argv);
+CamelSearchMatcher *
+		camel_search_matcher_ref	(CamelSearchMatcher *matcher);
+void		camel_search_matcher_unref	(CamelSearchMatcher *matcher);
+gint		camel_search_matcher_get_n_patterns
+						(CamelSearchMatcher *matcher);
+gboolean	camel_search_matcher_contains_any
+						(CamelSearchMatcher *matcher,
+						 const gchar *text,
+						 gssize len);
+gint		camel_search_matcher_contains_all
+						(CamelSearchMatcher *matcher,
+						 const gchar *text,
+						 gssize len,
+						 guint8 *found);
+
 G_END_DECLS
 
 #endif /* CAMEL_SEARCH_PRIVATE_H */
@@ -88,24 +88,39 @@ camel_strdown (gchar *str)
 	return str;
 }
 
-/* working stuff for pstrings */
-static GMutex string_pool_lock;
-static GHashTable *string_pool = NULL;
+/* working stuff for pstrings
+ *
+ * The pool is split into independently locked shards, selected by the
+ * string hash, so that threads loading different folders at the same
+ * time do not all serialise on a single mutex. */
+#define STRING_POOL_N_SHARDS (32)
 
 typedef struct _StringPoolNode StringPoolNode;
+typedef struct _StringPoolShard StringPoolShard;
 
 struct _StringPoolNode {
 	gchar *string;
+	guint hash;
 	gulong ref_count;
 };
 
+struct _StringPoolShard {
+	GMutex lock;
+	GHashTable *table;
+};
+
+static StringPoolShard string_pool[STRING_POOL_N_SHARDS];
+static volatile gint string_pool_contended = 0;
+
 static StringPoolNode *
-string_pool_node_new (gchar *string)
+string_pool_node_new (gchar *string,
+                      guint hash)
 {
 	StringPoolNode *node;
 
 	node = g_slice_new (StringPoolNode);
 	node->string = string;  /* takes ownership */
+	node->hash = hash;
 	node->ref_count = 1;
 
 	return node;
@@ -122,25 +137,46 @@ string_pool_node_free (StringPoolNode *node)
 static guint
 string_pool_node_hash (const StringPoolNode *node)
 {
-	return g_str_hash (node->string);
+	return node->hash;
 }
 
 static gboolean
 string_pool_node_equal (const StringPoolNode *node_a,
                         const StringPoolNode *node_b)
 {
-	return g_str_equal (node_a->string, node_b->string);
+	return node_a->hash == node_b->hash &&
+		g_str_equal (node_a->string, node_b->string);
 }
 
-static void
-string_pool_init (void)
+/* Returns the shard responsible for @hash, locked.  When @create is
+ * %FALSE and the shard was never used, returns %NULL without locking. */
+static StringPoolShard *
+string_pool_lock_shard (guint hash,
+                        gboolean create)
 {
-	if (G_UNLIKELY (string_pool == NULL))
-		string_pool = g_hash_table_new_full (
+	StringPoolShard *shard;
+
+	shard = &string_pool[hash % STRING_POOL_N_SHARDS];
+
+	if (!g_mutex_trylock (&shard->lock)) {
+		g_atomic_int_inc (&string_pool_contended);
+		g_mutex_lock (&shard->lock);
+	}
+
+	if (G_UNLIKELY (shard->table == NULL)) {
+		if (!create) {
+			g_mutex_unlock (&shard->lock);
+			return NULL;
+		}
+
+		shard->table = g_hash_table_new_full (
 			(GHashFunc) string_pool_node_hash,
 			(GEqualFunc) string_pool_node_equal,
 			(GDestroyNotify) string_pool_node_free,
 			(GDestroyNotify) NULL);
+	}
+
+	return shard;
 }
 
 /**
@@ -162,6 +198,7 @@ camel_pstring_add (gchar *string,
                    gboolean own)
 {
 	StringPoolNode static_node = { string, };
+	StringPoolShard *shard;
 	StringPoolNode *node;
 	const gchar *interned;
 
@@ -174,11 +211,10 @@ camel_pstring_add (gchar *string,
 		return "";
 	}
 
-	g_mutex_lock (&string_pool_lock);
-
-	string_pool_init ();
+	static_node.hash = g_str_hash (string);
+	shard = string_pool_lock_shard (static_node.hash, TRUE);
 
-	node = g_hash_table_lookup (string_pool, &static_node);
+	node = g_hash_table_lookup (shard->table, &static_node);
 
 	if (node != NULL) {
 		node->ref_count++;
@@ -187,13 +223,13 @@ camel_pstring_add (gchar *string,
 	} else {
 		if (!own)
 			string = g_strdup (string);
-		node = string_pool_node_new (string);
-		g_hash_table_add (string_pool, node);
+		node = string_pool_node_new (string, static_node.hash);
+		g_hash_table_add (shard->table, node);
 	}
 
 	interned = node->string;
 
-	g_mutex_unlock (&string_pool_lock);
+	g_mutex_unlock (&shard->lock);
 
 	return interned;
 }
@@ -216,6 +252,7 @@ const gchar *
 camel_pstring_peek (const gchar *string)
 {
 	StringPoolNode static_node = { (gchar *) string, };
+	StringPoolShard *shard;
 	StringPoolNode *node;
 	const gchar *interned;
 
@@ -225,20 +262,20 @@ camel_pstring_peek (const gchar *string)
 	if (*string == '\0')
 		return "";
 
-	g_mutex_lock (&string_pool_lock);
+	static_node.hash = g_str_hash (string);
+	shard = string_pool_lock_shard (static_node.hash, TRUE);
 
-	string_pool_init ();
-
-	node = g_hash_table_lookup (string_pool, &static_node);
+	node = g_hash_table_lookup (shard->table, &static_node);
 
 	if (node == NULL) {
-		node = string_pool_node_new (g_strdup (string));
-		g_hash_table_add (string_pool, node);
+		node = string_pool_node_new (
+			g_strdup (string), static_node.hash);
+		g_hash_table_add (shard->table, node);
 	}
 
 	interned = node->string;
 
-	g_mutex_unlock (&string_pool_lock);
+	g_mutex_unlock (&shard->lock);
 
 	return interned;
 }
@@ -274,17 +311,19 @@ void
 camel_pstring_free (const gchar *string)
 {
 	StringPoolNode static_node = { (gchar *) string, };
+	StringPoolShard *shard;
 	StringPoolNode *node;
 
-	if (string_pool == NULL)
-		return;
-
 	if (string == NULL || *string == '\0')
 		return;
 
-	g_mutex_lock (&string_pool_lock);
+	static_node.hash = g_str_hash (string);
+	shard = string_pool_lock_shard (static_node.hash, FALSE);
 
-	node = g_hash_table_lookup (string_pool, &static_node);
+	if (shard == NULL)
+		return;
+
+	node = g_hash_table_lookup (shard->table, &static_node);
 
 	if (node == NULL) {
 		g_warning ("%s: String not in pool: %s", G_STRFUNC, string);
@@ -295,49 +334,74 @@ camel_pstring_free (const gchar *string)
 	} else {
 		node->ref_count--;
 		if (node->ref_count == 0)
-			g_hash_table_remove (string_pool, node);
+			g_hash_table_remove (shard->table, node);
 	}
 
-	g_mutex_unlock (&string_pool_lock);
+	g_mutex_unlock (&shard->lock);
 }
 
 /**
  * camel_pstring_dump_stat:
  *
- * Dumps to stdout memory statistic about the string pool.
+ * Dumps to stdout memory statistic about the string pool: the number
+ * of unique strings, their total size, the bytes saved by sharing them
+ * and how often a thread had to wait for a pool lock.
  *
  * Since: 3.6
  **/
 void
 camel_pstring_dump_stat (void)
 {
-	g_mutex_lock (&string_pool_lock);
-
-	g_print ("   String Pool Statistics: ");
+	guint64 bytes = 0, saved = 0;
+	guint n_strings = 0;
+	gboolean used = FALSE;
+	gint ii;
 
-	if (string_pool == NULL) {
-		g_print ("Not used yet\n");
-	} else {
+	for (ii = 0; ii < STRING_POOL_N_SHARDS; ii++) {
+		StringPoolShard *shard = &string_pool[ii];
 		GHashTableIter iter;
-		gchar *format_size;
-		guint64 bytes = 0;
 		gpointer key;
 
-		g_hash_table_iter_init (&iter, string_pool);
+		g_mutex_lock (&shard->lock);
 
-		while (g_hash_table_iter_next (&iter, &key, NULL))
-			bytes += strlen (((StringPoolNode *) key)->string);
+		if (shard->table != NULL) {
+			used = TRUE;
+			n_strings += g_hash_table_size (shard->table);
+
+			g_hash_table_iter_init (&iter, shard->table);
+
+			while (g_hash_table_iter_next (&iter, &key, NULL)) {
+				StringPoolNode *node = key;
+				gsize len = strlen (node->string);
+
+				bytes += len;
+				if (node->ref_count > 1)
+					saved += (guint64) len * (node->ref_count - 1);
+			}
+		}
+
+		g_mutex_unlock (&shard->lock);
+	}
+
+	g_print ("   String Pool Statistics: ");
+
+	if (!used) {
+		g_print ("Not used yet\n");
+	} else {
+		gchar *format_size, *format_saved;
 
 		format_size = g_format_size_full (
 			bytes, G_FORMAT_SIZE_LONG_FORMAT);
+		format_saved = g_format_size_full (
+			saved, G_FORMAT_SIZE_LONG_FORMAT);
 
 		g_print (
-			"Holds %d strings totaling %s\n",
-			g_hash_table_size (string_pool),
-			format_size);
+			"Holds %u strings totaling %s, sharing saves %s, "
+			"%d contended lock acquisitions\n",
+			n_strings, format_size, format_saved,
+			g_atomic_int_get (&string_pool_contended));
 
 		g_free (format_size);
+		g_free (format_saved);
 	}
-
-	g_mutex_unlock (&string_pool_lock);
 }
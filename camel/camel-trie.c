@@ -123,6 +123,7 @@ camel_trie_new (gboolean icase)
 	trie->root.fail = NULL;
 	trie->root.match = NULL;
 	trie->root.final = 0;
+	trie->root.id = -1;
 
 	trie->fail_states = g_ptr_array_sized_new (8);
 	trie->icase = icase;
@@ -393,3 +394,63 @@ camel_trie_search (CamelTrie *trie,
 
 	return NULL;
 }
+
+/**
+ * camel_trie_search_all:
+ * @trie: The #CamelTrie to search in.
+ * @buffer: The string to find the patterns of @trie in.
+ * @buflen: The length of @buffer.
+ * @func: (scope call): a #CamelTrieMatchFunc to call for each match
+ * @user_data: data to pass to @func
+ *
+ * Finds every occurrence of every pattern of @trie in @buffer, in a
+ * single pass, calling @func for each of them.  Unlike with
+ * camel_trie_search(), patterns which are a suffix of another pattern
+ * are reported too.  The search stops when @func returns %FALSE.
+ *
+ * Since: 3.20
+ **/
+void
+camel_trie_search_all (CamelTrie *trie,
+                       const gchar *buffer,
+                       gsize buflen,
+                       CamelTrieMatchFunc func,
+                       gpointer user_data)
+{
+	const guchar *inptr, *inend;
+	struct _trie_state *q, *r;
+	struct _trie_match *m = NULL; /* init to please gcc */
+	gunichar c;
+
+	g_return_if_fail (trie != NULL);
+	g_return_if_fail (func != NULL);
+
+	inptr = (const guchar *) buffer;
+	inend = inptr + buflen;
+
+	q = &trie->root;
+	while ((c = trie_utf8_getc (&inptr, inend - inptr))) {
+		if (c == 0xfffe)
+			continue;
+
+		if (trie->icase)
+			c = g_unichar_tolower (c);
+
+		while (q != NULL && (m = g (q, c)) == NULL)
+			q = q->fail;
+
+		if (q == NULL) {
+			q = &trie->root;
+			continue;
+		}
+
+		q = m->state;
+
+		/* A non-zero 'final' means a pattern ends here, or in one
+		 * of the states down the failure chain; report them all. */
+		for (r = q; r != NULL && r->final; r = r->fail) {
+			if (r->id != -1 && !func (r->id, (const gchar *) inptr, user_data))
+				return;
+		}
+	}
+}
@@ -29,6 +29,22 @@ G_BEGIN_DECLS
 
 typedef struct _CamelTrie CamelTrie;
 
+/**
+ * CamelTrieMatchFunc:
+ * @pattern_id: the id of the matched pattern
+ * @match_end: where the match ends in the searched buffer
+ * @user_data: user data passed to camel_trie_search_all()
+ *
+ * Called by camel_trie_search_all() for each pattern occurrence.
+ *
+ * Returns: %TRUE to continue the search, %FALSE to stop it
+ *
+ * Since: 3.20
+ **/
+typedef gboolean	(*CamelTrieMatchFunc)		(gint pattern_id,
+							 const gchar *match_end,
+							 gpointer user_data);
+
 CamelTrie *	camel_trie_new			(gboolean icase);
 void		camel_trie_free			(CamelTrie *trie);
 void		camel_trie_add			(CamelTrie *trie,
@@ -38,6 +54,11 @@ const gchar *	camel_trie_search		(CamelTrie *trie,
 						 const gchar *buffer,
 						 gsize buflen,
 						 gint *matched_id);
+void		camel_trie_search_all		(CamelTrie *trie,
+						 const gchar *buffer,
+						 gsize buflen,
+						 CamelTrieMatchFunc func,
+						 gpointer user_data);
 
 G_END_DECLS
 
@@ -1051,6 +1051,7 @@ camel_imapx_folder_new (CamelStore *store,
 	gboolean filter_junk;
 	gboolean filter_junk_inbox;
 	gboolean store_offline_sync = FALSE;
+	guint message_cache_size = 0;
 
 	d ("opening imap folder '%s'\n", folder_dir);
 
@@ -1065,6 +1066,7 @@ camel_imapx_folder_new (CamelStore *store,
 		"filter-junk", &filter_junk,
 		"filter-junk-inbox", &filter_junk_inbox,
 		"stay-synchronized", &store_offline_sync,
+		"message-cache-size", &message_cache_size,
 		NULL);
 
 	g_object_unref (settings);
@@ -1099,6 +1101,10 @@ camel_imapx_folder_new (CamelStore *store,
 		return NULL;
 	}
 
+	/* Fetched messages are written out by a separate thread,
+	 * the connection reads on while the disk catches up */
+	camel_data_cache_set_write_behind (imapx_folder->cache, TRUE);
+
 	state_file = g_build_filename (folder_dir, "cmeta", NULL);
 	camel_object_set_state_filename (CAMEL_OBJECT (folder), state_file);
 	g_free (state_file);
@@ -1113,6 +1119,13 @@ camel_imapx_folder_new (CamelStore *store,
 		/* Set cache expiration for one week. */
 		camel_data_cache_set_expire_age (imapx_folder->cache, 60 * 60 * 24 * 7);
 		camel_data_cache_set_expire_access (imapx_folder->cache, 60 * 60 * 24 * 7);
+
+		/* Messages not read lately are the first to go when
+		 * the cache is bounded; they can be downloaded again. */
+		if (message_cache_size > 0)
+			camel_data_cache_set_size_limit (
+				imapx_folder->cache,
+				(goffset) message_cache_size * 1024 * 1024);
 	}
 
 	imapx_folder->search = camel_imapx_search_new (CAMEL_IMAPX_STORE (store));
@@ -4450,6 +4450,13 @@ camel_imapx_server_append_message_sync (CamelIMAPXServer *is,
 		CAMEL_DATA_WRAPPER (message),
 		filter_stream, cancellable, error);
 
+	/* The cache may write in the background, only
+	 * closing the stream tells whether it all went well */
+	if (res != -1 && !g_output_stream_close (filter_stream, cancellable, error))
+		res = -1;
+	if (res != -1 && !g_io_stream_close (base_stream, cancellable, error))
+		res = -1;
+
 	g_object_unref (base_stream);
 	g_object_unref (filter_stream);
 	g_object_unref (filter);
@@ -32,6 +32,7 @@ struct _CamelIMAPXSettingsPrivate {
 	gchar *shell_command;
 
 	guint concurrent_connections;
+	guint message_cache_size;
 
 	gboolean use_multi_fetch;
 	gboolean check_all;
@@ -79,7 +80,8 @@ enum {
 	PROP_USE_SHELL_COMMAND,
 	PROP_USE_SUBSCRIPTIONS,
 	PROP_IGNORE_OTHER_USERS_NAMESPACE,
-	PROP_IGNORE_SHARED_FOLDERS_NAMESPACE
+	PROP_IGNORE_SHARED_FOLDERS_NAMESPACE,
+	PROP_MESSAGE_CACHE_SIZE
 };
 
 G_DEFINE_TYPE_WITH_CODE (
@@ -126,6 +128,12 @@ imapx_settings_set_property (GObject *object,
 				g_value_get_uint (value));
 			return;
 
+		case PROP_MESSAGE_CACHE_SIZE:
+			camel_imapx_settings_set_message_cache_size (
+				CAMEL_IMAPX_SETTINGS (object),
+				g_value_get_uint (value));
+			return;
+
 		case PROP_FETCH_ORDER:
 			camel_imapx_settings_set_fetch_order (
 				CAMEL_IMAPX_SETTINGS (object),
@@ -298,6 +306,13 @@ imapx_settings_get_property (GObject *object,
 				CAMEL_IMAPX_SETTINGS (object)));
 			return;
 
+		case PROP_MESSAGE_CACHE_SIZE:
+			g_value_set_uint (
+				value,
+				camel_imapx_settings_get_message_cache_size (
+				CAMEL_IMAPX_SETTINGS (object)));
+			return;
+
 		case PROP_FETCH_ORDER:
 			g_value_set_enum (
 				value,
@@ -535,6 +550,21 @@ camel_imapx_settings_class_init (CamelIMAPXSettingsClass *class)
 			G_PARAM_CONSTRUCT |
 			G_PARAM_STATIC_STRINGS));
 
+	g_object_class_install_property (
+		object_class,
+		PROP_MESSAGE_CACHE_SIZE,
+		g_param_spec_uint (
+			"message-cache-size",
+			"Message Cache Size",
+			"Most megabytes of downloaded messages "
+			"to keep per folder, 0 for no limit",
+			0,
+			G_MAXUINT,
+			0,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
 	g_object_class_install_property (
 		object_class,
 		PROP_FETCH_ORDER,
@@ -952,6 +982,53 @@ camel_imapx_settings_set_concurrent_connections (CamelIMAPXSettings *settings,
 	g_object_notify (G_OBJECT (settings), "concurrent-connections");
 }
 
+/**
+ * camel_imapx_settings_get_message_cache_size:
+ * @settings: a #CamelIMAPXSettings
+ *
+ * Returns the most megabytes of downloaded messages to keep in the local
+ * cache of each folder, or 0 when the cache size is not bounded.
+ *
+ * Returns: the message cache size limit, in megabytes
+ *
+ * Since: 3.20
+ **/
+guint
+camel_imapx_settings_get_message_cache_size (CamelIMAPXSettings *settings)
+{
+	g_return_val_if_fail (CAMEL_IS_IMAPX_SETTINGS (settings), 0);
+
+	return settings->priv->message_cache_size;
+}
+
+/**
+ * camel_imapx_settings_set_message_cache_size:
+ * @settings: a #CamelIMAPXSettings
+ * @message_cache_size: the message cache size limit, in megabytes
+ *
+ * Sets the most megabytes of downloaded messages to keep in the local
+ * cache of each folder.  The least recently read messages are removed
+ * from the cache once it grows past this, to be downloaded again when
+ * needed.  Use 0 to not bound the cache size.
+ *
+ * The limit does not apply to folders kept synchronized for offline use.
+ *
+ * Since: 3.20
+ **/
+void
+camel_imapx_settings_set_message_cache_size (CamelIMAPXSettings *settings,
+                                             guint message_cache_size)
+{
+	g_return_if_fail (CAMEL_IS_IMAPX_SETTINGS (settings));
+
+	if (settings->priv->message_cache_size == message_cache_size)
+		return;
+
+	settings->priv->message_cache_size = message_cache_size;
+
+	g_object_notify (G_OBJECT (settings), "message-cache-size");
+}
+
 /**
  * camel_imapx_settings_get_fetch_order:
  * @settings: a #CamelIMAPXSettings
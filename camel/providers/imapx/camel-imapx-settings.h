@@ -75,6 +75,11 @@ guint		camel_imapx_settings_get_concurrent_connections
 void		camel_imapx_settings_set_concurrent_connections
 						(CamelIMAPXSettings *settings,
 						 guint concurrent_connections);
+guint		camel_imapx_settings_get_message_cache_size
+						(CamelIMAPXSettings *settings);
+void		camel_imapx_settings_set_message_cache_size
+						(CamelIMAPXSettings *settings,
+						 guint message_cache_size);
 CamelSortType	camel_imapx_settings_get_fetch_order
 						(CamelIMAPXSettings *settings);
 void		camel_imapx_settings_set_fetch_order
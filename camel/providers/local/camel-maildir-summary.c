@@ -26,6 +26,7 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -93,6 +94,13 @@ struct _CamelMaildirSummaryPrivate {
 
 	GHashTable *load_map;
 	GMutex summary_lock;
+
+	/* Modification times of cur/ and new/ as of the last complete
+	 * check, or 0 when unknown.  Every file added, renamed or removed
+	 * in a directory updates its mtime, so unchanged times mean the
+	 * summary is still in sync and the scan can be skipped. */
+	time_t cur_mtime;
+	time_t new_mtime;
 };
 
 struct _CamelMaildirMessageContentInfo {
@@ -576,6 +584,50 @@ remove_summary (gchar *key,
 	g_object_unref (info);
 }
 
+static gboolean
+maildir_summary_unchanged (CamelMaildirSummary *mds,
+                           const gchar *cur,
+                           const gchar *new)
+{
+	struct stat cur_st, new_st;
+
+	if (mds->priv->cur_mtime == 0 || mds->priv->new_mtime == 0)
+		return FALSE;
+
+	/* an emptied summary has to be refilled, whatever the disk says */
+	if (camel_folder_summary_count (CAMEL_FOLDER_SUMMARY (mds)) == 0)
+		return FALSE;
+
+	if (g_stat (cur, &cur_st) == -1 || g_stat (new, &new_st) == -1)
+		return FALSE;
+
+	return cur_st.st_mtime == mds->priv->cur_mtime &&
+		new_st.st_mtime == mds->priv->new_mtime;
+}
+
+static void
+maildir_summary_remember_mtimes (CamelMaildirSummary *mds,
+                                 const gchar *cur,
+                                 const gchar *new,
+                                 time_t check_start)
+{
+	struct stat cur_st, new_st;
+
+	mds->priv->cur_mtime = 0;
+	mds->priv->new_mtime = 0;
+
+	if (g_stat (cur, &cur_st) == -1 || g_stat (new, &new_st) == -1)
+		return;
+
+	/* mtimes have one second granularity; a directory touched in the
+	 * same second the check started might have changed after it was
+	 * read, so only trust times which are strictly older */
+	if (cur_st.st_mtime < check_start && new_st.st_mtime < check_start) {
+		mds->priv->cur_mtime = cur_st.st_mtime;
+		mds->priv->new_mtime = new_st.st_mtime;
+	}
+}
+
 static gint
 maildir_summary_check (CamelLocalSummary *cls,
                        CamelFolderChangeInfo *changes,
@@ -595,12 +647,23 @@ maildir_summary_check (CamelLocalSummary *cls,
 	gchar *uid;
 	struct _remove_data rd = { cls, changes };
 	GPtrArray *known_uids;
+	time_t check_start;
 
 	g_mutex_lock (&((CamelMaildirSummary *) cls)->priv->summary_lock);
 
 	new = g_strdup_printf ("%s/new", cls->folder_path);
 	cur = g_strdup_printf ("%s/cur", cls->folder_path);
 
+	check_start = time (NULL);
+
+	if (maildir_summary_unchanged (CAMEL_MAILDIR_SUMMARY (cls), cur, new)) {
+		d (printf ("maildir unchanged, skipping check\n"));
+		g_free (cur);
+		g_free (new);
+		g_mutex_unlock (&((CamelMaildirSummary *) cls)->priv->summary_lock);
+		return 0;
+	}
+
 	d (printf ("checking summary ...\n"));
 
 	camel_operation_push_message (
@@ -634,20 +697,16 @@ maildir_summary_check (CamelLocalSummary *cls,
 		}
 	}
 
-	/* joy, use this to pre-count the total, so we can report progress meaningfully */
-	total = 0;
+	/* the summary is a good enough estimate of the size of cur/ for
+	 * reporting progress, and saves reading the directory twice */
+	total = known_uids ? known_uids->len : 0;
 	count = 0;
-	while (readdir (dir))
-		total++;
-	rewinddir (dir);
 
 	while ((d = readdir (dir))) {
 		gint pc;
 
-		/* Avoid a potential division by zero if the first loop
-		 * (to calculate total) is executed on an empty
-		 * directory, then the directory is populated before
-		 * this loop is executed. */
+		/* cur/ can hold more files than the summary knows of,
+		 * keep the estimate above the count of files seen */
 		total = MAX (total, count + 1);
 		pc = (total > 0) ? count * 100 / total : 0;
 
@@ -776,6 +835,9 @@ maildir_summary_check (CamelLocalSummary *cls,
 		closedir (dir);
 	}
 
+	maildir_summary_remember_mtimes (
+		CAMEL_MAILDIR_SUMMARY (cls), cur, new, check_start);
+
 	g_free (new);
 	g_free (cur);
 
@@ -24,6 +24,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -56,6 +57,13 @@ struct _CamelMboxMessageContentInfo {
 	CamelMessageContentInfo info;
 };
 
+/* Summary changes of a sync, held back until the new mailbox is in place */
+typedef struct _MboxSyncChanges {
+	GPtrArray *kept;     /* CamelMboxMessageInfo written to the new mailbox */
+	GArray *frompos;     /* Their From line offsets in the new mailbox */
+	GPtrArray *expunged; /* CamelMboxMessageInfo left out of the new mailbox */
+} MboxSyncChanges;
+
 static CamelFIRecord *
 		summary_header_to_db		(CamelFolderSummary *,
 						 GError **error);
@@ -78,6 +86,8 @@ static CamelMessageInfo *
 static gchar *	mbox_summary_encode_x_evolution	(CamelLocalSummary *cls,
 						 const CamelLocalMessageInfo *mi);
 
+static gint	mbox_summary_journal_replay	(CamelLocalSummary *cls,
+						 GError **error);
 static gint	mbox_summary_check		(CamelLocalSummary *cls,
 						 CamelFolderChangeInfo *changeinfo,
 						 GCancellable *cancellable,
@@ -101,6 +111,15 @@ static gint	mbox_summary_sync_quick		(CamelMboxSummary *cls,
 						 CamelFolderChangeInfo *changeinfo,
 						 GCancellable *cancellable,
 						 GError **error);
+static gint	mbox_summary_sync_mbox_range	(CamelMboxSummary *cls,
+						 guint32 flags,
+						 CamelFolderChangeInfo *changeinfo,
+						 gint fd,
+						 gint fdout,
+						 goffset start,
+						 MboxSyncChanges *changes,
+						 GCancellable *cancellable,
+						 GError **error);
 static gint	mbox_summary_sync_full		(CamelMboxSummary *cls,
 						 gboolean expunge,
 						 CamelFolderChangeInfo *changeinfo,
@@ -601,6 +620,17 @@ mbox_summary_check (CamelLocalSummary *cls,
 
 	camel_folder_summary_lock (s);
 
+	/* finish a tail sync which was interrupted, the summary
+	 * no longer describes the mailbox after that */
+	switch (mbox_summary_journal_replay (cls, error)) {
+	case -1:
+		camel_folder_summary_unlock (s);
+		return -1;
+	case 1:
+		cls->check_force = 1;
+		break;
+	}
+
 	/* check if the summary is up-to-date */
 	if (g_stat (cls->folder_path, &st) == -1) {
 		camel_folder_summary_clear (s, NULL);
@@ -666,6 +696,390 @@ mbox_summary_check (CamelLocalSummary *cls,
 	return ret;
 }
 
+/* Returns the From line offset of the first message which a full sync
+ * has to rewrite or drop, or -1 if there is none.  Everything before it
+ * would be copied through unchanged. */
+static goffset
+mbox_summary_first_dirty_pos (CamelMboxSummary *mbs,
+                              gboolean expunge)
+{
+	CamelFolderSummary *s = CAMEL_FOLDER_SUMMARY (mbs);
+	GPtrArray *known_uids;
+	goffset first = -1;
+	gint i;
+
+	camel_folder_summary_prepare_fetch_all (s, NULL);
+	known_uids = camel_folder_summary_get_array (s);
+
+	for (i = 0; known_uids && i < known_uids->len; i++) {
+		CamelMboxMessageInfo *info;
+		guint32 flags;
+
+		info = (CamelMboxMessageInfo *) camel_folder_summary_get (s, g_ptr_array_index (known_uids, i));
+		if (!info)
+			continue;
+
+		flags = info->info.info.flags;
+		if ((expunge && (flags & CAMEL_MESSAGE_DELETED)) ||
+		    (flags & (CAMEL_MESSAGE_FOLDER_NOXEV | CAMEL_MESSAGE_FOLDER_FLAGGED | CAMEL_MESSAGE_FOLDER_XEVCHANGE))) {
+			if (first == -1 || info->frompos < first)
+				first = info->frompos;
+		}
+
+		g_object_unref (info);
+	}
+
+	camel_folder_summary_free_array (known_uids);
+
+	return first;
+}
+
+/* Copies @len bytes at @from in @fd to @to in @fdout */
+static gboolean
+mbox_summary_copy_range (gint fd,
+                         goffset from,
+                         gint fdout,
+                         goffset to,
+                         goffset len)
+{
+	gchar *buffer;
+	goffset copied = 0;
+
+	if (lseek (fd, from, SEEK_SET) == -1 ||
+	    lseek (fdout, to, SEEK_SET) == -1)
+		return FALSE;
+
+	buffer = g_malloc (65536);
+
+	while (copied < len) {
+		gssize size, sizeout;
+		gchar *p;
+
+		do {
+			size = read (fd, buffer, MIN (65536, len - copied));
+		} while (size == -1 && errno == EINTR);
+
+		if (size <= 0) {
+			if (size == 0)
+				errno = EIO;
+			break;
+		}
+
+		copied += size;
+
+		for (p = buffer; size > 0; p += sizeout, size -= sizeout) {
+			do {
+				sizeout = write (fdout, p, size);
+			} while (sizeout == -1 && errno == EINTR);
+
+			if (sizeout <= 0)
+				break;
+		}
+
+		if (size > 0) {
+			copied = -1;
+			break;
+		}
+	}
+
+	g_free (buffer);
+
+	return copied == len;
+}
+
+/* The journal of a tail sync is a fixed-size header followed by the
+ * new content of the mailbox from the header's start offset on.  The
+ * header is written last, thus a journal with a valid header is
+ * complete and can be copied over the mailbox again after a crash. */
+#define MBOX_JOURNAL_HEADER_SIZE (64)
+#define MBOX_JOURNAL_MAGIC "camel-mbox-journal"
+
+static gchar *
+mbox_summary_journal_path (CamelLocalSummary *cls)
+{
+	return g_strconcat (cls->folder_path, ".journal", NULL);
+}
+
+static gboolean
+mbox_summary_journal_write_header (gint fdjournal,
+                                   goffset start,
+                                   goffset len)
+{
+	gchar header[MBOX_JOURNAL_HEADER_SIZE] = { 0 };
+
+	g_snprintf (
+		header, sizeof (header),
+		MBOX_JOURNAL_MAGIC " %" G_GINT64_FORMAT " %" G_GINT64_FORMAT "\n",
+		(gint64) start, (gint64) len);
+
+	return lseek (fdjournal, 0, SEEK_SET) == 0 &&
+		write (fdjournal, header, sizeof (header)) == sizeof (header);
+}
+
+static gboolean
+mbox_summary_journal_read_header (gint fdjournal,
+                                  goffset *start,
+                                  goffset *len)
+{
+	gchar header[MBOX_JOURNAL_HEADER_SIZE + 1] = { 0 };
+	gint64 hstart, hlen;
+	struct stat st;
+
+	if (lseek (fdjournal, 0, SEEK_SET) != 0 ||
+	    read (fdjournal, header, MBOX_JOURNAL_HEADER_SIZE) != MBOX_JOURNAL_HEADER_SIZE ||
+	    sscanf (header, MBOX_JOURNAL_MAGIC " %" G_GINT64_FORMAT " %" G_GINT64_FORMAT, &hstart, &hlen) != 2 ||
+	    fstat (fdjournal, &st) == -1)
+		return FALSE;
+
+	if (hstart <= 0 || hlen < 0 || st.st_size != MBOX_JOURNAL_HEADER_SIZE + hlen)
+		return FALSE;
+
+	*start = hstart;
+	*len = hlen;
+
+	return TRUE;
+}
+
+/* Copies the content of a complete journal over the mailbox */
+static gboolean
+mbox_summary_journal_apply (gint fdjournal,
+                            gint fd,
+                            goffset start,
+                            goffset len)
+{
+	return mbox_summary_copy_range (fdjournal, MBOX_JOURNAL_HEADER_SIZE, fd, start, len) &&
+		ftruncate (fd, start + len) == 0 &&
+		fsync (fd) == 0;
+}
+
+/* Finishes a tail sync which was interrupted after its journal was
+ * complete, and drops the journal of one interrupted before.  Returns
+ * 1 when the mailbox was changed, thus the summary has to be rebuilt. */
+static gint
+mbox_summary_journal_replay (CamelLocalSummary *cls,
+                             GError **error)
+{
+	gchar *journal;
+	goffset start, len;
+	gint fd, fdjournal;
+	gint ret = 0;
+
+	journal = mbox_summary_journal_path (cls);
+
+	fdjournal = g_open (journal, O_LARGEFILE | O_RDONLY | O_BINARY, 0);
+	if (fdjournal == -1) {
+		g_free (journal);
+		return 0;
+	}
+
+	if (mbox_summary_journal_read_header (fdjournal, &start, &len)) {
+		d (printf ("replaying mbox journal from %" G_GINT64_FORMAT "\n", (gint64) start));
+
+		fd = g_open (cls->folder_path, O_LARGEFILE | O_RDWR | O_BINARY, 0);
+		if (fd == -1 || !mbox_summary_journal_apply (fdjournal, fd, start, len)) {
+			g_set_error (
+				error, G_IO_ERROR,
+				g_io_error_from_errno (errno),
+				_("Could not store folder: %s"),
+				g_strerror (errno));
+			ret = -1;
+		} else {
+			ret = 1;
+		}
+
+		if (fd != -1)
+			close (fd);
+	}
+
+	close (fdjournal);
+
+	/* keep a complete journal until it is copied over */
+	if (ret != -1)
+		g_unlink (journal);
+
+	g_free (journal);
+
+	return ret;
+}
+
+static void
+mbox_sync_changes_clear (MboxSyncChanges *changes)
+{
+	g_ptr_array_free (changes->kept, TRUE);
+	g_ptr_array_free (changes->expunged, TRUE);
+	g_array_free (changes->frompos, TRUE);
+}
+
+/* Applies the summary changes once the new mailbox replaced the old one */
+static void
+mbox_sync_changes_apply (CamelMboxSummary *mbs,
+                         MboxSyncChanges *changes,
+                         CamelFolderChangeInfo *changeinfo)
+{
+	CamelFolderSummary *s = CAMEL_FOLDER_SUMMARY (mbs);
+	CamelLocalSummary *cls = CAMEL_LOCAL_SUMMARY (mbs);
+	CamelStore *parent_store;
+	const gchar *full_name;
+	GList *del = NULL;
+	guint i;
+
+	for (i = 0; i < changes->kept->len; i++) {
+		CamelMboxMessageInfo *info = g_ptr_array_index (changes->kept, i);
+
+		info->frompos = g_array_index (changes->frompos, goffset, i);
+
+		/* The X-Evolution header was rewritten */
+		if (info->info.info.flags & (CAMEL_MESSAGE_FOLDER_NOXEV | CAMEL_MESSAGE_FOLDER_FLAGGED))
+			info->info.info.flags &= 0xffff;
+
+		info->info.info.flags &= ~(CAMEL_MESSAGE_FOLDER_NOXEV
+					   | CAMEL_MESSAGE_FOLDER_FLAGGED
+					   | CAMEL_MESSAGE_FOLDER_XEVCHANGE);
+		CAMEL_MESSAGE_INFO_BASE (info)->dirty = TRUE;
+	}
+
+	for (i = 0; i < changes->expunged->len; i++) {
+		CamelMessageInfo *info = g_ptr_array_index (changes->expunged, i);
+		const gchar *uid = camel_message_info_get_uid (info);
+
+		if (cls->index)
+			camel_index_delete_name (cls->index, uid);
+
+		camel_folder_change_info_remove_uid (changeinfo, uid);
+		del = g_list_prepend (del, (gpointer) camel_pstring_strdup (uid));
+		camel_folder_summary_remove (s, info);
+	}
+
+	if (del) {
+		full_name = camel_folder_get_full_name (camel_folder_summary_get_folder (s));
+		parent_store = camel_folder_get_parent_store (camel_folder_summary_get_folder (s));
+		camel_db_delete_uids (parent_store->cdb_w, full_name, del, NULL);
+		g_list_foreach (del, (GFunc) camel_pstring_free, NULL);
+		g_list_free (del);
+	}
+
+	camel_folder_summary_touch (s);
+
+	if (changes->expunged->len)
+		camel_folder_summary_header_save_to_db (s, NULL);
+}
+
+/* Sync when the first message to change is far into the mailbox: only
+ * the messages from @start on are walked, and their new content is
+ * written to a journal, which is then copied over the mailbox from
+ * @start on.  The part before @start is neither read nor written.  A
+ * crash while copying is recovered from the journal by the next check,
+ * and the summary only changes after the mailbox is complete. */
+static gint
+mbox_summary_sync_tail (CamelMboxSummary *mbs,
+                        guint32 flags,
+                        CamelFolderChangeInfo *changeinfo,
+                        goffset start,
+                        GCancellable *cancellable,
+                        GError **error)
+{
+	CamelLocalSummary *cls = (CamelLocalSummary *) mbs;
+	MboxSyncChanges changes;
+	gint fd = -1, fdjournal = -1;
+	gchar *journal;
+	gboolean journal_complete = FALSE;
+	goffset len;
+	gint ret = -1;
+
+	d (printf ("performing tail summary/sync from %" G_GINT64_FORMAT "\n", (gint64) start));
+
+	changes.kept = g_ptr_array_new_with_free_func (g_object_unref);
+	changes.expunged = g_ptr_array_new_with_free_func (g_object_unref);
+	changes.frompos = g_array_new (FALSE, FALSE, sizeof (goffset));
+
+	journal = mbox_summary_journal_path (cls);
+
+	fd = g_open (cls->folder_path, O_LARGEFILE | O_RDWR | O_BINARY, 0);
+	if (fd == -1) {
+		g_set_error (
+			error, G_IO_ERROR,
+			g_io_error_from_errno (errno),
+			_("Could not open file: %s: %s"),
+			cls->folder_path, g_strerror (errno));
+		goto exit;
+	}
+
+	fdjournal = g_open (journal, O_LARGEFILE | O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0600);
+	if (fdjournal == -1) {
+		g_set_error (
+			error, G_IO_ERROR,
+			g_io_error_from_errno (errno),
+			_("Cannot open temporary mailbox: %s"),
+			g_strerror (errno));
+		goto exit;
+	}
+
+	/* an empty header until the content is safely written */
+	if (!mbox_summary_journal_write_header (fdjournal, 0, 0)) {
+		g_set_error (
+			error, G_IO_ERROR,
+			g_io_error_from_errno (errno),
+			_("Writing to temporary mailbox failed: %s"),
+			g_strerror (errno));
+		goto exit;
+	}
+
+	if (mbox_summary_sync_mbox_range (
+		mbs, flags, changeinfo, fd, fdjournal,
+		start, &changes, cancellable, error) == -1)
+		goto exit;
+
+	len = lseek (fdjournal, 0, SEEK_END) - MBOX_JOURNAL_HEADER_SIZE;
+
+	if (fsync (fdjournal) == -1 ||
+	    !mbox_summary_journal_write_header (fdjournal, start, len) ||
+	    fsync (fdjournal) == -1) {
+		g_set_error (
+			error, G_IO_ERROR,
+			g_io_error_from_errno (errno),
+			_("Writing to temporary mailbox failed: %s"),
+			g_strerror (errno));
+		goto exit;
+	}
+
+	journal_complete = TRUE;
+
+	if (!mbox_summary_journal_apply (fdjournal, fd, start, len)) {
+		g_set_error (
+			error, G_IO_ERROR,
+			g_io_error_from_errno (errno),
+			_("Could not store folder: %s"),
+			g_strerror (errno));
+		goto exit;
+	}
+
+	mbox_sync_changes_apply (mbs, &changes, changeinfo);
+
+	d (printf (
+		"tail sync wrote %" G_GINT64_FORMAT " bytes, left %" G_GINT64_FORMAT " bytes untouched\n",
+		(gint64) (2 * len + MBOX_JOURNAL_HEADER_SIZE), (gint64) start));
+
+	ret = 0;
+
+ exit:
+	if (fd != -1)
+		close (fd);
+	if (fdjournal != -1)
+		close (fdjournal);
+
+	/* A complete journal which could not be copied over is
+	 * replayed by the next check, which rebuilds the summary */
+	if (ret == 0 || !journal_complete)
+		g_unlink (journal);
+	else
+		cls->check_force = 1;
+
+	mbox_sync_changes_clear (&changes);
+	g_free (journal);
+
+	return ret;
+}
+
 /* perform a full sync */
 static gint
 mbox_summary_sync_full (CamelMboxSummary *mbs,
@@ -680,6 +1094,7 @@ mbox_summary_sync_full (CamelMboxSummary *mbs,
 	gchar *tmpname = NULL;
 	gsize tmpname_len = 0;
 	guint32 flags = (expunge ? 1 : 0), filemode = 0600;
+	goffset start;
 	struct stat st;
 
 	d (printf ("performing full summary/sync\n"));
@@ -687,6 +1102,22 @@ mbox_summary_sync_full (CamelMboxSummary *mbs,
 	camel_operation_push_message (cancellable, _("Storing folder"));
 	camel_folder_summary_lock (s);
 
+	/* The tail sync writes everything from the first changed message
+	 * on twice, to its journal and to the mailbox, and the full sync
+	 * writes the whole mailbox once; pick whichever writes less. */
+	start = mbox_summary_first_dirty_pos (mbs, expunge);
+	if (start > 0 && g_stat (cls->folder_path, &st) == 0 && start >= st.st_size / 2) {
+		gint ret;
+
+		ret = mbox_summary_sync_tail (
+			mbs, flags, changeinfo, start, cancellable, error);
+
+		camel_operation_pop_message (cancellable);
+		camel_folder_summary_unlock (s);
+
+		return ret;
+	}
+
 	fd = g_open (cls->folder_path, O_LARGEFILE | O_RDONLY | O_BINARY, 0);
 	if (fd == -1) {
 		camel_folder_summary_unlock (s);
@@ -1099,6 +1530,26 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
                               gint fdout,
                               GCancellable *cancellable,
                               GError **error)
+{
+	return mbox_summary_sync_mbox_range (
+		cls, flags, changeinfo, fd, fdout, 0, NULL, cancellable, error);
+}
+
+/* Like camel_mbox_summary_sync_mbox(), but only the messages starting at
+ * or after @start (which must be the From line offset of a message) are
+ * written to @fdout, from its current position on, which stands for the
+ * offset @start of the new mailbox.  With @changes the summary is left
+ * alone, the changes are recorded there. */
+static gint
+mbox_summary_sync_mbox_range (CamelMboxSummary *cls,
+                              guint32 flags,
+                              CamelFolderChangeInfo *changeinfo,
+                              gint fd,
+                              gint fdout,
+                              goffset start,
+                              MboxSyncChanges *changes,
+                              GCancellable *cancellable,
+                              GError **error)
 {
 	CamelMboxSummary *mbs = (CamelMboxSummary *) cls;
 	CamelFolderSummary *s = (CamelFolderSummary *) mbs;
@@ -1112,6 +1563,7 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 	const gchar *fromline;
 	gint lastdel = FALSE;
 	gboolean touched = FALSE;
+	goffset out_base;
 	GList *del = NULL;
 	GPtrArray *known_uids = NULL;
 #ifdef STATUS_PINE
@@ -1122,6 +1574,9 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 
 	camel_folder_summary_lock (s);
 
+	/* maps offsets in @fdout to those in the new mailbox */
+	out_base = start - lseek (fdout, 0, SEEK_CUR);
+
 	/* need to dup this because the mime-parser owns the fd after we give it to it */
 	fd = dup (fd);
 	if (fd == -1) {
@@ -1144,6 +1599,10 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 	/* walk them in the same order as stored in the file */
 	if (known_uids && known_uids->len)
 		g_ptr_array_sort_with_data (known_uids, cms_sort_frompos, mbs);
+
+	/* seek straight to the first message to write */
+	lastdel = start > 0;
+
 	for (i = 0; known_uids && i < known_uids->len; i++) {
 		gint pc = (i + 1) * 100 / known_uids->len;
 
@@ -1154,6 +1613,12 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 		if (!info)
 			continue;
 
+		if (info->frompos < start) {
+			g_object_unref (info);
+			info = NULL;
+			continue;
+		}
+
 		d (printf (
 			"Looking at message %s\n",
 			camel_message_info_get_uid (info)));
@@ -1190,25 +1655,37 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 			const gchar *uid = camel_message_info_get_uid (info);
 			d (printf ("Deleting %s\n", uid));
 
-			if (((CamelLocalSummary *) cls)->index)
-				camel_index_delete_name (((CamelLocalSummary *) cls)->index, uid);
+			if (changes) {
+				g_ptr_array_add (changes->expunged, info);
+			} else {
+				if (((CamelLocalSummary *) cls)->index)
+					camel_index_delete_name (((CamelLocalSummary *) cls)->index, uid);
 
-			/* remove it from the change list */
-			camel_folder_change_info_remove_uid (changeinfo, uid);
-			camel_folder_summary_remove (s, (CamelMessageInfo *) info);
-			del = g_list_prepend (del, (gpointer) camel_pstring_strdup (uid));
-			g_object_unref (info);
+				/* remove it from the change list */
+				camel_folder_change_info_remove_uid (changeinfo, uid);
+				camel_folder_summary_remove (s, (CamelMessageInfo *) info);
+				del = g_list_prepend (del, (gpointer) camel_pstring_strdup (uid));
+				g_object_unref (info);
+			}
 			info = NULL;
 			lastdel = TRUE;
 			touched = TRUE;
 		} else {
+			goffset frompos;
+
 			/* otherwise, the message is staying, copy its From_ line across */
 #if 0
 			if (i > 0)
 				write (fdout, "\n", 1);
 #endif
-			info->frompos = lseek (fdout, 0, SEEK_CUR);
-			CAMEL_MESSAGE_INFO_BASE (info)->dirty = TRUE;
+			frompos = lseek (fdout, 0, SEEK_CUR) + out_base;
+			if (changes) {
+				g_ptr_array_add (changes->kept, g_object_ref (info));
+				g_array_append_val (changes->frompos, frompos);
+			} else {
+				info->frompos = frompos;
+				CAMEL_MESSAGE_INFO_BASE (info)->dirty = TRUE;
+			}
 			fromline = camel_mime_parser_from_line (mp);
 			d (printf ("Saving %s:%d\n", camel_message_info_get_uid (info), info->frompos));
 			g_warn_if_fail (write (fdout, fromline, strlen (fromline)) != -1);
@@ -1243,7 +1720,8 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 					g_strerror (errno));
 				goto error;
 			}
-			info->info.info.flags &= 0xffff;
+			if (!changes)
+				info->info.info.flags &= 0xffff;
 			g_free (xevnew);
 			xevnew = NULL;
 			camel_mime_parser_drop_step (mp);
@@ -1298,8 +1776,8 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 
 	g_object_unref (mp);
 
-	/* clear working flags */
-	for (i = 0; known_uids && i < known_uids->len; i++) {
+	/* clear working flags, unless the caller does once the data is safe */
+	for (i = 0; !changes && known_uids && i < known_uids->len; i++) {
 		info = (CamelMboxMessageInfo *) camel_folder_summary_get (s, g_ptr_array_index (known_uids, i));
 		if (info) {
 			if (info->info.info.flags & (CAMEL_MESSAGE_FOLDER_NOXEV | CAMEL_MESSAGE_FOLDER_FLAGGED | CAMEL_MESSAGE_FOLDER_XEVCHANGE)) {
@@ -1316,7 +1794,7 @@ camel_mbox_summary_sync_mbox (CamelMboxSummary *cls,
 
 	camel_folder_summary_free_array (known_uids);
 
-	if (touched)
+	if (touched && !changes)
 		camel_folder_summary_header_save_to_db (s, NULL);
 
 	camel_folder_summary_unlock (s);
@@ -26,10 +26,12 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <glib/gstdio.h>
 #include <glib/gi18n-lib.h>
 
 #include "camel-mh-summary.h"
@@ -52,6 +54,10 @@ static gchar *mh_summary_next_uid_string (CamelFolderSummary *s);
 
 struct _CamelMhSummaryPrivate {
 	gchar *current_uid;
+
+	/* Modification time of the folder directory as of the last
+	 * complete check, or 0 when unknown; see mh_summary_check(). */
+	time_t folder_mtime;
 };
 
 G_DEFINE_TYPE (CamelMhSummary, camel_mh_summary, CAMEL_TYPE_LOCAL_SUMMARY)
@@ -221,9 +227,26 @@ mh_summary_check (CamelLocalSummary *cls,
 	gint i;
 	gboolean forceindex;
 	GPtrArray *known_uids;
+	CamelMhSummary *mhs = CAMEL_MH_SUMMARY (cls);
+	struct stat st;
+	time_t check_start;
 
 	/* FIXME: Handle changeinfo */
 
+	/* Adding, renaming or removing a message file changes the
+	 * directory's mtime, so if it is the same as at the end of the
+	 * last check there is nothing new to find. */
+	check_start = time (NULL);
+	if (mhs->priv->folder_mtime != 0 &&
+	    camel_folder_summary_count ((CamelFolderSummary *) cls) > 0 &&
+	    g_stat (cls->folder_path, &st) == 0 &&
+	    st.st_mtime == mhs->priv->folder_mtime) {
+		d (printf ("folder unchanged, skipping check\n"));
+		return 0;
+	}
+
+	mhs->priv->folder_mtime = 0;
+
 	d (printf ("checking summary ...\n"));
 
 	/* scan the directory, check for mail files not in the index, or index entries that
@@ -290,6 +313,11 @@ mh_summary_check (CamelLocalSummary *cls,
 	g_hash_table_foreach (left, (GHFunc) remove_summary, cls);
 	g_hash_table_destroy (left);
 
+	/* mtimes have one second granularity, don't trust one from
+	 * the same second as the scan */
+	if (g_stat (cls->folder_path, &st) == 0 && st.st_mtime < check_start)
+		mhs->priv->folder_mtime = st.st_mtime;
+
 	return 0;
 }
 
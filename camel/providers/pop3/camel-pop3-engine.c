@@ -477,12 +477,14 @@ camel_pop3_engine_busy_lock (CamelPOP3Engine *pe,
 		handler_id = g_cancellable_connect (cancellable, G_CALLBACK (camel_pop3_engine_wait_cancelled_cb), pe, NULL);
 
 	g_mutex_lock (&pe->busy_lock);
+	pe->busy_waiters++;
 	while (pe->is_busy) {
 		if (g_cancellable_set_error_if_cancelled (cancellable, error))
 			break;
 
 		g_cond_wait (&pe->busy_cond, &pe->busy_lock);
 	}
+	pe->busy_waiters--;
 
 	if (!pe->is_busy && !g_cancellable_is_cancelled (cancellable)) {
 		pe->is_busy = TRUE;
@@ -497,6 +499,27 @@ camel_pop3_engine_busy_lock (CamelPOP3Engine *pe,
 	return got_lock;
 }
 
+/* Takes the busy lock only when it is free and nobody else waits for it,
+   which lets background work step aside; release it with
+   camel_pop3_engine_busy_unlock(). */
+gboolean
+camel_pop3_engine_busy_trylock (CamelPOP3Engine *pe)
+{
+	gboolean got_lock;
+
+	g_return_val_if_fail (CAMEL_IS_POP3_ENGINE (pe), FALSE);
+
+	g_mutex_lock (&pe->busy_lock);
+
+	got_lock = !pe->is_busy && pe->busy_waiters == 0;
+	if (got_lock)
+		pe->is_busy = TRUE;
+
+	g_mutex_unlock (&pe->busy_lock);
+
+	return got_lock;
+}
+
 void
 camel_pop3_engine_busy_unlock (CamelPOP3Engine *pe)
 {
@@ -135,6 +135,7 @@ struct _CamelPOP3Engine {
 	GMutex busy_lock;
 	GCond busy_cond;
 	gboolean is_busy;
+	guint busy_waiters;	/* threads blocked in camel_pop3_engine_busy_lock() */
 };
 
 struct _CamelPOP3EngineClass {
@@ -158,6 +159,7 @@ gint		camel_pop3_engine_iterate	(CamelPOP3Engine *pe,
 gboolean	camel_pop3_engine_busy_lock	(CamelPOP3Engine *pe,
 						 GCancellable *cancellable,
 						 GError **error);
+gboolean	camel_pop3_engine_busy_trylock	(CamelPOP3Engine *pe);
 void		camel_pop3_engine_busy_unlock	(CamelPOP3Engine *pe);
 CamelPOP3Command *
 		camel_pop3_engine_command_new	(CamelPOP3Engine *pe,
@@ -222,6 +222,112 @@ done:
 	fi->stream = NULL;
 }
 
+/* Keeps RETR commands outstanding for up to @window messages following
+ * @index, skipping those already cached or being downloaded.  Called
+ * with the engine busy lock held. */
+static void
+pop3_folder_prefetch (CamelPOP3Folder *pop3_folder,
+                      CamelPOP3Store *pop3_store,
+                      CamelPOP3Engine *pop3_engine,
+                      gint index,
+                      guint window,
+                      GCancellable *cancellable)
+{
+	guint ii, last;
+
+	last = MIN (index + 1 + window, pop3_folder->uids->len);
+	for (ii = index + 1; ii < last; ii++) {
+		CamelPOP3FolderInfo *pfi = pop3_folder->uids->pdata[ii];
+		GError *local_error = NULL;
+
+		if (pfi->uid == NULL || pfi->cmd != NULL ||
+		    camel_pop3_store_cache_has (pop3_store, pfi->uid))
+			continue;
+
+		pfi->stream = camel_pop3_store_cache_add (pop3_store, pfi->uid, NULL);
+		if (pfi->stream == NULL)
+			continue;
+
+		pfi->cmd = camel_pop3_engine_command_new (
+			pop3_engine,
+			CAMEL_POP3_COMMAND_MULTI,
+			cmd_tocache, pfi,
+			cancellable, &local_error,
+			"RETR %u\r\n", pfi->id);
+
+		if (pfi->cmd == NULL) {
+			g_clear_object (&pfi->stream);
+			g_clear_error (&local_error);
+			break;
+		}
+
+		/* the command is queued anyway and fails later on,
+		 * cmd_tocache() releases the stream then */
+		if (local_error != NULL) {
+			g_clear_error (&local_error);
+			break;
+		}
+	}
+}
+
+/* Reads the responses of the outstanding prefetch commands into the
+ * cache while the caller is busy with the message it got, stepping
+ * aside as soon as anybody else wants to use the engine.  Runs as a
+ * camel operation of its own, thus camel_operation_cancel_all() also
+ * interrupts a download in progress, such as on shutdown. */
+static gpointer
+pop3_folder_prefetch_thread (gpointer user_data)
+{
+	CamelPOP3Folder *pop3_folder = user_data;
+	CamelStore *parent_store;
+	CamelPOP3Engine *pop3_engine;
+	GCancellable *cancellable;
+
+	parent_store = camel_folder_get_parent_store (CAMEL_FOLDER (pop3_folder));
+	pop3_engine = camel_pop3_store_ref_engine (CAMEL_POP3_STORE (parent_store));
+
+	cancellable = camel_operation_new ();
+	camel_operation_push_message (
+		cancellable, _("Downloading messages ahead"));
+
+	while (pop3_engine != NULL &&
+	       !g_cancellable_is_cancelled (cancellable) &&
+	       camel_pop3_engine_busy_trylock (pop3_engine)) {
+		gint ret;
+
+		/* every call reads the complete response of one command,
+		 * failures are seen by whoever waits for the command */
+		ret = camel_pop3_engine_iterate (pop3_engine, NULL, cancellable, NULL);
+
+		camel_pop3_engine_busy_unlock (pop3_engine);
+
+		if (ret <= 0)
+			break;
+	}
+
+	camel_operation_pop_message (cancellable);
+	g_object_unref (cancellable);
+
+	g_clear_object (&pop3_engine);
+
+	g_atomic_int_set (&pop3_folder->prefetch_running, 0);
+	g_object_unref (pop3_folder);
+
+	return NULL;
+}
+
+static void
+pop3_folder_start_prefetch (CamelPOP3Folder *pop3_folder)
+{
+	GThread *thread;
+
+	if (!g_atomic_int_compare_and_exchange (&pop3_folder->prefetch_running, 0, 1))
+		return;
+
+	thread = g_thread_new (NULL, pop3_folder_prefetch_thread, g_object_ref (pop3_folder));
+	g_thread_unref (thread);
+}
+
 static void
 pop3_folder_dispose (GObject *object)
 {
@@ -409,11 +515,12 @@ pop3_folder_get_message_internal_sync (CamelFolder *folder,
 	CamelPOP3Command *pcr;
 	CamelPOP3FolderInfo *fi;
 	gchar buffer[1];
-	gint i, last;
+	gint i;
 	CamelStream *stream = NULL;
 	CamelService *service;
 	CamelSettings *settings;
 	gboolean auto_fetch;
+	guint prefetch_window;
 
 	g_return_val_if_fail (uid != NULL, NULL);
 
@@ -429,6 +536,7 @@ pop3_folder_get_message_internal_sync (CamelFolder *folder,
 	g_object_get (
 		settings,
 		"auto-fetch", &auto_fetch,
+		"prefetch-window", &prefetch_window,
 		NULL);
 
 	g_object_unref (settings);
@@ -513,39 +621,10 @@ pop3_folder_get_message_internal_sync (CamelFolder *folder,
 
 		/* Also initiate retrieval of some of the following
 		 * messages, assume we'll be receiving them. */
-		if (auto_fetch) {
-			/* This should keep track of the last one retrieved,
-			 * also how many are still oustanding incase of random
-			 * access on large folders. */
-			i = fi->index + 1;
-			last = MIN (i + 10, pop3_folder->uids->len);
-			for (; i < last; i++) {
-				CamelPOP3FolderInfo *pfi = pop3_folder->uids->pdata[i];
-
-				if (pfi->uid && pfi->cmd == NULL) {
-					pfi->stream = camel_pop3_store_cache_add (
-						pop3_store, pfi->uid, NULL);
-					if (pfi->stream != NULL) {
-						pfi->cmd = camel_pop3_engine_command_new (
-							pop3_engine,
-							CAMEL_POP3_COMMAND_MULTI,
-							cmd_tocache, pfi,
-							cancellable, &local_error,
-							"RETR %u\r\n", pfi->id);
-
-							if (local_error) {
-								if (pcr)
-									camel_pop3_engine_command_free (pop3_engine, pcr);
-
-								g_propagate_error (error, local_error);
-								g_prefix_error (
-									error, _("Cannot get message %s: "), uid);
-								goto done;
-							}
-					}
-				}
-			}
-		}
+		if (auto_fetch)
+			pop3_folder_prefetch (
+				pop3_folder, pop3_store, pop3_engine,
+				fi->index, prefetch_window, cancellable);
 
 		/* now wait for the first one to finish */
 		while (!local_error && (i = camel_pop3_engine_iterate (pop3_engine, pcr, cancellable, &local_error)) > 0)
@@ -575,6 +654,11 @@ pop3_folder_get_message_internal_sync (CamelFolder *folder,
 				_("Unknown reason"));
 			goto done;
 		}
+	} else if (auto_fetch) {
+		/* keep the window full while the messages are read in order */
+		pop3_folder_prefetch (
+			pop3_folder, pop3_store, pop3_engine,
+			fi->index, prefetch_window, cancellable);
 	}
 
 	message = camel_mime_message_new ();
@@ -588,8 +672,14 @@ pop3_folder_get_message_internal_sync (CamelFolder *folder,
 		camel_medium_add_header (CAMEL_MEDIUM (message), "X-Evolution-POP3-UID", uid);
 	}
 done:
-	if (!already_locked)
+	if (!already_locked) {
+		gboolean outstanding = pop3_engine->current != NULL;
+
 		camel_pop3_engine_busy_unlock (pop3_engine);
+
+		if (auto_fetch && outstanding)
+			pop3_folder_start_prefetch (pop3_folder);
+	}
 	g_clear_object (&stream);
 fail:
 	g_clear_object (&pop3_engine);
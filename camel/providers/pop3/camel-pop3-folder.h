@@ -65,6 +65,9 @@ struct _CamelPOP3Folder {
 	CamelFetchType fetch_type;
 	gint first_id;
 	gint latest_id;
+
+	/* set while a thread downloads ahead, see pop3_folder_start_prefetch() */
+	volatile gint prefetch_running;
 };
 
 struct _CamelPOP3FolderClass {
@@ -27,6 +27,7 @@ struct _CamelPOP3SettingsPrivate {
 	gboolean disable_extensions;
 	gboolean keep_on_server;
 	gboolean auto_fetch;
+	guint prefetch_window;
 };
 
 enum {
@@ -40,7 +41,8 @@ enum {
 	PROP_PORT,
 	PROP_SECURITY_METHOD,
 	PROP_USER,
-	PROP_AUTO_FETCH
+	PROP_AUTO_FETCH,
+	PROP_PREFETCH_WINDOW
 };
 
 G_DEFINE_TYPE_WITH_CODE (
@@ -116,6 +118,12 @@ pop3_settings_set_property (GObject *object,
 				CAMEL_POP3_SETTINGS (object),
 				g_value_get_boolean (value));
 			return;
+
+		case PROP_PREFETCH_WINDOW:
+			camel_pop3_settings_set_prefetch_window (
+				CAMEL_POP3_SETTINGS (object),
+				g_value_get_uint (value));
+			return;
 	}
 
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -197,6 +205,13 @@ pop3_settings_get_property (GObject *object,
 				camel_pop3_settings_get_auto_fetch (
 				CAMEL_POP3_SETTINGS (object)));
 			return;
+
+		case PROP_PREFETCH_WINDOW:
+			g_value_set_uint (
+				value,
+				camel_pop3_settings_get_prefetch_window (
+				CAMEL_POP3_SETTINGS (object)));
+			return;
 	}
 
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -289,6 +304,20 @@ camel_pop3_settings_class_init (CamelPOP3SettingsClass *class)
 			G_PARAM_CONSTRUCT |
 			G_PARAM_STATIC_STRINGS));
 
+	g_object_class_install_property (
+		object_class,
+		PROP_PREFETCH_WINDOW,
+		g_param_spec_uint (
+			"prefetch-window",
+			"Prefetch Window",
+			"How many following messages to keep downloading ahead when auto-fetch is on",
+			1,
+			100,
+			10,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
 	/* Inherited from CamelNetworkSettings. */
 	g_object_class_override_property (
 		object_class,
@@ -541,3 +570,47 @@ camel_pop3_settings_set_auto_fetch (CamelPOP3Settings *settings,
 	g_object_notify (G_OBJECT (settings), "auto-fetch");
 }
 
+/**
+ * camel_pop3_settings_get_prefetch_window:
+ * @settings: a #CamelPOP3Settings
+ *
+ * Returns how many of the following messages are kept being downloaded
+ * in the background when a message is retrieved and
+ * #CamelPOP3Settings:auto-fetch is set.
+ *
+ * Returns: the number of messages to download ahead
+ *
+ * Since: 3.20
+ **/
+guint
+camel_pop3_settings_get_prefetch_window (CamelPOP3Settings *settings)
+{
+	g_return_val_if_fail (CAMEL_IS_POP3_SETTINGS (settings), 0);
+
+	return settings->priv->prefetch_window;
+}
+
+/**
+ * camel_pop3_settings_set_prefetch_window:
+ * @settings: a #CamelPOP3Settings
+ * @prefetch_window: the number of messages to download ahead
+ *
+ * Sets how many of the following messages are kept being downloaded
+ * in the background when a message is retrieved and
+ * #CamelPOP3Settings:auto-fetch is set.
+ *
+ * Since: 3.20
+ **/
+void
+camel_pop3_settings_set_prefetch_window (CamelPOP3Settings *settings,
+                                         guint prefetch_window)
+{
+	g_return_if_fail (CAMEL_IS_POP3_SETTINGS (settings));
+
+	if (settings->priv->prefetch_window == prefetch_window)
+		return;
+
+	settings->priv->prefetch_window = prefetch_window;
+
+	g_object_notify (G_OBJECT (settings), "prefetch-window");
+}
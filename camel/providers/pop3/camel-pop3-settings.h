@@ -80,6 +80,11 @@ gboolean	camel_pop3_settings_get_auto_fetch
 void		camel_pop3_settings_set_auto_fetch
 						(CamelPOP3Settings *settings,
 						 gboolean auto_fetch);
+guint		camel_pop3_settings_get_prefetch_window
+						(CamelPOP3Settings *settings);
+void		camel_pop3_settings_set_prefetch_window
+						(CamelPOP3Settings *settings,
+						 guint prefetch_window);
 
 G_END_DECLS
 
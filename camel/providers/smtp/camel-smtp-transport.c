@@ -58,6 +58,12 @@
 /* set if we are using authtypes from a broken AUTH= */
 #define CAMEL_SMTP_TRANSPORT_AUTH_EQUAL             (1 << 4)
 
+#define CAMEL_SMTP_TRANSPORT_PIPELINING             (1 << 5)
+#define CAMEL_SMTP_TRANSPORT_CHUNKING               (1 << 6)
+
+/* how much of the message each BDAT command carries */
+#define SMTP_BDAT_CHUNK_SIZE (128 * 1024)
+
 enum {
 	PROP_0,
 	PROP_CONNECTABLE,
@@ -94,12 +100,26 @@ static gboolean		smtp_rcpt		(CamelSmtpTransport *transport,
 						 const gchar *recipient,
 						 GCancellable *cancellable,
 						 GError **error);
+static gboolean		smtp_envelope_pipelined	(CamelSmtpTransport *transport,
+						 CamelStreamBuffer *istream,
+						 CamelStream *ostream,
+						 const gchar *sender,
+						 gboolean has_8bit_parts,
+						 GPtrArray *recipients,
+						 GCancellable *cancellable,
+						 GError **error);
 static gboolean		smtp_data		(CamelSmtpTransport *transport,
 						 CamelStreamBuffer *istream,
 						 CamelStream *ostream,
 						 CamelMimeMessage *message,
 						 GCancellable *cancellable,
 						 GError **error);
+static gboolean		smtp_bdat		(CamelSmtpTransport *transport,
+						 CamelStreamBuffer *istream,
+						 CamelStream *ostream,
+						 CamelMimeMessage *message,
+						 GCancellable *cancellable,
+						 GError **error);
 static gboolean		smtp_rset		(CamelSmtpTransport *transport,
 						 CamelStreamBuffer *istream,
 						 CamelStream *ostream,
@@ -189,6 +209,7 @@ connect_to_server (CamelService *service,
 	/* set some smtp transport defaults */
 	transport->flags = 0;
 	transport->authtypes = NULL;
+	transport->messages_sent = 0;
 
 	settings = camel_service_ref_settings (service);
 
@@ -870,8 +891,11 @@ smtp_transport_send_to_sync (CamelTransport *transport,
 	CamelInternetAddress *cia;
 	CamelStreamBuffer *istream;
 	CamelStream *ostream;
+	GPtrArray *rcpts;
 	gboolean has_8bit_parts;
+	gboolean success = FALSE;
 	const gchar *addr;
+	gint64 started, envelope_done;
 	gint i, len;
 
 	smtp_debug_print_server_name (CAMEL_SERVICE (transport), "Sending with");
@@ -898,84 +922,107 @@ smtp_transport_send_to_sync (CamelTransport *transport,
 		return FALSE;
 	}
 
-	camel_operation_push_message (cancellable, _("Sending message"));
-
-	/* find out if the message has 8bit mime parts */
-	has_8bit_parts = camel_mime_message_has_8bit_parts (message);
-
-	/* If the connection needs a ReSET, then do so */
-	if (smtp_transport->need_rset &&
-	    !smtp_rset (smtp_transport, istream, ostream, cancellable, error)) {
-		camel_operation_pop_message (cancellable);
-		g_clear_object (&istream);
-		g_clear_object (&ostream);
-		return FALSE;
-	}
-	smtp_transport->need_rset = FALSE;
-
-	/* rfc1652 (8BITMIME) requires that you notify the ESMTP daemon that
-	 * you'll be sending an 8bit mime message at "MAIL FROM:" time. */
-	if (!smtp_mail (
-		smtp_transport, istream, ostream, addr, has_8bit_parts, cancellable, error)) {
-		camel_operation_pop_message (cancellable);
-		g_clear_object (&istream);
-		g_clear_object (&ostream);
-		return FALSE;
-	}
-
+	/* Check the recipients up front, so that nothing needs
+	 * to be undone on the server when one of them is bad. */
 	len = camel_address_length (recipients);
 	if (len == 0) {
+		g_clear_object (&istream);
+		g_clear_object (&ostream);
 		g_set_error (
 			error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
 			_("Cannot send message: no recipients defined."));
-		camel_operation_pop_message (cancellable);
-		smtp_transport->need_rset = TRUE;
-		g_clear_object (&istream);
-		g_clear_object (&ostream);
 		return FALSE;
 	}
 
+	rcpts = g_ptr_array_new_with_free_func (g_free);
+
 	cia = CAMEL_INTERNET_ADDRESS (recipients);
 	for (i = 0; i < len; i++) {
-		gchar *enc;
+		const gchar *rcpt_addr;
 
-		if (!camel_internet_address_get (cia, i, NULL, &addr)) {
+		if (!camel_internet_address_get (cia, i, NULL, &rcpt_addr)) {
+			g_ptr_array_unref (rcpts);
+			g_clear_object (&istream);
+			g_clear_object (&ostream);
 			g_set_error (
 				error, CAMEL_ERROR, CAMEL_ERROR_GENERIC,
 				_("Cannot send message: "
 				"one or more invalid recipients"));
-			camel_operation_pop_message (cancellable);
-			smtp_transport->need_rset = TRUE;
-			g_clear_object (&istream);
-			g_clear_object (&ostream);
 			return FALSE;
 		}
 
-		enc = camel_internet_address_encode_address (NULL, NULL, addr);
-		if (!smtp_rcpt (smtp_transport, istream, ostream, enc, cancellable, error)) {
-			g_free (enc);
-			camel_operation_pop_message (cancellable);
+		g_ptr_array_add (rcpts, camel_internet_address_encode_address (NULL, NULL, rcpt_addr));
+	}
+
+	camel_operation_push_message (cancellable, _("Sending message"));
+
+	started = g_get_monotonic_time ();
+
+	/* find out if the message has 8bit mime parts */
+	has_8bit_parts = camel_mime_message_has_8bit_parts (message);
+
+	/* If the connection needs a ReSET, then do so */
+	if (smtp_transport->need_rset &&
+	    !smtp_rset (smtp_transport, istream, ostream, cancellable, error))
+		goto exit;
+	smtp_transport->need_rset = FALSE;
+
+	if (smtp_transport->flags & CAMEL_SMTP_TRANSPORT_PIPELINING) {
+		/* rfc2920 (PIPELINING) lets us send the whole envelope
+		 * at once and collect the replies afterwards */
+		if (!smtp_envelope_pipelined (
+			smtp_transport, istream, ostream, addr,
+			has_8bit_parts, rcpts, cancellable, error)) {
 			smtp_transport->need_rset = TRUE;
-			g_clear_object (&istream);
-			g_clear_object (&ostream);
-			return FALSE;
+			goto exit;
+		}
+	} else {
+		/* rfc1652 (8BITMIME) requires that you notify the ESMTP daemon that
+		 * you'll be sending an 8bit mime message at "MAIL FROM:" time. */
+		if (!smtp_mail (
+			smtp_transport, istream, ostream, addr, has_8bit_parts, cancellable, error))
+			goto exit;
+
+		for (i = 0; i < rcpts->len; i++) {
+			if (!smtp_rcpt (smtp_transport, istream, ostream, rcpts->pdata[i], cancellable, error)) {
+				smtp_transport->need_rset = TRUE;
+				goto exit;
+			}
 		}
-		g_free (enc);
 	}
 
-	if (!smtp_data (smtp_transport, istream, ostream, message, cancellable, error)) {
-		camel_operation_pop_message (cancellable);
+	envelope_done = g_get_monotonic_time ();
+
+	/* rfc3030 (CHUNKING) sends the message as is, without dot-stuffing */
+	if (smtp_transport->flags & CAMEL_SMTP_TRANSPORT_CHUNKING)
+		success = smtp_bdat (smtp_transport, istream, ostream, message, cancellable, error);
+	else
+		success = smtp_data (smtp_transport, istream, ostream, message, cancellable, error);
+
+	if (!success) {
 		smtp_transport->need_rset = TRUE;
-		g_clear_object (&istream);
-		g_clear_object (&ostream);
-		return FALSE;
+		goto exit;
 	}
 
+	d (fprintf (
+		stderr, "[SMTP] message %u on this connection sent in %" G_GINT64_FORMAT " ms: "
+		"envelope %" G_GINT64_FORMAT " ms (%u recipients%s), %s %" G_GINT64_FORMAT " ms\n",
+		smtp_transport->messages_sent + 1,
+		(g_get_monotonic_time () - started) / 1000,
+		(envelope_done - started) / 1000, rcpts->len,
+		(smtp_transport->flags & CAMEL_SMTP_TRANSPORT_PIPELINING) ? ", pipelined" : "",
+		(smtp_transport->flags & CAMEL_SMTP_TRANSPORT_CHUNKING) ? "BDAT" : "DATA",
+		(g_get_monotonic_time () - envelope_done) / 1000));
+
+	smtp_transport->messages_sent++;
+
+ exit:
 	camel_operation_pop_message (cancellable);
+	g_ptr_array_unref (rcpts);
 	g_clear_object (&istream);
 	g_clear_object (&ostream);
 
-	return TRUE;
+	return success;
 }
 
 static const gchar *
@@ -1374,7 +1421,9 @@ smtp_helo (CamelSmtpTransport *transport,
 	 * are being called a second time (ie, after a STARTTLS) */
 	transport->flags &= ~(CAMEL_SMTP_TRANSPORT_8BITMIME |
 			      CAMEL_SMTP_TRANSPORT_ENHANCEDSTATUSCODES |
-			      CAMEL_SMTP_TRANSPORT_STARTTLS);
+			      CAMEL_SMTP_TRANSPORT_STARTTLS |
+			      CAMEL_SMTP_TRANSPORT_PIPELINING |
+			      CAMEL_SMTP_TRANSPORT_CHUNKING);
 
 	if (transport->authtypes) {
 		g_hash_table_foreach (transport->authtypes, authtypes_free, NULL);
@@ -1456,6 +1505,10 @@ smtp_helo (CamelSmtpTransport *transport,
 				transport->flags |= CAMEL_SMTP_TRANSPORT_ENHANCEDSTATUSCODES;
 			} else if (!g_ascii_strncasecmp (token, "STARTTLS", 8)) {
 				transport->flags |= CAMEL_SMTP_TRANSPORT_STARTTLS;
+			} else if (!g_ascii_strncasecmp (token, "PIPELINING", 10)) {
+				transport->flags |= CAMEL_SMTP_TRANSPORT_PIPELINING;
+			} else if (!g_ascii_strncasecmp (token, "CHUNKING", 8)) {
+				transport->flags |= CAMEL_SMTP_TRANSPORT_CHUNKING;
 			} else if (!g_ascii_strncasecmp (token, "AUTH", 4)) {
 				if (!transport->authtypes || transport->flags & CAMEL_SMTP_TRANSPORT_AUTH_EQUAL) {
 					/* Don't bother parsing any authtypes if we already have a list.
@@ -1604,6 +1657,102 @@ smtp_rcpt (CamelSmtpTransport *transport,
 	return TRUE;
 }
 
+/* Reads a whole, possibly multi-line, reply and returns its last line */
+static gchar *
+smtp_read_reply (CamelStreamBuffer *istream,
+                 GCancellable *cancellable,
+                 GError **error)
+{
+	gchar *respbuf = NULL;
+
+	do {
+		g_free (respbuf);
+		respbuf = camel_stream_buffer_read_line (istream, cancellable, error);
+		d (fprintf (stderr, "[SMTP] received: %s\n", respbuf ? respbuf : "(null)"));
+	} while (respbuf != NULL && strlen (respbuf) > 3 && respbuf[3] == '-');
+
+	return respbuf;
+}
+
+static gboolean
+smtp_envelope_pipelined (CamelSmtpTransport *transport,
+                         CamelStreamBuffer *istream,
+                         CamelStream *ostream,
+                         const gchar *sender,
+                         gboolean has_8bit_parts,
+                         GPtrArray *recipients,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	GString *cmdbuf;
+	GError *local_error = NULL;
+	gchar *respbuf;
+	guint ii;
+
+	/* DATA is deliberately not part of the batch: should some
+	 * recipient be refused, we would have to send an empty message
+	 * to the others just to get out of the data state again. */
+	cmdbuf = g_string_new ("");
+
+	if (transport->flags & CAMEL_SMTP_TRANSPORT_8BITMIME && has_8bit_parts)
+		g_string_append_printf (cmdbuf, "MAIL FROM:<%s> BODY=8BITMIME\r\n", sender);
+	else
+		g_string_append_printf (cmdbuf, "MAIL FROM:<%s>\r\n", sender);
+
+	for (ii = 0; ii < recipients->len; ii++)
+		g_string_append_printf (cmdbuf, "RCPT TO:<%s>\r\n", (const gchar *) recipients->pdata[ii]);
+
+	d (fprintf (stderr, "[SMTP] sending: %s", cmdbuf->str));
+
+	if (camel_stream_write (ostream, cmdbuf->str, cmdbuf->len, cancellable, error) == -1) {
+		g_string_free (cmdbuf, TRUE);
+		g_prefix_error (error, _("MAIL FROM command failed: "));
+		camel_service_disconnect_sync (
+			CAMEL_SERVICE (transport),
+			FALSE, cancellable, NULL);
+		return FALSE;
+	}
+	g_string_free (cmdbuf, TRUE);
+
+	/* Every command gets its reply, in order; read all of them
+	 * even after a failure to stay in sync with the server. */
+	for (ii = 0; ii <= recipients->len; ii++) {
+		respbuf = smtp_read_reply (istream, cancellable, error);
+		if (respbuf == NULL) {
+			g_clear_error (&local_error);
+			if (ii == 0)
+				g_prefix_error (error, _("MAIL FROM command failed: "));
+			else
+				g_prefix_error (
+					error, _("RCPT TO <%s> failed: "),
+					(const gchar *) recipients->pdata[ii - 1]);
+			camel_service_disconnect_sync (
+				CAMEL_SERVICE (transport),
+				FALSE, cancellable, NULL);
+			return FALSE;
+		}
+
+		if (strncmp (respbuf, "250", 3) != 0 && local_error == NULL) {
+			smtp_set_error (transport, istream, respbuf, cancellable, &local_error);
+			if (ii == 0)
+				g_prefix_error (&local_error, _("MAIL FROM command failed: "));
+			else
+				g_prefix_error (
+					&local_error, _("RCPT TO <%s> failed: "),
+					(const gchar *) recipients->pdata[ii - 1]);
+		}
+
+		g_free (respbuf);
+	}
+
+	if (local_error != NULL) {
+		g_propagate_error (error, local_error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 static void
 smtp_maybe_update_socket_timeout (CamelStream *strm,
 				  gint timeout_seconds)
@@ -1632,6 +1781,47 @@ smtp_maybe_update_socket_timeout (CamelStream *strm,
 	g_clear_object (&base_strm);
 }
 
+/* Takes the Bcc headers out of @message, to be put back
+ * by smtp_restore_bcc_headers() once the message is sent */
+static CamelHeaderRaw *
+smtp_unlink_bcc_headers (CamelMimeMessage *message)
+{
+	CamelHeaderRaw *header, *savedbcc, *n, *tail;
+
+	savedbcc = NULL;
+	tail = (CamelHeaderRaw *) &savedbcc;
+
+	header = (CamelHeaderRaw *) &CAMEL_MIME_PART (message)->headers;
+	n = header->next;
+	while (n != NULL) {
+		if (!g_ascii_strcasecmp (n->name, "Bcc")) {
+			header->next = n->next;
+			tail->next = n;
+			n->next = NULL;
+			tail = n;
+		} else {
+			header = n;
+		}
+
+		n = header->next;
+	}
+
+	return savedbcc;
+}
+
+static void
+smtp_restore_bcc_headers (CamelMimeMessage *message,
+                          CamelHeaderRaw *savedbcc)
+{
+	CamelHeaderRaw *header;
+
+	header = (CamelHeaderRaw *) &CAMEL_MIME_PART (message)->headers;
+	while (header->next != NULL)
+		header = header->next;
+
+	header->next = savedbcc;
+}
+
 static gboolean
 smtp_data (CamelSmtpTransport *transport,
 	   CamelStreamBuffer *istream,
@@ -1640,7 +1830,7 @@ smtp_data (CamelSmtpTransport *transport,
            GCancellable *cancellable,
            GError **error)
 {
-	CamelHeaderRaw *header, *savedbcc, *n, *tail;
+	CamelHeaderRaw *savedbcc;
 	CamelBestencEncoding enctype = CAMEL_BESTENC_8BIT;
 	CamelStream *filtered_stream;
 	gchar *cmdbuf, *respbuf = NULL;
@@ -1695,24 +1885,7 @@ smtp_data (CamelSmtpTransport *transport,
 	g_free (respbuf);
 	respbuf = NULL;
 
-	/* unlink the bcc headers */
-	savedbcc = NULL;
-	tail = (CamelHeaderRaw *) &savedbcc;
-
-	header = (CamelHeaderRaw *) &CAMEL_MIME_PART (message)->headers;
-	n = header->next;
-	while (n != NULL) {
-		if (!g_ascii_strcasecmp (n->name, "Bcc")) {
-			header->next = n->next;
-			tail->next = n;
-			n->next = NULL;
-			tail = n;
-		} else {
-			header = n;
-		}
-
-		n = header->next;
-	}
+	savedbcc = smtp_unlink_bcc_headers (message);
 
 	/* find out how large the message is... */
 	null = CAMEL_STREAM_NULL (camel_stream_null_new ());
@@ -1745,8 +1918,7 @@ smtp_data (CamelSmtpTransport *transport,
 		CAMEL_DATA_WRAPPER (message),
 		filtered_stream, cancellable, error);
 
-	/* restore the bcc headers */
-	header->next = savedbcc;
+	smtp_restore_bcc_headers (message, savedbcc);
 
 	if (ret == -1) {
 		g_prefix_error (error, _("DATA command failed: "));
@@ -1798,6 +1970,270 @@ smtp_data (CamelSmtpTransport *transport,
 	return TRUE;
 }
 
+/* A stream sending what is written to it as BDAT chunks, thus
+ * no more than one chunk of the message is held in memory */
+typedef struct _SmtpBdatStream SmtpBdatStream;
+typedef struct _SmtpBdatStreamClass SmtpBdatStreamClass;
+
+struct _SmtpBdatStream {
+	CamelStream parent;
+
+	CamelSmtpTransport *transport;
+	CamelStreamBuffer *istream;
+	CamelStream *ostream;
+
+	gchar *chunk;
+	gsize chunk_len;
+	guint n_pending;
+
+	goffset sent;
+	goffset total;
+
+	/* the first refused chunk */
+	GError *reply_error;
+};
+
+struct _SmtpBdatStreamClass {
+	CamelStreamClass parent_class;
+};
+
+static GType smtp_bdat_stream_get_type (void);
+
+G_DEFINE_TYPE (SmtpBdatStream, smtp_bdat_stream, CAMEL_TYPE_STREAM)
+
+static gboolean
+smtp_bdat_stream_send_chunk (SmtpBdatStream *bdat,
+                             gboolean last,
+                             GCancellable *cancellable,
+                             GError **error)
+{
+	gchar *cmdbuf, *respbuf;
+
+	cmdbuf = g_strdup_printf (
+		"BDAT %" G_GSIZE_FORMAT "%s\r\n",
+		bdat->chunk_len, last ? " LAST" : "");
+
+	d (fprintf (stderr, "[SMTP] sending: %s", cmdbuf));
+
+	if (camel_stream_write_string (bdat->ostream, cmdbuf, cancellable, error) == -1 ||
+	    camel_stream_write (bdat->ostream, bdat->chunk, bdat->chunk_len, cancellable, error) == -1) {
+		g_free (cmdbuf);
+		return FALSE;
+	}
+	g_free (cmdbuf);
+
+	bdat->sent += bdat->chunk_len;
+	bdat->chunk_len = 0;
+	bdat->n_pending++;
+
+	if (bdat->total > 0)
+		camel_operation_progress (
+			cancellable, (gint) (MIN (bdat->sent, bdat->total) * 100 / bdat->total));
+
+	/* Without PIPELINING each chunk has to be acknowledged before
+	 * the next one is sent, otherwise the replies are read at the end. */
+	while (bdat->n_pending > 0 && (last || !(bdat->transport->flags & CAMEL_SMTP_TRANSPORT_PIPELINING))) {
+		respbuf = smtp_read_reply (bdat->istream, cancellable, error);
+		if (respbuf == NULL)
+			return FALSE;
+
+		if (strncmp (respbuf, "250", 3) != 0 && bdat->reply_error == NULL)
+			smtp_set_error (
+				bdat->transport, bdat->istream, respbuf,
+				cancellable, &bdat->reply_error);
+
+		g_free (respbuf);
+		bdat->n_pending--;
+	}
+
+	return TRUE;
+}
+
+static gssize
+smtp_bdat_stream_write (CamelStream *stream,
+                        const gchar *buffer,
+                        gsize n,
+                        GCancellable *cancellable,
+                        GError **error)
+{
+	SmtpBdatStream *bdat = (SmtpBdatStream *) stream;
+	gsize done = 0;
+
+	while (done < n) {
+		gsize len;
+
+		/* the server discarded the transaction already */
+		if (bdat->reply_error != NULL) {
+			g_propagate_error (error, g_error_copy (bdat->reply_error));
+			return -1;
+		}
+
+		/* A full chunk goes out only once more data follows,
+		 * the last one is sent by smtp_bdat_stream_finish() */
+		if (bdat->chunk_len == SMTP_BDAT_CHUNK_SIZE &&
+		    !smtp_bdat_stream_send_chunk (bdat, FALSE, cancellable, error))
+			return -1;
+
+		len = MIN (n - done, SMTP_BDAT_CHUNK_SIZE - bdat->chunk_len);
+		memcpy (bdat->chunk + bdat->chunk_len, buffer + done, len);
+		bdat->chunk_len += len;
+		done += len;
+	}
+
+	return n;
+}
+
+static void
+smtp_bdat_stream_finalize (GObject *object)
+{
+	SmtpBdatStream *bdat = (SmtpBdatStream *) object;
+
+	g_object_unref (bdat->transport);
+	g_object_unref (bdat->istream);
+	g_object_unref (bdat->ostream);
+	g_free (bdat->chunk);
+	g_clear_error (&bdat->reply_error);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (smtp_bdat_stream_parent_class)->finalize (object);
+}
+
+static void
+smtp_bdat_stream_class_init (SmtpBdatStreamClass *class)
+{
+	GObjectClass *object_class;
+	CamelStreamClass *stream_class;
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->finalize = smtp_bdat_stream_finalize;
+
+	stream_class = CAMEL_STREAM_CLASS (class);
+	stream_class->write = smtp_bdat_stream_write;
+}
+
+static void
+smtp_bdat_stream_init (SmtpBdatStream *bdat)
+{
+	bdat->chunk = g_malloc (SMTP_BDAT_CHUNK_SIZE);
+}
+
+static SmtpBdatStream *
+smtp_bdat_stream_new (CamelSmtpTransport *transport,
+                      CamelStreamBuffer *istream,
+                      CamelStream *ostream,
+                      goffset total)
+{
+	SmtpBdatStream *bdat;
+
+	bdat = g_object_new (smtp_bdat_stream_get_type (), NULL);
+	bdat->transport = g_object_ref (transport);
+	bdat->istream = g_object_ref (istream);
+	bdat->ostream = g_object_ref (ostream);
+	bdat->total = total;
+
+	return bdat;
+}
+
+/* Sends what is left as the LAST chunk and collects the pending replies */
+static gboolean
+smtp_bdat_stream_finish (SmtpBdatStream *bdat,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	/* Once a chunk is refused nothing is pending anymore: either
+	 * it was the LAST one, or each chunk is acknowledged in turn */
+	if (bdat->reply_error == NULL &&
+	    !smtp_bdat_stream_send_chunk (bdat, TRUE, cancellable, error))
+		return FALSE;
+
+	if (bdat->reply_error != NULL) {
+		g_propagate_error (error, g_error_copy (bdat->reply_error));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+smtp_bdat (CamelSmtpTransport *transport,
+	   CamelStreamBuffer *istream,
+	   CamelStream *ostream,
+           CamelMimeMessage *message,
+           GCancellable *cancellable,
+           GError **error)
+{
+	CamelHeaderRaw *savedbcc;
+	CamelBestencEncoding enctype = CAMEL_BESTENC_8BIT;
+	CamelStream *filtered_stream;
+	CamelMimeFilter *filter;
+	CamelStreamNull *null;
+	SmtpBdatStream *bdat;
+	gint ret;
+
+	/* If the server doesn't support 8BITMIME, set our required encoding to be 7bit */
+	if (!(transport->flags & CAMEL_SMTP_TRANSPORT_8BITMIME))
+		enctype = CAMEL_BESTENC_7BIT;
+
+	camel_mime_message_set_best_encoding (
+		message, CAMEL_BESTENC_GET_ENCODING, enctype);
+
+	savedbcc = smtp_unlink_bcc_headers (message);
+
+	/* find out how large the message is... */
+	null = CAMEL_STREAM_NULL (camel_stream_null_new ());
+	camel_data_wrapper_write_to_stream_sync (
+		CAMEL_DATA_WRAPPER (message),
+		CAMEL_STREAM (null), NULL, NULL);
+
+	/* Set the upload timeout to an equal of 512 bytes per second */
+	smtp_maybe_update_socket_timeout (ostream, null->written / 512);
+
+	/* Only the size of each chunk has to be known up front,
+	 * thus the message is converted as it is being sent */
+	bdat = smtp_bdat_stream_new (transport, istream, ostream, null->written);
+	g_object_unref (null);
+
+	filtered_stream = camel_stream_filter_new (CAMEL_STREAM (bdat));
+
+	/* setup LF->CRLF conversion; no dot-stuffing with BDAT */
+	filter = camel_mime_filter_crlf_new (
+		CAMEL_MIME_FILTER_CRLF_ENCODE,
+		CAMEL_MIME_FILTER_CRLF_MODE_CRLF_ONLY);
+	camel_stream_filter_add (
+		CAMEL_STREAM_FILTER (filtered_stream), filter);
+	g_object_unref (filter);
+
+	ret = camel_data_wrapper_write_to_stream_sync (
+		CAMEL_DATA_WRAPPER (message),
+		filtered_stream, cancellable, error);
+	if (ret != -1)
+		ret = camel_stream_flush (filtered_stream, cancellable, error);
+	if (ret != -1 && !smtp_bdat_stream_finish (bdat, cancellable, error))
+		ret = -1;
+
+	g_object_unref (filtered_stream);
+
+	smtp_restore_bcc_headers (message, savedbcc);
+
+	if (ret == -1) {
+		g_prefix_error (error, _("BDAT command failed: "));
+
+		/* a refused chunk leaves the connection usable */
+		if (bdat->reply_error == NULL)
+			camel_service_disconnect_sync (
+				CAMEL_SERVICE (transport),
+				FALSE, cancellable, NULL);
+
+		g_object_unref (bdat);
+
+		return FALSE;
+	}
+
+	g_object_unref (bdat);
+
+	return TRUE;
+}
+
 static gboolean
 smtp_rset (CamelSmtpTransport *transport,
 	   CamelStreamBuffer *istream,
@@ -60,6 +60,9 @@ struct _CamelSmtpTransport {
 	gboolean need_rset;
 	gboolean connected;
 
+	/* how many messages went through the current connection */
+	guint messages_sent;
+
 	GHashTable *authtypes;
 };
 
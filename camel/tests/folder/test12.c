@@ -0,0 +1,182 @@
+/*
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* batched flag changes */
+
+#include <string.h>
+
+#include "camel-test.h"
+#include "camel-test-provider.h"
+#include "messages.h"
+#include "folders.h"
+#include "session.h"
+
+#define N_MESSAGES (10)
+
+static const gchar *local_drivers[] = { "local" };
+
+static const gchar *stores[] = {
+	"mbox:///tmp/camel-test/mbox",
+	"mh:///tmp/camel-test/mh",
+	"maildir:///tmp/camel-test/maildir"
+};
+
+typedef struct {
+	gint n_changed;
+	gint n_changed_uids;
+	gint n_unread_notify;
+} Emissions;
+
+static void
+folder_changed_cb (CamelFolder *folder,
+                   CamelFolderChangeInfo *changes,
+                   Emissions *emissions)
+{
+	emissions->n_changed++;
+	emissions->n_changed_uids += changes->uid_changed->len;
+}
+
+static void
+unread_count_notify_cb (GObject *object,
+                        GParamSpec *pspec,
+                        Emissions *emissions)
+{
+	emissions->n_unread_notify++;
+}
+
+static void
+test_flags_many (CamelSession *session,
+                 const gchar *name)
+{
+	CamelStore *store;
+	CamelService *service;
+	CamelFolder *folder;
+	Emissions emissions = { 0, };
+	GPtrArray *uids;
+	gulong changed_id, notify_id;
+	guint n_changed;
+	gint ii;
+	GError *error = NULL;
+
+	push ("getting store");
+	service = camel_session_add_service (
+		session, name, name, CAMEL_PROVIDER_STORE, &error);
+	check_msg (error == NULL, "adding store: %s", error->message);
+	check (CAMEL_IS_STORE (service));
+	store = CAMEL_STORE (service);
+	g_clear_error (&error);
+	pull ();
+
+	push ("creating folder");
+	folder = camel_store_get_folder_sync (
+		store, "testbox", CAMEL_STORE_FOLDER_CREATE, NULL, &error);
+	check_msg (error == NULL, "%s", error->message);
+	check (folder != NULL);
+	pull ();
+
+	push ("appending messages");
+	for (ii = 0; ii < N_MESSAGES; ii++) {
+		CamelMimeMessage *msg;
+		gchar *content;
+
+		msg = test_message_create_simple ();
+		content = g_strdup_printf ("Test message %d contents\n\n", ii);
+		test_message_set_content_simple (
+			(CamelMimePart *) msg, 0, "text/plain",
+			content, strlen (content));
+		test_free (content);
+
+		camel_folder_append_message_sync (
+			folder, msg, NULL, NULL, NULL, &error);
+		check_msg (error == NULL, "%s", error->message);
+
+		check_unref (msg, 1);
+	}
+	test_folder_counts (folder, N_MESSAGES, N_MESSAGES);
+	pull ();
+
+	/* let the change notifications of the appends go out first */
+	while (g_main_context_iteration (NULL, FALSE))
+		;
+
+	changed_id = g_signal_connect (
+		folder, "changed",
+		G_CALLBACK (folder_changed_cb), &emissions);
+	notify_id = g_signal_connect (
+		folder->summary, "notify::unread-count",
+		G_CALLBACK (unread_count_notify_cb), &emissions);
+
+	push ("marking all messages seen at once");
+	uids = camel_folder_get_uids (folder);
+	check (uids != NULL && uids->len == N_MESSAGES);
+
+	n_changed = camel_folder_set_message_flags_many (
+		folder, uids, CAMEL_MESSAGE_SEEN, CAMEL_MESSAGE_SEEN);
+	check_msg (n_changed == N_MESSAGES, "%u messages changed", n_changed);
+
+	check_msg (
+		emissions.n_unread_notify == 1,
+		"unread-count notified %d times", emissions.n_unread_notify);
+
+	while (g_main_context_iteration (NULL, FALSE))
+		;
+
+	check_msg (
+		emissions.n_changed == 1,
+		"changed emitted %d times", emissions.n_changed);
+	check_msg (
+		emissions.n_changed_uids == N_MESSAGES,
+		"%d uids in the change info", emissions.n_changed_uids);
+
+	test_folder_counts (folder, N_MESSAGES, 0);
+	camel_folder_free_uids (folder, uids);
+	pull ();
+
+	g_signal_handler_disconnect (folder->summary, notify_id);
+	g_signal_handler_disconnect (folder, changed_id);
+
+	check_unref (folder, 1);
+	check_unref (store, 1);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	CamelSession *session;
+	gint i;
+
+	camel_test_init (argc, argv);
+	camel_test_provider_init (1, local_drivers);
+
+	/* clear out any camel-test data */
+	system ("/bin/rm -rf /tmp/camel-test");
+
+	session = camel_test_session_new ("/tmp/camel-test");
+
+	for (i = 0; i < G_N_ELEMENTS (stores); i++) {
+		gchar *what = g_strdup_printf ("batched flag changes: %s", stores[i]);
+
+		camel_test_start (what);
+		test_free (what);
+
+		test_flags_many (session, stores[i]);
+
+		camel_test_end ();
+	}
+
+	check_unref (session, 1);
+
+	return 0;
+}
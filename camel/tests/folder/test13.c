@@ -0,0 +1,197 @@
+/*
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* filter rules decided from the message info */
+
+#include <string.h>
+
+#include "camel-test.h"
+#include "camel-test-provider.h"
+#include "messages.h"
+#include "folders.h"
+#include "session.h"
+
+#define N_MESSAGES (6)
+
+static const gchar *local_drivers[] = { "local" };
+
+struct {
+	const gchar *name;
+	CamelFolder *folder;
+} mailboxes[] = {
+	{ "INBOX", NULL },
+	{ "lists", NULL },
+	{ "urgent", NULL },
+	{ "both", NULL },
+};
+
+/* as EFilterRule builds them, with "all" and "any" grouping */
+struct {
+	const gchar *name, *match, *action;
+} rules[] = {
+	{ "list",
+	  " (match-all  (and\n  (match-all (header-matches \"x-camel-mlist\" \"devel@lists.example.com\"))\n)\n )\n",
+	  "(copy-to \"lists\")" },
+	{ "subject",
+	  " (or\n  (match-all (header-contains \"Subject\" \"urgent\"))\n)\n",
+	  "(copy-to \"urgent\")" },
+	/* two parts, thus evaluated as a whole */
+	{ "both",
+	  " (and\n  (match-all (header-contains \"Subject\" \"urgent\"))\n  (match-all (header-contains \"Subject\" \"list\"))\n)\n",
+	  "(copy-to \"both\")" }
+};
+
+static CamelFolder *
+get_folder (CamelFilterDriver *d,
+            const gchar *uri,
+            gpointer data,
+            GError **error)
+{
+	gint i;
+
+	for (i = 0; i < G_N_ELEMENTS (mailboxes); i++)
+		if (!strcmp (mailboxes[i].name, uri)) {
+			return g_object_ref (mailboxes[i].folder);
+		}
+	return NULL;
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	CamelService *service;
+	CamelSession *session;
+	CamelStore *store;
+	CamelFolder *folder;
+	CamelFilterDriver *driver;
+	GPtrArray *uids;
+	guint64 evaluated = 0, skipped = 0;
+	gint i;
+	GError *error = NULL;
+
+	camel_test_init (argc, argv);
+	camel_test_provider_init (1, local_drivers);
+
+	/* clear out any camel-test data */
+	system ("/bin/rm -rf /tmp/camel-test");
+
+	camel_test_start ("Filter rules decided from the message info");
+
+	session = camel_test_session_new ("/tmp/camel-test");
+
+	push ("getting store");
+	service = camel_session_add_service (
+		session, "test-uid", "mbox:///tmp/camel-test/mbox",
+		CAMEL_PROVIDER_STORE, &error);
+	check_msg (error == NULL, "getting store: %s", error->message);
+	check (CAMEL_IS_STORE (service));
+	store = CAMEL_STORE (service);
+	g_clear_error (&error);
+	pull ();
+
+	push ("creating folders");
+	for (i = 0; i < G_N_ELEMENTS (mailboxes); i++) {
+		mailboxes[i].folder = folder = camel_store_get_folder_sync (
+			store, mailboxes[i].name,
+			CAMEL_STORE_FOLDER_CREATE, NULL, &error);
+		check_msg (error == NULL, "%s", error->message);
+		check (folder != NULL);
+		test_folder_counts (folder, 0, 0);
+		g_clear_error (&error);
+	}
+	pull ();
+
+	/* Of every three messages, the first and the last are posted
+	 * to the list, and the last two have an urgent subject */
+	push ("appending messages");
+	folder = mailboxes[0].folder;
+	for (i = 0; i < N_MESSAGES; i++) {
+		CamelMimeMessage *msg;
+		gchar *subject;
+		gboolean list = (i % 3) != 1;
+		gboolean urgent = (i % 3) != 0;
+
+		msg = test_message_create_simple ();
+		test_message_set_content_simple (
+			(CamelMimePart *) msg, 0, "text/plain",
+			"Test message contents\n\n", 23);
+
+		subject = g_strdup_printf (
+			"%s%smessage %d", urgent ? "urgent " : "",
+			list ? "list " : "", i);
+		camel_mime_message_set_subject (msg, subject);
+		test_free (subject);
+
+		if (list)
+			camel_medium_set_header (
+				CAMEL_MEDIUM (msg), "List-Post",
+				"<mailto:devel@lists.example.com>");
+
+		camel_folder_append_message_sync (
+			folder, msg, NULL, NULL, NULL, &error);
+		check_msg (error == NULL, "%s", error->message);
+
+		check_unref (msg, 1);
+	}
+	test_folder_counts (folder, N_MESSAGES, N_MESSAGES);
+	pull ();
+
+	push ("building filters");
+	driver = camel_filter_driver_new (session);
+	camel_filter_driver_set_folder_func (driver, get_folder, NULL);
+	for (i = 0; i < G_N_ELEMENTS (rules); i++)
+		camel_filter_driver_add_rule (driver, rules[i].name, rules[i].match, rules[i].action);
+	pull ();
+
+	push ("executing filters");
+	uids = camel_folder_get_uids (folder);
+	check (uids != NULL && uids->len == N_MESSAGES);
+
+	camel_filter_driver_filter_folder (
+		driver, folder, NULL, uids, FALSE, NULL, &error);
+	check_msg (error == NULL, "%s", error->message);
+	camel_filter_driver_flush (driver, &error);
+	check_msg (error == NULL, "%s", error->message);
+
+	camel_folder_free_uids (folder, uids);
+	pull ();
+
+	push ("checking results");
+	test_folder_counts (mailboxes[1].folder, 4, 4);
+	test_folder_counts (mailboxes[2].folder, 4, 4);
+	test_folder_counts (mailboxes[3].folder, 2, 2);
+
+	/* only the rule with two parts needs the search expression */
+	camel_filter_driver_get_rule_stats (driver, &evaluated, &skipped);
+	check_msg (
+		evaluated == N_MESSAGES,
+		"%" G_GUINT64_FORMAT " rules evaluated", evaluated);
+	check_msg (
+		skipped == 2 * N_MESSAGES,
+		"%" G_GUINT64_FORMAT " rules skipped", skipped);
+	pull ();
+
+	check_unref (driver, 1);
+
+	for (i = 0; i < G_N_ELEMENTS (mailboxes); i++)
+		check_unref (mailboxes[i].folder, 1);
+
+	check_unref (store, 1);
+	check_unref (session, 1);
+
+	camel_test_end ();
+
+	return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "camel-test.h"
+
+#define CACHE_PATH "/tmp/camel-test/data-cache"
+#define ITEM_SIZE (1000)
+#define LARGE_ITEM_SIZE (300 * 1024 + 17)
+
+static void
+add_item (CamelDataCache *cdc,
+          const gchar *key)
+{
+	GIOStream *stream;
+	GOutputStream *output_stream;
+	gchar buffer[ITEM_SIZE];
+	gsize n_written = 0;
+	GError *error = NULL;
+
+	memset (buffer, key[0], sizeof (buffer));
+
+	stream = camel_data_cache_add (cdc, "cur", key, &error);
+	check_msg (error == NULL, "add failed: %s", error ? error->message : "");
+	check (stream != NULL);
+
+	output_stream = g_io_stream_get_output_stream (stream);
+	g_output_stream_write_all (output_stream, buffer, sizeof (buffer), &n_written, NULL, &error);
+	check_msg (error == NULL, "write failed: %s", error ? error->message : "");
+	check (n_written == sizeof (buffer));
+
+	/* the item counts towards the limit once its stream is gone */
+	g_io_stream_close (stream, NULL, &error);
+	check_msg (error == NULL, "close failed: %s", error ? error->message : "");
+	check_unref (stream, 1);
+}
+
+static gboolean
+has_item (CamelDataCache *cdc,
+          const gchar *key)
+{
+	GIOStream *stream;
+
+	stream = camel_data_cache_get (cdc, "cur", key, NULL);
+	if (stream == NULL)
+		return FALSE;
+
+	g_object_unref (stream);
+
+	return TRUE;
+}
+
+static void
+wait_evictions (CamelDataCache *cdc,
+                guint64 expected)
+{
+	guint64 evictions = 0;
+	gint ii;
+
+	/* evictions happen in a background thread */
+	for (ii = 0; ii < 500; ii++) {
+		camel_data_cache_get_stats (cdc, NULL, NULL, &evictions);
+		if (evictions >= expected)
+			break;
+		g_usleep (G_USEC_PER_SEC / 100);
+	}
+
+	check_msg (evictions == expected, "evictions %" G_GUINT64_FORMAT ", expected %" G_GUINT64_FORMAT, evictions, expected);
+}
+
+static void
+check_write_behind (void)
+{
+	CamelDataCache *cdc;
+	GIOStream *stream;
+	GOutputStream *output_stream;
+	GInputStream *input_stream;
+	guchar *buffer, *read_back;
+	gsize n_written = 0, n_read = 0;
+	gsize ii;
+	GError *error = NULL;
+
+	cdc = camel_data_cache_new (CACHE_PATH "-behind", &error);
+	check_msg (error == NULL, "%s", error ? error->message : "");
+	check (cdc != NULL);
+
+	camel_data_cache_set_write_behind (cdc, TRUE);
+	check (camel_data_cache_get_write_behind (cdc));
+
+	buffer = g_malloc (LARGE_ITEM_SIZE);
+	read_back = g_malloc (LARGE_ITEM_SIZE);
+	for (ii = 0; ii < LARGE_ITEM_SIZE; ii++)
+		buffer[ii] = ii % 251;
+
+	stream = camel_data_cache_add (cdc, "cur", "large", &error);
+	check_msg (error == NULL, "add failed: %s", error ? error->message : "");
+	check (stream != NULL);
+
+	/* written in pieces, seeking to where the stream already is */
+	output_stream = g_io_stream_get_output_stream (stream);
+	for (ii = 0; ii < LARGE_ITEM_SIZE; ii += n_written) {
+		check (g_seekable_seek (G_SEEKABLE (stream), ii, G_SEEK_SET, NULL, NULL));
+		g_output_stream_write_all (output_stream, buffer + ii, MIN (ITEM_SIZE, LARGE_ITEM_SIZE - ii), &n_written, NULL, &error);
+		check_msg (error == NULL, "write failed: %s", error ? error->message : "");
+		check (g_seekable_tell (G_SEEKABLE (stream)) == ii + n_written);
+	}
+
+	g_io_stream_close (stream, NULL, &error);
+	check_msg (error == NULL, "close failed: %s", error ? error->message : "");
+	g_object_unref (stream);
+
+	stream = camel_data_cache_get (cdc, "cur", "large", &error);
+	check_msg (error == NULL, "get failed: %s", error ? error->message : "");
+	check (stream != NULL);
+
+	input_stream = g_io_stream_get_input_stream (stream);
+	g_input_stream_read_all (input_stream, read_back, LARGE_ITEM_SIZE, &n_read, NULL, &error);
+	check_msg (error == NULL, "read failed: %s", error ? error->message : "");
+	check (n_read == LARGE_ITEM_SIZE);
+	check (memcmp (buffer, read_back, LARGE_ITEM_SIZE) == 0);
+	check_unref (stream, 1);
+
+	g_free (buffer);
+	g_free (read_back);
+	g_object_unref (cdc);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	CamelDataCache *cdc;
+	GIOStream *stream;
+	guint64 hits = 0, misses = 0, evictions = 0;
+	GError *error = NULL;
+
+	camel_test_init (argc, argv);
+
+	system ("/bin/rm -rf /tmp/camel-test");
+
+	camel_test_start ("Data cache size limit");
+
+	cdc = camel_data_cache_new (CACHE_PATH, &error);
+	check_msg (error == NULL, "%s", error ? error->message : "");
+	check (cdc != NULL);
+
+	camel_data_cache_set_size_limit (cdc, 3 * ITEM_SIZE + ITEM_SIZE / 2);
+	check (camel_data_cache_get_size_limit (cdc) == 3 * ITEM_SIZE + ITEM_SIZE / 2);
+
+	camel_test_push ("fill up to the limit");
+	add_item (cdc, "a");
+	add_item (cdc, "b");
+	add_item (cdc, "c");
+	wait_evictions (cdc, 0);
+	camel_test_pull ();
+
+	camel_test_push ("least recently used goes first");
+	/* reading 'a' makes 'b' the least recently used item */
+	stream = camel_data_cache_get (cdc, "cur", "a", NULL);
+	check (stream != NULL);
+	check_unref (stream, 1);
+
+	add_item (cdc, "d");
+	wait_evictions (cdc, 1);
+
+	check (!has_item (cdc, "b"));
+	check (has_item (cdc, "a"));
+	check (has_item (cdc, "c"));
+	check (has_item (cdc, "d"));
+	camel_test_pull ();
+
+	camel_test_push ("counters");
+	camel_data_cache_get_stats (cdc, &hits, &misses, &evictions);
+	check_msg (hits == 4, "hits %" G_GUINT64_FORMAT, hits);
+	check_msg (misses == 1, "misses %" G_GUINT64_FORMAT, misses);
+	check_msg (evictions == 1, "evictions %" G_GUINT64_FORMAT, evictions);
+	camel_test_pull ();
+
+	camel_test_push ("items of a previous path are not evicted");
+	camel_data_cache_set_path (cdc, CACHE_PATH "-other");
+	add_item (cdc, "e");
+	add_item (cdc, "f");
+	add_item (cdc, "g");
+	add_item (cdc, "h");
+	wait_evictions (cdc, 2);
+
+	check (!has_item (cdc, "e"));
+	check (has_item (cdc, "f"));
+
+	camel_data_cache_set_path (cdc, CACHE_PATH);
+	check (has_item (cdc, "a"));
+	check (has_item (cdc, "c"));
+	check (has_item (cdc, "d"));
+	camel_test_pull ();
+
+	/* an eviction thread may still hold a reference */
+	g_object_unref (cdc);
+
+	camel_test_end ();
+
+	camel_test_start ("Data cache write behind");
+	check_write_behind ();
+	camel_test_end ();
+
+	system ("/bin/rm -rf /tmp/camel-test");
+
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <camel/camel-search-private.h>
+
+#include "camel-test.h"
+
+static const gchar *haystacks[] = {
+	"",
+	"Hello World",
+	"The quick brown fox jumps over the lazy dog",
+	"Re: [evolution-list] Meeting moved to Thursday",
+	"Ünïcödé ÜBER straße",
+	"aaaaaaaaab",
+	"he said she said, hers was his"
+};
+
+static const gchar *patterns[] = {
+	"world",
+	"FOX",
+	"lazy dog",
+	"thursday",
+	"über",
+	"STRASSE",
+	"aab",
+	"she",
+	"he",
+	"hers",
+	"his",
+	"missing",
+	"world"
+};
+
+static const gchar *words[] = {
+	"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf",
+	"hotel", "india", "juliet", "kilo", "lima", "mike", "november",
+	"oscar", "papa", "quebec", "romeo", "sierra", "tango"
+};
+
+#define BENCH_ITERATIONS (200)
+
+static gchar *
+build_text (void)
+{
+	GString *text;
+	gint ii;
+
+	text = g_string_new ("");
+
+	/* lots of near misses, and the last word only at the very end */
+	for (ii = 0; ii < 4000; ii++) {
+		g_string_append (text, words[ii % 19]);
+		g_string_append_c (text, ii % 7 ? ' ' : '\n');
+		g_string_append (text, "Lorem Ipsum Dolor Sit Amet ");
+	}
+
+	g_string_append (text, words[19]);
+
+	return g_string_free (text, FALSE);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	CamelSearchMatcher *matcher;
+	gint ii, jj, nn;
+	gchar *text;
+
+	camel_test_init (argc, argv);
+
+	camel_test_start ("Multi-pattern search");
+
+	for (ii = 0; ii < G_N_ELEMENTS (haystacks); ii++) {
+		guint8 found[G_N_ELEMENTS (patterns)];
+		gboolean any = FALSE;
+		gint missing = 0;
+
+		camel_test_push ("haystack %d '%s'", ii, haystacks[ii]);
+
+		matcher = camel_search_matcher_new (patterns, G_N_ELEMENTS (patterns));
+		memset (found, 0, sizeof (found));
+
+		camel_search_matcher_contains_all (matcher, haystacks[ii], -1, found);
+
+		for (jj = 0; jj < G_N_ELEMENTS (patterns); jj++) {
+			gboolean expect = camel_ustrstrcase (haystacks[ii], patterns[jj]) != NULL;
+
+			check_msg (
+				found[jj] == expect,
+				"'%s': found %d, expected %d", patterns[jj], found[jj], expect);
+
+			if (expect)
+				any = TRUE;
+			else
+				missing++;
+		}
+
+		check (camel_search_matcher_contains_any (matcher, haystacks[ii], -1) == any);
+
+		memset (found, 0, sizeof (found));
+		check (camel_search_matcher_contains_all (matcher, haystacks[ii], -1, found) == missing);
+
+		camel_search_matcher_unref (matcher);
+		camel_test_pull ();
+	}
+
+	camel_test_end ();
+
+	camel_test_start ("Multi-pattern search speed");
+
+	text = build_text ();
+
+	for (nn = 5; nn <= 20; nn += 5) {
+		gint64 start, per_word, single_pass;
+		guint8 found[G_N_ELEMENTS (words)];
+		gint all_naive = 0, all_matcher = 0;
+		gint it;
+
+		camel_test_push ("%d terms", nn);
+
+		start = g_get_monotonic_time ();
+		for (it = 0; it < BENCH_ITERATIONS; it++) {
+			for (jj = 0; jj < nn; jj++) {
+				if (!camel_ustrstrcase (text, words[G_N_ELEMENTS (words) - nn + jj]))
+					break;
+			}
+			if (jj == nn)
+				all_naive++;
+		}
+		per_word = g_get_monotonic_time () - start;
+
+		matcher = camel_search_matcher_new (words + G_N_ELEMENTS (words) - nn, nn);
+
+		start = g_get_monotonic_time ();
+		for (it = 0; it < BENCH_ITERATIONS; it++) {
+			memset (found, 0, sizeof (found));
+			if (camel_search_matcher_contains_all (matcher, text, -1, found) == 0)
+				all_matcher++;
+		}
+		single_pass = g_get_monotonic_time () - start;
+
+		camel_search_matcher_unref (matcher);
+
+		check (all_naive == all_matcher);
+
+		printf (
+			"%2d terms: %" G_GINT64_FORMAT " us per word, %" G_GINT64_FORMAT " us single pass\n",
+			nn, per_word / BENCH_ITERATIONS, single_pass / BENCH_ITERATIONS);
+
+		camel_test_pull ();
+	}
+
+	g_free (text);
+
+	camel_test_end ();
+
+	return 0;
+}
@@ -451,6 +451,117 @@ test_construction_vcard_attribute_with_group (void)
 	e_vcard_attribute_free (attr1);
 }
 
+static void
+test_vcard_values (void)
+{
+	EVCard *vcard;
+	EVCardAttribute *attr;
+	GList *values;
+
+	vcard = e_vcard_new_from_string (
+		"BEGIN:VCARD\r\n"
+		"VERSION:3.0\r\n"
+		"NOTE:first\\nsecond\\, with \\;escapes\\\\ and a lo\r\n"
+		" ng folded line, 1=2\r\n"
+		"N:Žluťoučký;Kůň;;;\r\n"
+		"CATEGORIES:one,two\\,three,\r\n"
+		"ORG:Org, Inc.;Unit\r\n"
+		"END:VCARD\r\n");
+
+	attr = e_vcard_get_attribute (vcard, "NOTE");
+	g_assert (attr != NULL);
+	values = e_vcard_attribute_get_values (attr);
+	g_assert_cmpint (g_list_length (values), ==, 1);
+	g_assert_cmpstr (values->data, ==, "first\nsecond, with ;escapes\\ and a long folded line, 1=2");
+
+	attr = e_vcard_get_attribute (vcard, "N");
+	g_assert (attr != NULL);
+	values = e_vcard_attribute_get_values (attr);
+	g_assert_cmpint (g_list_length (values), ==, 5);
+	g_assert_cmpstr (values->data, ==, "Žluťoučký");
+	g_assert_cmpstr (values->next->data, ==, "Kůň");
+	g_assert_cmpstr (values->next->next->data, ==, "");
+
+	attr = e_vcard_get_attribute (vcard, "CATEGORIES");
+	g_assert (attr != NULL);
+	values = e_vcard_attribute_get_values (attr);
+	g_assert_cmpint (g_list_length (values), ==, 3);
+	g_assert_cmpstr (values->data, ==, "one");
+	g_assert_cmpstr (values->next->data, ==, "two,three");
+	g_assert_cmpstr (values->next->next->data, ==, "");
+
+	/* only CATEGORIES splits on commas */
+	attr = e_vcard_get_attribute (vcard, "ORG");
+	g_assert (attr != NULL);
+	values = e_vcard_attribute_get_values (attr);
+	g_assert_cmpint (g_list_length (values), ==, 2);
+	g_assert_cmpstr (values->data, ==, "Org, Inc.");
+	g_assert_cmpstr (values->next->data, ==, "Unit");
+
+	g_object_unref (vcard);
+}
+
+/* A contact of a typical size, plus a long folded PHOTO */
+static gchar *
+build_speed_vcard (void)
+{
+	GString *str;
+	gint ii;
+
+	str = g_string_new (
+		"BEGIN:VCARD\r\n"
+		"VERSION:3.0\r\n"
+		"UID:speed-test\r\n"
+		"FN:Jörg Müller-Lüdenscheidt\r\n"
+		"N:Müller-Lüdenscheidt;Jörg;;Dr.;\r\n"
+		"EMAIL;TYPE=WORK:joerg@example.com\r\n"
+		"EMAIL;TYPE=HOME:jml@example.org\r\n"
+		"TEL;TYPE=WORK,VOICE:+49 30 1234567\r\n"
+		"ADR;TYPE=WORK:;;Unter den Linden 1;Berlin;;10117;Germany\r\n"
+		"CATEGORIES:Work,Friends,Berlin\r\n"
+		"NOTE:Met at the conference\\, talked about\\nvCard parsing.\r\n"
+		"PHOTO;ENCODING=b;TYPE=JPEG:");
+
+	for (ii = 0; ii < 2000; ii++)
+		g_string_append (str, "/9j/4AAQSkZJRgABAQEASABIAAD/2wBDAAMCAgMCAgMDAwMEAwMEBQgFBQQEBQoH\r\n ");
+
+	g_string_append (str, "AAAA\r\nEND:VCARD\r\n");
+
+	return g_string_free (str, FALSE);
+}
+
+static void
+test_vcard_speed (void)
+{
+	gchar *str;
+	gint64 start, elapsed;
+	gsize total = 0;
+	gint ii;
+
+	if (!g_test_perf ())
+		return;
+
+	str = build_speed_vcard ();
+
+	start = g_get_monotonic_time ();
+	for (ii = 0; ii < 100; ii++) {
+		EVCard *vcard = e_vcard_new_from_string (str);
+
+		/* parsing is lazy, this triggers it */
+		g_assert (e_vcard_get_attributes (vcard) != NULL);
+		g_object_unref (vcard);
+
+		total += strlen (str);
+	}
+	elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+	g_test_message (
+		"Parsed %" G_GSIZE_FORMAT " bytes in %" G_GINT64_FORMAT " us, %.1f MB/s",
+		total, elapsed, (gdouble) total / elapsed);
+
+	g_free (str);
+}
+
 gint
 main (gint argc,
       gchar **argv)
@@ -463,6 +574,8 @@ main (gint argc,
 	g_test_add_func ("/Parsing/Contact/WithUID", test_contact_with_uid);
 	g_test_add_func ("/Parsing/Contact/WithoutUID", test_contact_without_uid);
 	g_test_add_func ("/Parsing/VCard/QuotedPrintable", test_vcard_quoted_printable);
+	g_test_add_func ("/Parsing/VCard/Values", test_vcard_values);
+	g_test_add_func ("/Parsing/VCard/Speed", test_vcard_speed);
 	g_test_add_func ("/Construction/VCardAttribute/WithGroup",
 	                 test_construction_vcard_attribute_with_group);
 
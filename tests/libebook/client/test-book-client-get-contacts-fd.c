@@ -0,0 +1,192 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <libebook/libebook.h>
+
+/* Private D-Bus classes. */
+#include <e-dbus-address-book.h>
+
+#include "client-test-utils.h"
+#include "e-test-server-utils.h"
+
+/* Large enough for the result to be passed in a file */
+#define N_CONTACTS 1000
+#define N_ROUNDS   10
+
+static ETestServerClosure book_closure = { E_TEST_SERVER_ADDRESS_BOOK, NULL, 0, FALSE, NULL, FALSE };
+
+static void
+add_contacts (EBookClient *book_client)
+{
+	GSList *contacts = NULL;
+	GString *note;
+	GError *error = NULL;
+	gint ii;
+
+	note = g_string_new ("");
+	for (ii = 0; ii < 50; ii++)
+		g_string_append (note, "Some lengthy text to make the vCards bigger. ");
+
+	for (ii = 0; ii < N_CONTACTS; ii++) {
+		EContact *contact = e_contact_new ();
+		gchar *name = g_strdup_printf ("Contact %d", ii);
+
+		e_contact_set (contact, E_CONTACT_FULL_NAME, name);
+		e_contact_set (contact, E_CONTACT_NOTE, note->str);
+		contacts = g_slist_prepend (contacts, contact);
+
+		g_free (name);
+	}
+
+	if (!e_book_client_add_contacts_sync (book_client, contacts, NULL, NULL, &error))
+		g_error ("add contacts sync: %s", error->message);
+
+	g_slist_free_full (contacts, g_object_unref);
+	g_string_free (note, TRUE);
+}
+
+static GSList *
+get_contacts_dbus (EBookClient *book_client,
+                   const gchar *sexp)
+{
+	EDBusAddressBook *proxy;
+	GSList *contacts = NULL;
+	gchar **vcards = NULL;
+	GError *error = NULL;
+	gint ii;
+
+	proxy = E_DBUS_ADDRESS_BOOK (E_CLIENT_GET_CLASS (book_client)->get_dbus_proxy (E_CLIENT (book_client)));
+
+	if (!e_dbus_address_book_call_get_contact_list_sync (proxy, sexp, &vcards, NULL, &error))
+		g_error ("get contact list: %s", error->message);
+
+	for (ii = 0; vcards[ii] != NULL; ii++)
+		contacts = g_slist_prepend (contacts, e_contact_new_from_vcard (vcards[ii]));
+
+	g_strfreev (vcards);
+
+	return g_slist_reverse (contacts);
+}
+
+static void
+assert_same_contacts (GSList *contacts1,
+                      GSList *contacts2)
+{
+	g_assert_cmpint (g_slist_length (contacts1), ==, g_slist_length (contacts2));
+
+	for (; contacts1 && contacts2; contacts1 = contacts1->next, contacts2 = contacts2->next) {
+		gchar *vcard1 = e_vcard_to_string (contacts1->data, EVC_FORMAT_VCARD_30);
+		gchar *vcard2 = e_vcard_to_string (contacts2->data, EVC_FORMAT_VCARD_30);
+
+		g_assert_cmpstr (vcard1, ==, vcard2);
+
+		g_free (vcard1);
+		g_free (vcard2);
+	}
+}
+
+static void
+test_get_contacts_fd (ETestServerFixture *fixture,
+                      gconstpointer user_data)
+{
+	EBookClient *book_client;
+	EBookQuery *query;
+	GSList *contacts = NULL, *expected;
+	GError *error = NULL;
+	gint64 start, dbus_time, fd_time;
+	gchar *sexp;
+	gint ii;
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+
+	add_contacts (book_client);
+
+	query = e_book_query_any_field_contains ("");
+	sexp = e_book_query_to_string (query);
+	e_book_query_unref (query);
+
+	/* A large result, passed in a file */
+	if (!e_book_client_get_contacts_sync (book_client, sexp, &contacts, NULL, &error))
+		g_error ("get contacts sync: %s", error->message);
+
+	expected = get_contacts_dbus (book_client, sexp);
+	g_assert_cmpint (g_slist_length (contacts), ==, N_CONTACTS);
+	assert_same_contacts (contacts, expected);
+
+	e_client_util_free_object_slist (contacts);
+	e_client_util_free_object_slist (expected);
+	g_free (sexp);
+
+	/* A small one, passed in the message */
+	query = e_book_query_field_test (E_CONTACT_FULL_NAME, E_BOOK_QUERY_IS, "Contact 7");
+	sexp = e_book_query_to_string (query);
+	e_book_query_unref (query);
+
+	if (!e_book_client_get_contacts_sync (book_client, sexp, &contacts, NULL, &error))
+		g_error ("get contacts sync: %s", error->message);
+
+	g_assert_cmpint (g_slist_length (contacts), ==, 1);
+	g_assert_cmpstr (e_contact_get_const (contacts->data, E_CONTACT_FULL_NAME), ==, "Contact 7");
+
+	e_client_util_free_object_slist (contacts);
+	g_free (sexp);
+
+	if (!g_test_perf ())
+		return;
+
+	query = e_book_query_any_field_contains ("");
+	sexp = e_book_query_to_string (query);
+	e_book_query_unref (query);
+
+	start = g_get_monotonic_time ();
+	for (ii = 0; ii < N_ROUNDS; ii++)
+		e_client_util_free_object_slist (get_contacts_dbus (book_client, sexp));
+	dbus_time = g_get_monotonic_time () - start;
+
+	start = g_get_monotonic_time ();
+	for (ii = 0; ii < N_ROUNDS; ii++) {
+		if (!e_book_client_get_contacts_sync (book_client, sexp, &contacts, NULL, &error))
+			g_error ("get contacts sync: %s", error->message);
+
+		e_client_util_free_object_slist (contacts);
+	}
+	fd_time = g_get_monotonic_time () - start;
+
+	g_test_message (
+		"Fetched %d contacts: %" G_GINT64_FORMAT " us over D-Bus, "
+		"%" G_GINT64_FORMAT " us through a file descriptor",
+		N_CONTACTS, dbus_time / N_ROUNDS, fd_time / N_ROUNDS);
+
+	g_free (sexp);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+	g_test_bug_base ("http://bugzilla.gnome.org/");
+
+	g_test_add (
+		"/EBookClient/GetContacts/FileDescriptor",
+		ETestServerFixture,
+		&book_closure,
+		e_test_server_utils_setup,
+		test_get_contacts_fd,
+		e_test_server_utils_teardown);
+
+	return e_test_server_utils_run ();
+}
@@ -0,0 +1,224 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include <libebook/libebook.h>
+
+#include "client-test-utils.h"
+#include "e-test-server-utils.h"
+
+/* More than a single batch of the backend */
+#define N_IMPORT_CONTACTS 1200
+
+static ETestServerClosure book_closure_sync = { E_TEST_SERVER_ADDRESS_BOOK, NULL, 0, FALSE, NULL, FALSE };
+static ETestServerClosure book_closure_async = { E_TEST_SERVER_ADDRESS_BOOK, NULL, 0, FALSE, NULL, TRUE };
+
+static GInputStream *
+build_import_stream (void)
+{
+	GString *str;
+	gint ii;
+
+	str = g_string_new ("");
+
+	for (ii = 0; ii < N_IMPORT_CONTACTS; ii++) {
+		/* Mix line endings, folding and stuff between the vCards */
+		const gchar *eol = (ii % 2) ? "\r\n" : "\n";
+
+		g_string_append_printf (
+			str,
+			"BEGIN:VCARD%s"
+			"VERSION:3.0%s"
+			"FN:Imported Contact %d%s"
+			"N:Contact %d;Imported;;;%s"
+			"NOTE:A long note, which is folded to make sure that%s"
+			"  END:VCARD in it does not end the vCard%s"
+			"EMAIL:imported-%d@example.com%s"
+			"END:VCARD%s",
+			eol, eol, ii, eol, ii, eol, eol, eol, ii, eol, eol);
+
+		if (ii % 100 == 0)
+			g_string_append (str, eol);
+	}
+
+	return g_memory_input_stream_new_from_data (
+		g_string_free (str, FALSE), -1, g_free);
+}
+
+static void
+check_imported (EBookClient *book_client,
+                GSList *uids)
+{
+	EBookQuery *query;
+	EContact *contact = NULL;
+	GSList *found = NULL;
+	GError *error = NULL;
+	gchar *sexp;
+
+	g_assert_cmpint (g_slist_length (uids), ==, N_IMPORT_CONTACTS);
+
+	query = e_book_query_field_test (E_CONTACT_FULL_NAME, E_BOOK_QUERY_BEGINS_WITH, "Imported Contact");
+	sexp = e_book_query_to_string (query);
+
+	if (!e_book_client_get_contacts_uids_sync (book_client, sexp, &found, NULL, &error))
+		g_error ("get contacts uids: %s", error->message);
+
+	g_assert_cmpint (g_slist_length (found), ==, N_IMPORT_CONTACTS);
+
+	if (!e_book_client_get_contact_sync (book_client, uids->data, &contact, NULL, &error))
+		g_error ("get contact: %s", error->message);
+
+	g_assert_cmpstr (e_contact_get_const (contact, E_CONTACT_FULL_NAME), ==, "Imported Contact 0");
+	g_assert (strstr (e_contact_get_const (contact, E_CONTACT_NOTE), " END:VCARD in it") != NULL);
+
+	g_object_unref (contact);
+	e_util_free_string_slist (found);
+	e_book_query_unref (query);
+	g_free (sexp);
+}
+
+static void
+test_import_contacts_sync (ETestServerFixture *fixture,
+                           gconstpointer user_data)
+{
+	EBookClient *book_client;
+	GInputStream *stream;
+	GSList *uids = NULL;
+	GError *error = NULL;
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+
+	stream = build_import_stream ();
+
+	if (!e_book_client_import_contacts_sync (book_client, stream, &uids, NULL, &error))
+		g_error ("import contacts sync: %s", error->message);
+
+	check_imported (book_client, uids);
+
+	e_util_free_string_slist (uids);
+	g_object_unref (stream);
+}
+
+static void
+test_import_contacts_truncated (ETestServerFixture *fixture,
+                                gconstpointer user_data)
+{
+	EBookClient *book_client;
+	GInputStream *stream;
+	EBookQuery *query;
+	GSList *uids = NULL;
+	GError *error = NULL;
+	gchar *sexp;
+	static const gchar *input =
+		"BEGIN:VCARD\r\n"
+		"VERSION:3.0\r\n"
+		"FN:Truncated Contact 0\r\n"
+		"END:VCARD\r\n"
+		"BEGIN:VCARD\r\n"
+		"VERSION:3.0\r\n"
+		"FN:Truncated Contact 1\r\n";
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+
+	stream = g_memory_input_stream_new_from_data (input, -1, NULL);
+
+	/* The input ends in the middle of a vCard */
+	g_assert (!e_book_client_import_contacts_sync (book_client, stream, &uids, NULL, &error));
+	g_assert_error (error, E_CLIENT_ERROR, E_CLIENT_ERROR_INVALID_ARG);
+	g_assert (uids == NULL);
+	g_clear_error (&error);
+
+	/* Neither the partial vCard nor the rest of its batch is stored */
+	query = e_book_query_field_test (E_CONTACT_FULL_NAME, E_BOOK_QUERY_BEGINS_WITH, "Truncated Contact");
+	sexp = e_book_query_to_string (query);
+
+	if (!e_book_client_get_contacts_uids_sync (book_client, sexp, &uids, NULL, &error))
+		g_error ("get contacts uids: %s", error->message);
+
+	g_assert (uids == NULL);
+
+	e_book_query_unref (query);
+	g_free (sexp);
+	g_object_unref (stream);
+}
+
+static void
+import_contacts_cb (GObject *source_object,
+                    GAsyncResult *result,
+                    gpointer user_data)
+{
+	GMainLoop *loop = (GMainLoop *) user_data;
+	GSList *uids = NULL;
+	GError *error = NULL;
+
+	if (!e_book_client_import_contacts_finish (E_BOOK_CLIENT (source_object), result, &uids, &error))
+		g_error ("import contacts finish: %s", error->message);
+
+	check_imported (E_BOOK_CLIENT (source_object), uids);
+
+	e_util_free_string_slist (uids);
+	g_main_loop_quit (loop);
+}
+
+static void
+test_import_contacts_async (ETestServerFixture *fixture,
+                            gconstpointer user_data)
+{
+	EBookClient *book_client;
+	GInputStream *stream;
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+
+	stream = build_import_stream ();
+
+	e_book_client_import_contacts (book_client, stream, NULL, import_contacts_cb, fixture->loop);
+
+	g_main_loop_run (fixture->loop);
+
+	g_object_unref (stream);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+	g_test_bug_base ("http://bugzilla.gnome.org/");
+
+	g_test_add (
+		"/EBookClient/ImportContacts/Sync",
+		ETestServerFixture,
+		&book_closure_sync,
+		e_test_server_utils_setup,
+		test_import_contacts_sync,
+		e_test_server_utils_teardown);
+	g_test_add (
+		"/EBookClient/ImportContacts/Async",
+		ETestServerFixture,
+		&book_closure_async,
+		e_test_server_utils_setup,
+		test_import_contacts_async,
+		e_test_server_utils_teardown);
+	g_test_add (
+		"/EBookClient/ImportContacts/Truncated",
+		ETestServerFixture,
+		&book_closure_sync,
+		e_test_server_utils_setup,
+		test_import_contacts_truncated,
+		e_test_server_utils_teardown);
+
+	return e_test_server_utils_run ();
+}
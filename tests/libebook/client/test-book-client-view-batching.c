@@ -0,0 +1,169 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <libebook/libebook.h>
+
+#include "client-test-utils.h"
+#include "e-test-server-utils.h"
+
+#define N_CONTACTS 1000
+
+static ETestServerClosure book_closure = { E_TEST_SERVER_ADDRESS_BOOK, NULL, 0, FALSE, NULL, FALSE };
+
+typedef struct {
+	GMainLoop *loop;
+	guint n_signals;
+	guint n_added;
+	gboolean modified;
+} BatchData;
+
+static void
+objects_added (EBookClientView *view,
+               const GSList *contacts,
+               BatchData *data)
+{
+	data->n_signals++;
+	data->n_added += g_slist_length ((GSList *) contacts);
+}
+
+static void
+objects_modified (EBookClientView *view,
+                  const GSList *contacts,
+                  BatchData *data)
+{
+	data->modified = TRUE;
+	g_main_loop_quit (data->loop);
+}
+
+static void
+complete (EBookClientView *view,
+          const GError *error,
+          BatchData *data)
+{
+	g_main_loop_quit (data->loop);
+}
+
+static gboolean
+timeout_cb (gpointer user_data)
+{
+	BatchData *data = user_data;
+
+	g_main_loop_quit (data->loop);
+
+	return FALSE;
+}
+
+static void
+test_view_batching (ETestServerFixture *fixture,
+                    gconstpointer user_data)
+{
+	EBookClient *book_client;
+	EBookClientView *view;
+	EBookQuery *query;
+	EContact *contact = NULL;
+	GSList *contacts = NULL;
+	BatchData data = { NULL, };
+	GError *error = NULL;
+	gint64 start, latency;
+	gchar *sexp;
+	guint timeout_id;
+	gint ii;
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+
+	for (ii = 0; ii < N_CONTACTS; ii++) {
+		gchar *name = g_strdup_printf ("Contact %d", ii);
+
+		contact = e_contact_new ();
+		e_contact_set (contact, E_CONTACT_FULL_NAME, name);
+		contacts = g_slist_prepend (contacts, contact);
+
+		g_free (name);
+	}
+
+	if (!e_book_client_add_contacts_sync (book_client, contacts, NULL, NULL, &error))
+		g_error ("add contacts sync: %s", error->message);
+
+	e_client_util_free_object_slist (contacts);
+
+	query = e_book_query_any_field_contains ("");
+	sexp = e_book_query_to_string (query);
+	e_book_query_unref (query);
+
+	if (!e_book_client_get_view_sync (book_client, sexp, &view, NULL, &error))
+		g_error ("get book view sync: %s", error->message);
+
+	g_free (sexp);
+
+	data.loop = fixture->loop;
+	g_signal_connect (view, "objects-added", G_CALLBACK (objects_added), &data);
+	g_signal_connect (view, "objects-modified", G_CALLBACK (objects_modified), &data);
+	g_signal_connect (view, "complete", G_CALLBACK (complete), &data);
+
+	e_book_client_view_start (view, &error);
+	if (error)
+		g_error ("start view: %s", error->message);
+
+	g_main_loop_run (fixture->loop);
+
+	/* The initial contacts come in growing batches,
+	 * not in fixed ones of a few dozens */
+	g_assert_cmpint (data.n_added, ==, N_CONTACTS);
+	g_assert_cmpint (data.n_signals, <, N_CONTACTS / 32);
+
+	/* A single change is sent right away, not in seconds */
+	if (!add_contact_from_test_case_verify (book_client, "simple-1", &contact))
+		g_error ("Failed to add contact");
+
+	e_contact_set (contact, E_CONTACT_FULL_NAME, "Modified Name");
+
+	timeout_id = g_timeout_add_seconds (5, timeout_cb, &data);
+	start = g_get_monotonic_time ();
+
+	if (!e_book_client_modify_contact_sync (book_client, contact, NULL, &error))
+		g_error ("modify contact sync: %s", error->message);
+
+	g_main_loop_run (fixture->loop);
+
+	latency = g_get_monotonic_time () - start;
+
+	g_assert (data.modified);
+	g_assert_cmpint (latency, <, G_USEC_PER_SEC);
+
+	g_source_remove (timeout_id);
+	g_object_unref (contact);
+
+	e_book_client_view_stop (view, NULL);
+	g_object_unref (view);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+	g_test_bug_base ("http://bugzilla.gnome.org/");
+
+	g_test_add (
+		"/EBookClient/View/Batching",
+		ETestServerFixture,
+		&book_closure,
+		e_test_server_utils_setup,
+		test_view_batching,
+		e_test_server_utils_teardown);
+
+	return e_test_server_utils_run ();
+}
@@ -0,0 +1,257 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include <libebook/libebook.h>
+
+#include "client-test-utils.h"
+#include "e-test-server-utils.h"
+
+#define N_CONTACTS 50
+
+static void
+setup_binary_vcards_book (ESource *scratch,
+                          ETestServerClosure *closure)
+{
+	ESourceBackendSummarySetup *setup;
+
+	g_type_ensure (E_TYPE_SOURCE_BACKEND_SUMMARY_SETUP);
+	setup = e_source_get_extension (scratch, E_SOURCE_EXTENSION_BACKEND_SUMMARY_SETUP);
+	e_source_backend_summary_setup_set_store_binary_vcards (setup, TRUE);
+}
+
+static ETestServerClosure book_closure = { E_TEST_SERVER_ADDRESS_BOOK, NULL, 0, FALSE, NULL, FALSE };
+static ETestServerClosure binary_vcards_closure = { E_TEST_SERVER_ADDRESS_BOOK, setup_binary_vcards_book, 0, FALSE, NULL, FALSE };
+
+typedef struct {
+	GMainLoop *loop;
+	gboolean projected;
+	guint n_added;
+	guint quit_at;
+	gsize n_bytes;
+} FieldsData;
+
+static EContact *
+new_contact (gint index,
+             const gchar *note)
+{
+	EContact *contact = e_contact_new ();
+	gchar *name = g_strdup_printf ("Contact %d", index);
+	gchar *email = g_strdup_printf ("contact-%d@example.com", index);
+
+	e_contact_set (contact, E_CONTACT_FULL_NAME, name);
+	e_contact_set (contact, E_CONTACT_EMAIL_1, email);
+	e_contact_set (contact, E_CONTACT_NOTE, note);
+
+	g_free (name);
+	g_free (email);
+
+	return contact;
+}
+
+static gchar *
+new_note (void)
+{
+	GString *note;
+	gint ii;
+
+	/* Stands in for the big attributes, like embedded photos */
+	note = g_string_new ("");
+	for (ii = 0; ii < 300; ii++)
+		g_string_append (note, "Some lengthy text, which is not asked for. ");
+
+	return g_string_free (note, FALSE);
+}
+
+static void
+objects_added (EBookClientView *view,
+               const GSList *contacts,
+               FieldsData *data)
+{
+	const GSList *l;
+
+	for (l = contacts; l; l = l->next) {
+		EContact *contact = l->data;
+		gchar *vcard;
+
+		g_assert (e_contact_get_const (contact, E_CONTACT_UID) != NULL);
+		g_assert (e_contact_get_const (contact, E_CONTACT_FULL_NAME) != NULL);
+		g_assert (e_contact_get_const (contact, E_CONTACT_EMAIL_1) != NULL);
+
+		if (data->projected)
+			g_assert (e_vcard_get_attribute (E_VCARD (contact), EVC_NOTE) == NULL);
+		else
+			g_assert (e_vcard_get_attribute (E_VCARD (contact), EVC_NOTE) != NULL);
+
+		vcard = e_vcard_to_string (E_VCARD (contact), EVC_FORMAT_VCARD_30);
+		data->n_bytes += strlen (vcard);
+		g_free (vcard);
+
+		data->n_added++;
+	}
+
+	if (data->quit_at && data->n_added >= data->quit_at)
+		g_main_loop_quit (data->loop);
+}
+
+static void
+complete (EBookClientView *view,
+          const GError *error,
+          FieldsData *data)
+{
+	g_main_loop_quit (data->loop);
+}
+
+static EBookClientView *
+start_view (EBookClient *book_client,
+            FieldsData *data)
+{
+	EBookClientView *view;
+	EBookQuery *query;
+	GSList *fields = NULL;
+	GError *error = NULL;
+	gchar *sexp;
+
+	query = e_book_query_any_field_contains ("");
+	sexp = e_book_query_to_string (query);
+	e_book_query_unref (query);
+
+	if (!e_book_client_get_view_sync (book_client, sexp, &view, NULL, &error))
+		g_error ("get book view sync: %s", error->message);
+
+	g_free (sexp);
+
+	g_signal_connect (view, "objects-added", G_CALLBACK (objects_added), data);
+	g_signal_connect (view, "complete", G_CALLBACK (complete), data);
+
+	if (data->projected) {
+		fields = g_slist_prepend (fields, (gpointer) e_contact_field_name (E_CONTACT_FULL_NAME));
+		fields = g_slist_prepend (fields, (gpointer) e_contact_field_name (E_CONTACT_EMAIL_1));
+	}
+
+	e_book_client_view_set_fields_of_interest (view, fields, &error);
+	if (error)
+		g_error ("set fields of interest: %s", error->message);
+
+	g_slist_free (fields);
+
+	e_book_client_view_start (view, &error);
+	if (error)
+		g_error ("start view: %s", error->message);
+
+	g_main_loop_run (data->loop);
+
+	return view;
+}
+
+static void
+test_view_fields (ETestServerFixture *fixture,
+                  gconstpointer user_data)
+{
+	EBookClient *book_client;
+	EBookClientView *view;
+	EContact *contact;
+	FieldsData full = { NULL, };
+	FieldsData projected = { NULL, };
+	GSList *contacts = NULL;
+	GError *error = NULL;
+	gchar *note;
+	gint ii;
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+
+	note = new_note ();
+
+	for (ii = 0; ii < N_CONTACTS; ii++)
+		contacts = g_slist_prepend (contacts, new_contact (ii, note));
+
+	if (!e_book_client_add_contacts_sync (book_client, contacts, NULL, NULL, &error))
+		g_error ("add contacts sync: %s", error->message);
+
+	e_client_util_free_object_slist (contacts);
+
+	/* The initial contacts, read from the database */
+	projected.loop = fixture->loop;
+	projected.projected = TRUE;
+	view = start_view (book_client, &projected);
+
+	g_assert_cmpint (projected.n_added, ==, N_CONTACTS);
+
+	/* A contact added while the view runs */
+	contact = new_contact (N_CONTACTS, note);
+	projected.quit_at = N_CONTACTS + 1;
+
+	if (!e_book_client_add_contact_sync (book_client, contact, NULL, NULL, &error))
+		g_error ("add contact sync: %s", error->message);
+
+	g_main_loop_run (fixture->loop);
+
+	g_assert_cmpint (projected.n_added, ==, N_CONTACTS + 1);
+
+	e_book_client_view_stop (view, NULL);
+	g_object_unref (view);
+	g_object_unref (contact);
+
+	/* Whole contacts without fields of interest */
+	full.loop = fixture->loop;
+	view = start_view (book_client, &full);
+
+	g_assert_cmpint (full.n_added, ==, N_CONTACTS + 1);
+	g_assert_cmpint (projected.n_bytes * 10, <, full.n_bytes);
+
+	g_test_message (
+		"Received %" G_GSIZE_FORMAT " bytes of vCards with fields of interest, "
+		"%" G_GSIZE_FORMAT " bytes without",
+		projected.n_bytes, full.n_bytes);
+
+	e_book_client_view_stop (view, NULL);
+	g_object_unref (view);
+
+	/* Whole contacts are read back unchanged */
+	if (!e_book_client_get_contacts_sync (book_client, "", &contacts, NULL, &error))
+		g_error ("get contacts sync: %s", error->message);
+
+	g_assert_cmpint (g_slist_length (contacts), ==, N_CONTACTS + 1);
+	g_assert_cmpstr (e_contact_get_const (contacts->data, E_CONTACT_NOTE), ==, note);
+
+	e_client_util_free_object_slist (contacts);
+	g_free (note);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+	g_test_bug_base ("http://bugzilla.gnome.org/");
+
+	g_test_add (
+		"/EBookClient/View/FieldsOfInterest",
+		ETestServerFixture,
+		&book_closure,
+		e_test_server_utils_setup,
+		test_view_fields,
+		e_test_server_utils_teardown);
+	g_test_add (
+		"/EBookClient/View/FieldsOfInterest/BinaryVCards",
+		ETestServerFixture,
+		&binary_vcards_closure,
+		e_test_server_utils_setup,
+		test_view_fields,
+		e_test_server_utils_teardown);
+
+	return e_test_server_utils_run ();
+}
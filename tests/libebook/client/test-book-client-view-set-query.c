@@ -0,0 +1,212 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <libebook/libebook.h>
+
+#include "client-test-utils.h"
+#include "e-test-server-utils.h"
+
+#define N_CONTACTS 20
+
+static ETestServerClosure book_closure = { E_TEST_SERVER_ADDRESS_BOOK, NULL, 0, FALSE, NULL, FALSE };
+
+typedef struct {
+	GMainLoop *loop;
+	GHashTable *uids;
+	guint n_added;
+	guint n_removed;
+} SetQueryData;
+
+static void
+objects_added (EBookClientView *view,
+               const GSList *contacts,
+               SetQueryData *data)
+{
+	const GSList *l;
+
+	for (l = contacts; l; l = l->next) {
+		const gchar *uid = e_contact_get_const (l->data, E_CONTACT_UID);
+
+		/* Only the contacts new to the view are sent */
+		g_assert (!g_hash_table_contains (data->uids, uid));
+		g_hash_table_add (data->uids, g_strdup (uid));
+
+		data->n_added++;
+	}
+}
+
+static void
+objects_removed (EBookClientView *view,
+                 const GSList *ids,
+                 SetQueryData *data)
+{
+	const GSList *l;
+
+	for (l = ids; l; l = l->next) {
+		g_assert (g_hash_table_remove (data->uids, l->data));
+
+		data->n_removed++;
+	}
+}
+
+static void
+complete (EBookClientView *view,
+          const GError *error,
+          SetQueryData *data)
+{
+	g_assert_no_error (error);
+
+	g_main_loop_quit (data->loop);
+}
+
+static gchar *
+query_email_contains (const gchar *suffix)
+{
+	EBookQuery *query;
+	gchar *sexp;
+
+	query = e_book_query_field_test (E_CONTACT_EMAIL, E_BOOK_QUERY_CONTAINS, suffix);
+	sexp = e_book_query_to_string (query);
+	e_book_query_unref (query);
+
+	return sexp;
+}
+
+static void
+set_query (EBookClientView *view,
+           const gchar *sexp,
+           SetQueryData *data)
+{
+	GError *error = NULL;
+
+	data->n_added = 0;
+	data->n_removed = 0;
+
+	e_book_client_view_set_query (view, sexp, &error);
+	if (error)
+		g_error ("set query: %s", error->message);
+
+	g_main_loop_run (data->loop);
+}
+
+static void
+test_view_set_query (ETestServerFixture *fixture,
+                     gconstpointer user_data)
+{
+	EBookClient *book_client;
+	EBookClientView *view;
+	SetQueryData data = { NULL, };
+	GSList *contacts = NULL;
+	GError *error = NULL;
+	gchar *sexp;
+	gint ii;
+
+	book_client = E_TEST_SERVER_UTILS_SERVICE (fixture, EBookClient);
+
+	/* Even contacts are at example.com, odd ones at example.org */
+	for (ii = 0; ii < N_CONTACTS; ii++) {
+		EContact *contact = e_contact_new ();
+		gchar *name = g_strdup_printf ("Contact %d", ii);
+		gchar *email = g_strdup_printf (
+			"contact-%d@example.%s", ii, (ii % 2) ? "org" : "com");
+
+		e_contact_set (contact, E_CONTACT_FULL_NAME, name);
+		e_contact_set (contact, E_CONTACT_EMAIL_1, email);
+		contacts = g_slist_prepend (contacts, contact);
+
+		g_free (name);
+		g_free (email);
+	}
+
+	if (!e_book_client_add_contacts_sync (book_client, contacts, NULL, NULL, &error))
+		g_error ("add contacts sync: %s", error->message);
+
+	e_client_util_free_object_slist (contacts);
+
+	data.loop = fixture->loop;
+	data.uids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	sexp = query_email_contains ("example");
+	if (!e_book_client_get_view_sync (book_client, sexp, &view, NULL, &error))
+		g_error ("get book view sync: %s", error->message);
+	g_free (sexp);
+
+	g_signal_connect (view, "objects-added", G_CALLBACK (objects_added), &data);
+	g_signal_connect (view, "objects-removed", G_CALLBACK (objects_removed), &data);
+	g_signal_connect (view, "complete", G_CALLBACK (complete), &data);
+
+	e_book_client_view_start (view, &error);
+	if (error)
+		g_error ("start view: %s", error->message);
+
+	g_main_loop_run (fixture->loop);
+
+	g_assert_cmpint (data.n_added, ==, N_CONTACTS);
+
+	/* Narrowing only removes contacts */
+	sexp = query_email_contains (".com");
+	set_query (view, sexp, &data);
+	g_free (sexp);
+
+	g_assert_cmpint (data.n_added, ==, 0);
+	g_assert_cmpint (data.n_removed, ==, N_CONTACTS / 2);
+	g_assert_cmpint (g_hash_table_size (data.uids), ==, N_CONTACTS / 2);
+
+	/* Switching sends both sides of the difference */
+	sexp = query_email_contains (".org");
+	set_query (view, sexp, &data);
+	g_free (sexp);
+
+	g_assert_cmpint (data.n_added, ==, N_CONTACTS / 2);
+	g_assert_cmpint (data.n_removed, ==, N_CONTACTS / 2);
+	g_assert_cmpint (g_hash_table_size (data.uids), ==, N_CONTACTS / 2);
+
+	/* Broadening adds only the contacts which were missing */
+	sexp = query_email_contains ("example");
+	set_query (view, sexp, &data);
+	g_free (sexp);
+
+	g_assert_cmpint (data.n_added, ==, N_CONTACTS / 2);
+	g_assert_cmpint (data.n_removed, ==, 0);
+	g_assert_cmpint (g_hash_table_size (data.uids), ==, N_CONTACTS);
+
+	/* An invalid query is refused and the view keeps the current one */
+	e_book_client_view_set_query (view, "(invalid", &error);
+	g_assert_error (error, E_CLIENT_ERROR, E_CLIENT_ERROR_INVALID_QUERY);
+	g_clear_error (&error);
+
+	e_book_client_view_stop (view, NULL);
+	g_object_unref (view);
+	g_hash_table_destroy (data.uids);
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+	g_test_bug_base ("http://bugzilla.gnome.org/");
+
+	g_test_add (
+		"/EBookClient/View/SetQuery",
+		ETestServerFixture,
+		&book_closure,
+		e_test_server_utils_setup,
+		test_view_set_query,
+		e_test_server_utils_teardown);
+
+	return e_test_server_utils_run ();
+}
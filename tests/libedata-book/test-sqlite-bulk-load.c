@@ -0,0 +1,175 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <locale.h>
+#include <libebook/libebook.h>
+
+#include "data-test-utils.h"
+
+#define N_BULK_CONTACTS 1000
+
+/* Every tenth contact gets a note, which is not a summary field */
+#define NOTE_INTERVAL   10
+
+static void
+add_bulk_contacts (EbSqlFixture *fixture)
+{
+	GSList *contacts = NULL;
+	GError *error = NULL;
+	gint ii;
+
+	/* Binary vCards are opt-in */
+	g_assert (!e_book_sqlite_get_store_bvcards (fixture->ebsql));
+	e_book_sqlite_set_store_bvcards (fixture->ebsql, TRUE);
+
+	for (ii = 0; ii < N_BULK_CONTACTS; ii++) {
+		gchar *case_name = g_strdup_printf ("sorted-%d", (ii % N_SORTED_CONTACTS) + 1);
+		gchar *uid = g_strdup_printf ("bulk-%d", ii);
+		EContact *contact;
+
+		contact = new_contact_from_test_case (case_name);
+		e_contact_set (contact, E_CONTACT_UID, uid);
+
+		if (ii % NOTE_INTERVAL == 0) {
+			gchar *note = g_strdup_printf ("Bulk note, number %d", ii);
+
+			e_contact_set (contact, E_CONTACT_NOTE, note);
+			g_free (note);
+		}
+
+		contacts = g_slist_prepend (contacts, contact);
+
+		g_free (case_name);
+		g_free (uid);
+	}
+
+	if (!e_book_sqlite_add_contacts (fixture->ebsql, contacts, NULL, FALSE, NULL, &error))
+		g_error ("Failed to add contacts: %s", error->message);
+
+	g_slist_free_full (contacts, g_object_unref);
+}
+
+static void
+test_bulk_load (EbSqlFixture *fixture,
+                gconstpointer user_data)
+{
+	GSList *results = NULL;
+	GError *error = NULL;
+	gint64 start, binary_time, text_time;
+	gint ii;
+
+	add_bulk_contacts (fixture);
+
+	/* Contacts built from the stored binary form must be
+	 * exactly the ones parsed from the vCard text */
+	for (ii = 0; ii < N_BULK_CONTACTS; ii += 7) {
+		gchar *uid = g_strdup_printf ("bulk-%d", ii);
+		EContact *contact = NULL;
+		EContact *parsed;
+		gchar *vcard = NULL, *str1, *str2;
+
+		if (!e_book_sqlite_get_contact (fixture->ebsql, uid, FALSE, &contact, &error))
+			g_error ("Failed to get contact '%s': %s", uid, error->message);
+
+		if (!e_book_sqlite_get_vcard (fixture->ebsql, uid, FALSE, &vcard, &error))
+			g_error ("Failed to get vcard '%s': %s", uid, error->message);
+
+		parsed = e_contact_new_from_vcard (vcard);
+
+		str1 = e_vcard_to_string (E_VCARD (contact), EVC_FORMAT_VCARD_30);
+		str2 = e_vcard_to_string (E_VCARD (parsed), EVC_FORMAT_VCARD_30);
+		g_assert_cmpstr (str1, ==, str2);
+
+		g_free (str1);
+		g_free (str2);
+		g_free (vcard);
+		g_free (uid);
+		g_object_unref (contact);
+		g_object_unref (parsed);
+	}
+
+	/* A query on a field which is not in the summary */
+	if (!e_book_sqlite_search (fixture->ebsql, "(contains \"note\" \"bulk note\")",
+				   TRUE, &results, NULL, &error))
+		g_error ("Failed to search: %s", error->message);
+
+	g_assert_cmpint (g_slist_length (results), ==, N_BULK_CONTACTS / NOTE_INTERVAL);
+	g_slist_free_full (results, (GDestroyNotify) e_book_sqlite_search_data_free);
+
+	if (!g_test_perf ())
+		return;
+
+	start = g_get_monotonic_time ();
+	for (ii = 0; ii < N_BULK_CONTACTS; ii++) {
+		gchar *uid = g_strdup_printf ("bulk-%d", ii);
+		EContact *contact = NULL;
+
+		if (!e_book_sqlite_get_contact (fixture->ebsql, uid, FALSE, &contact, &error))
+			g_error ("Failed to get contact '%s': %s", uid, error->message);
+
+		g_assert (e_contact_get_const (contact, E_CONTACT_FAMILY_NAME) != NULL);
+
+		g_object_unref (contact);
+		g_free (uid);
+	}
+	binary_time = g_get_monotonic_time () - start;
+
+	start = g_get_monotonic_time ();
+	for (ii = 0; ii < N_BULK_CONTACTS; ii++) {
+		gchar *uid = g_strdup_printf ("bulk-%d", ii);
+		gchar *vcard = NULL;
+		EContact *contact;
+
+		if (!e_book_sqlite_get_vcard (fixture->ebsql, uid, FALSE, &vcard, &error))
+			g_error ("Failed to get vcard '%s': %s", uid, error->message);
+
+		contact = e_contact_new_from_vcard_with_uid (vcard, uid);
+		g_assert (e_contact_get_const (contact, E_CONTACT_FAMILY_NAME) != NULL);
+
+		g_object_unref (contact);
+		g_free (vcard);
+		g_free (uid);
+	}
+	text_time = g_get_monotonic_time () - start;
+
+	g_test_message (
+		"Loaded %d contacts: %" G_GINT64_FORMAT " us from binary vCards, "
+		"%" G_GINT64_FORMAT " us from vCard text",
+		N_BULK_CONTACTS, binary_time, text_time);
+}
+
+static EbSqlClosure closure = { FALSE, NULL };
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+#if !GLIB_CHECK_VERSION (2, 35, 1)
+	g_type_init ();
+#endif
+	g_test_init (&argc, &argv, NULL);
+
+	/* Ensure that the client and server get the same locale */
+	g_assert (g_setenv ("LC_ALL", "en_US.UTF-8", TRUE));
+	setlocale (LC_ALL, "");
+
+	g_test_add (
+		"/EBookSqlite/DefaultSummary/StoreVCards/BulkLoad", EbSqlFixture, &closure,
+		e_sqlite_fixture_setup, test_bulk_load, e_sqlite_fixture_teardown);
+
+	return g_test_run ();
+}
@@ -286,6 +286,95 @@ test_cursor_calculate_after_modification (EbSqlCursorFixture *fixture,
 	g_assert_cmpint (total, ==, 20);
 }
 
+static void
+test_cursor_calculate_cached_counts (EbSqlCursorFixture *fixture,
+                                     gconstpointer user_data)
+{
+	EBookSqlite *ebsql = ((EbSqlFixture *) fixture)->ebsql;
+	EContactField sort_fields[] = { E_CONTACT_FAMILY_NAME, E_CONTACT_GIVEN_NAME };
+	EBookCursorSortType sort_types[] = { E_BOOK_CURSOR_SORT_ASCENDING, E_BOOK_CURSOR_SORT_ASCENDING };
+	EbSqlCursor *cursor;
+	EContact *contact;
+	GSList *contacts = NULL;
+	GError *error = NULL;
+	gint    position = 0, total = 0;
+
+	/* Set the cursor at the start of family names beginning with 'C' */
+	e_book_sqlite_cursor_set_target_alphabetic_index (ebsql, fixture->cursor, 3);
+
+	if (!e_book_sqlite_cursor_calculate (ebsql, fixture->cursor, &total, &position, NULL, &error))
+		g_error ("Error calculating cursor: %s", error->message);
+
+	g_assert_cmpint (position, ==, 13);
+	g_assert_cmpint (total, ==, 20);
+
+	/* Remove Muffler, which sorts after 'C' */
+	if (!e_book_sqlite_remove_contact (ebsql,
+					   e_contact_get_const (fixture->contacts[19 - 1], E_CONTACT_UID),
+					   NULL, &error))
+		g_error ("Failed to remove contact: %s", error->message);
+
+	if (!e_book_sqlite_cursor_calculate (ebsql, fixture->cursor, &total, &position, NULL, &error))
+		g_error ("Error calculating cursor: %s", error->message);
+
+	g_assert_cmpint (position, ==, 13);
+	g_assert_cmpint (total, ==, 19);
+
+	/* Rename Müller -> Sade Adu, which moves it before 'C' */
+	e_contact_set (fixture->contacts[20 - 1], E_CONTACT_FAMILY_NAME, "Adu");
+	e_contact_set (fixture->contacts[20 - 1], E_CONTACT_GIVEN_NAME, "Sade");
+	if (!e_book_sqlite_add_contact (ebsql,
+					fixture->contacts[20 - 1],
+					e_contact_get_const (fixture->contacts[20 - 1], E_CONTACT_UID),
+					TRUE, NULL, &error))
+		g_error ("Failed to modify contact: %s", error->message);
+
+	/* Add Muffler back */
+	if (!e_book_sqlite_add_contact (ebsql, fixture->contacts[19 - 1], NULL, FALSE, NULL, &error))
+		g_error ("Failed to add contact: %s", error->message);
+
+	if (!e_book_sqlite_cursor_calculate (ebsql, fixture->cursor, &total, &position, NULL, &error))
+		g_error ("Error calculating cursor: %s", error->message);
+
+	g_assert_cmpint (position, ==, 14);
+	g_assert_cmpint (total, ==, 20);
+
+	/* A failed batch leaves the counts alone */
+	contact = e_contact_new ();
+	e_contact_set (contact, E_CONTACT_UID, "cached-counts-new");
+	e_contact_set (contact, E_CONTACT_FAMILY_NAME, "Aardvark");
+	contacts = g_slist_append (contacts, contact);
+	contacts = g_slist_append (contacts, fixture->contacts[0]);
+
+	g_assert (!e_book_sqlite_add_contacts (ebsql, contacts, NULL, FALSE, NULL, &error));
+	g_assert_error (error, E_BOOK_SQLITE_ERROR, E_BOOK_SQLITE_ERROR_CONSTRAINT);
+	g_clear_error (&error);
+
+	g_slist_free (contacts);
+	g_object_unref (contact);
+
+	if (!e_book_sqlite_cursor_calculate (ebsql, fixture->cursor, &total, &position, NULL, &error))
+		g_error ("Error calculating cursor: %s", error->message);
+
+	g_assert_cmpint (position, ==, 14);
+	g_assert_cmpint (total, ==, 20);
+
+	/* A new cursor counts from scratch and must agree */
+	cursor = e_book_sqlite_cursor_new (ebsql, NULL, sort_fields, sort_types, 2, &error);
+	if (!cursor)
+		g_error ("Failed to create cursor: %s", error->message);
+
+	e_book_sqlite_cursor_set_target_alphabetic_index (ebsql, cursor, 3);
+
+	if (!e_book_sqlite_cursor_calculate (ebsql, cursor, &total, &position, NULL, &error))
+		g_error ("Error calculating cursor: %s", error->message);
+
+	g_assert_cmpint (position, ==, 14);
+	g_assert_cmpint (total, ==, 20);
+
+	e_book_sqlite_cursor_free (ebsql, cursor);
+}
+
 static void
 test_cursor_calculate_filtered_initial (EbSqlCursorFixture *fixture,
                                         gconstpointer user_data)
@@ -642,6 +731,11 @@ main (gint argc,
 		e_sqlite_cursor_fixture_setup,
 		test_cursor_calculate_after_modification,
 		e_sqlite_cursor_fixture_teardown);
+	g_test_add (
+		"/EbSqlCursor/Calculate/CachedCounts", EbSqlCursorFixture, &ascending_closure,
+		e_sqlite_cursor_fixture_setup,
+		test_cursor_calculate_cached_counts,
+		e_sqlite_cursor_fixture_teardown);
 
 	g_test_add (
 		"/EbSqlCursor/Calculate/Filtered/Initial", EbSqlCursorFixture, &ascending_closure,
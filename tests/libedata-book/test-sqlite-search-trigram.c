@@ -0,0 +1,185 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <locale.h>
+#include <libebook/libebook.h>
+
+#include "data-test-utils.h"
+
+static const gchar *queries[] = {
+	"(contains \"email\" \"jackson\")",
+	"(contains \"email\" \"ony.c\")",
+	"(contains \"email\" \"pink@pony.com\")",
+	"(contains \"email\" \"ja\")",
+	"(contains \"email\" \"zzz\")",
+	"(endswith \"email\" \"pony.org\")",
+	"(contains \"family_name\" \"bäd\")",
+	"(contains \"family_name\" \"BAD\")",
+	"(endswith \"family_name\" \"ad\")",
+	"(and (contains \"email\" \"brown\") (contains \"family_name\" \"bad\"))",
+	"(or (contains \"email\" \"@jackson\") (endswith \"email\" \"pony.net\"))"
+};
+
+static ESourceBackendSummarySetup *
+setup_trigram_book (void)
+{
+	ESourceBackendSummarySetup *setup;
+	ESource *scratch;
+	GError *error = NULL;
+
+	scratch = e_source_new_with_uid ("test-source", NULL, &error);
+	if (!scratch)
+		g_error ("Error creating scratch source");
+
+	setup = g_object_new (E_TYPE_SOURCE_BACKEND_SUMMARY_SETUP, "source", scratch, NULL);
+	e_source_backend_summary_setup_set_summary_fields (
+		setup,
+		E_CONTACT_FAMILY_NAME,
+		E_CONTACT_EMAIL,
+		0);
+	e_source_backend_summary_setup_set_indexed_fields (
+		setup,
+		E_CONTACT_FAMILY_NAME, E_BOOK_INDEX_TRIGRAM,
+		E_CONTACT_EMAIL, E_BOOK_INDEX_TRIGRAM,
+		0);
+
+	g_object_unref (scratch);
+
+	return setup;
+}
+
+/* Compares the search results with what EBookBackendSExp matches */
+static void
+assert_search_matches (EbSqlFixture *fixture,
+                       const gchar *query)
+{
+	EBookBackendSExp *sexp;
+	GHashTableIter iter;
+	GHashTable *found;
+	GSList *results = NULL, *l;
+	gpointer value;
+	gint n_expected = 0;
+	GError *error = NULL;
+
+	if (!e_book_sqlite_search (fixture->ebsql, query, TRUE, &results, NULL, &error))
+		g_error ("Failed to search with '%s': %s", query, error->message);
+
+	found = g_hash_table_new (g_str_hash, g_str_equal);
+	for (l = results; l; l = l->next) {
+		EbSqlSearchData *data = l->data;
+
+		g_hash_table_add (found, data->uid);
+	}
+
+	g_assert_cmpint (g_hash_table_size (found), ==, g_slist_length (results));
+
+	sexp = e_book_backend_sexp_new (query);
+	g_assert (sexp != NULL);
+
+	g_hash_table_iter_init (&iter, fixture->contacts);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		EContact *contact = value;
+		const gchar *uid = e_contact_get_const (contact, E_CONTACT_UID);
+
+		if (e_book_backend_sexp_match_contact (sexp, contact)) {
+			if (!g_hash_table_contains (found, uid))
+				g_error ("Query '%s' missed contact '%s'", query, uid);
+			n_expected++;
+		} else if (g_hash_table_contains (found, uid)) {
+			g_error ("Query '%s' wrongly matched contact '%s'", query, uid);
+		}
+	}
+
+	g_assert_cmpint (n_expected, ==, g_slist_length (results));
+
+	g_object_unref (sexp);
+	g_hash_table_destroy (found);
+	g_slist_free_full (results, (GDestroyNotify) e_book_sqlite_search_data_free);
+}
+
+static void
+test_search_trigram (EbSqlFixture *fixture,
+                     gconstpointer user_data)
+{
+	EContact *contact = NULL;
+	GError *error = NULL;
+	gint ii;
+
+	for (ii = 1; ii <= N_SORTED_CONTACTS; ii++) {
+		gchar *case_name = g_strdup_printf ("sorted-%d", ii);
+
+		add_contact_from_test_case (fixture, case_name, NULL);
+		g_free (case_name);
+	}
+
+	for (ii = 0; ii < G_N_ELEMENTS (queries); ii++)
+		assert_search_matches (fixture, queries[ii]);
+
+	/* Replacing a contact must drop the trigrams of its old values */
+	contact = new_contact_from_test_case ("sorted-1");
+	e_contact_set (contact, E_CONTACT_EMAIL_1, "someone@elsewhere.org");
+
+	if (!e_book_sqlite_add_contact (fixture->ebsql, contact, "sorted-1", TRUE, NULL, &error))
+		g_error ("Failed to replace contact: %s", error->message);
+
+	g_hash_table_insert (fixture->contacts, g_strdup ("sorted-1"), contact);
+
+	assert_search_matches (fixture, "(contains \"email\" \"jackson\")");
+	assert_search_matches (fixture, "(contains \"email\" \"elsewhere\")");
+
+	/* Removing one must drop all of them */
+	if (!e_book_sqlite_remove_contact (fixture->ebsql, "sorted-2", NULL, &error))
+		g_error ("Failed to remove contact: %s", error->message);
+
+	g_hash_table_remove (fixture->contacts, "sorted-2");
+
+	for (ii = 0; ii < G_N_ELEMENTS (queries); ii++)
+		assert_search_matches (fixture, queries[ii]);
+}
+
+static EbSqlClosure closures[] = {
+	{ FALSE, setup_trigram_book },
+	{ TRUE, setup_trigram_book }
+};
+
+static const gchar *paths[] = {
+	"/EBookSqlite/TrigramSummary/StoreVCards/Search",
+	"/EBookSqlite/TrigramSummary/NoVCards/Search"
+};
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	gint i;
+
+#if !GLIB_CHECK_VERSION (2, 35, 1)
+	g_type_init ();
+#endif
+	g_test_init (&argc, &argv, NULL);
+
+	/* Ensure that the client and server get the same locale */
+	g_assert (g_setenv ("LC_ALL", "en_US.UTF-8", TRUE));
+	setlocale (LC_ALL, "");
+
+	for (i = 0; i < G_N_ELEMENTS (closures); i++)
+		g_test_add (
+			paths[i], EbSqlFixture, &closures[i],
+			e_sqlite_fixture_setup, test_search_trigram, e_sqlite_fixture_teardown);
+
+	return g_test_run ();
+}